@@ -86,6 +86,10 @@ GLAPI int gladLoadGL(void);
 
 GLAPI int gladLoadGLLoader(GLADloadproc);
 
+/* Loads glGetString and fills in GLVersion and the GLAD_GL_VERSION_* flags, but no other
+ * entry point. For loaders that resolve the rest themselves. */
+GLAPI int gladLoadGLVersion(GLADloadproc);
+
 #include <KHR/khrplatform.h>
 typedef unsigned int GLenum;
 typedef unsigned char GLboolean;
@@ -0,0 +1,1199 @@
+#pragma once
+
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <glad/glad.h>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "block_compression.h"
+#include "decode_arena.h"
+#include "gl_calls.h"
+#include "gl_extensions.h"
+#include "gl_loader.h"
+#include "mapped_file.h"
+#include "mip_chain.h"
+#include "profiler.h"
+#include "shader_program.h"
+#include "stb_image.h"
+#include "texture_atlas.h"
+#include "texture_loader.h"
+#include "uniform_block.h"
+
+// Micro benchmarks that need a live GL context. They are only compiled into main() when
+// LEARN_OPENGL_BENCHMARKS is defined.
+namespace benchmarks {
+    // Runs `body` `iterations` times and prints the rate in operations per second.
+    template <typename Body>
+    auto measure(const std::string& label, const uint64_t iterations, Body&& body) -> double {
+        glFinish();
+        const auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < iterations; ++i) {
+            body(i);
+        }
+        glFinish();
+        const auto end = std::chrono::steady_clock::now();
+
+        const auto seconds = std::chrono::duration<double>(end - start).count();
+        const auto per_second = static_cast<double>(iterations) / seconds;
+        std::cout << "BENCH: " << label << ": " << per_second << " ops/s (" << iterations
+            << " in " << seconds * 1000.0 << " ms)" << '\n';
+        return per_second;
+    }
+
+    namespace detail {
+        constexpr auto uniform_sets_vertex_shader = R"(#version 330 core
+uniform int texture2;
+
+void main() {
+    gl_Position = vec4(float(texture2));
+}
+)";
+    } // namespace detail
+
+    // On a scratch program of its own, so the scene's uniform table and stats stay untouched.
+    inline auto uniform_sets() -> void {
+        using namespace shader_program::literals;
+
+        constexpr uint64_t iterations = 1000000;
+        const std::string name = "texture2";
+
+        const auto scratch =
+            shader_program::builder::ProgramBuilder {}
+            .add_shader_source(
+                GL_VERTEX_SHADER,
+                detail::uniform_sets_vertex_shader
+            )->try_build();
+        if (!scratch.has_value()) {
+            return;
+        }
+        const auto& program = *scratch;
+        program.use();
+
+        const auto before = measure("uniform set by string lookup", iterations, [&](uint64_t i) {
+            glUniform1i(
+                glGetUniformLocation(program.id(), name.c_str()),
+                static_cast<GLint>(i & 1U)
+            );
+        });
+        const auto hashed = measure("uniform set by hashed name", iterations, [&](uint64_t i) {
+            program.set_int("texture2"_uniform, static_cast<int>(i & 1U));
+            program.flush();
+        });
+        const auto handle = program.uniform("texture2"_uniform);
+        const auto resolved = measure("uniform set by handle", iterations, [&](uint64_t i) {
+            program.set_int(handle, static_cast<int>(i & 1U));
+            program.flush();
+        });
+        const auto unchanged = measure(
+            "unchanged uniform set by handle",
+            iterations,
+            [&](uint64_t) {
+                program.set_int(handle, 1);
+                program.flush();
+            }
+        );
+
+        std::cout << "BENCH: hashed name speedup " << hashed / before << "x, handle speedup "
+            << resolved / before << "x, unchanged value speedup " << unchanged / before << "x"
+            << '\n';
+
+        glDeleteProgram(program.id());
+    }
+
+    namespace detail {
+        constexpr auto uniform_values_vertex_shader = R"(#version 330 core
+uniform float value;
+
+layout (std140) uniform Frame {
+    mat4 view;
+    vec4 tint;
+    float time;
+};
+
+void main() {
+    gl_Position = view * vec4(value * time) + tint;
+}
+)";
+
+        struct Frame {
+            uniform_block::mat4 view;
+            uniform_block::vec4 tint;
+            float time;
+        };
+        static_assert(uniform_block::matches<Frame>(
+            uniform_block::Rules::std140,
+            {
+                UNIFORM_BLOCK_MEMBER(Frame, view),
+                UNIFORM_BLOCK_MEMBER(Frame, tint),
+                UNIFORM_BLOCK_MEMBER(Frame, time),
+            }
+        ));
+
+        // padded elements have the std140 array stride, never the 4 byte std430 one
+        struct Weights {
+            std::array<uniform_block::padded<float>, 4> weights;
+        };
+        static_assert(uniform_block::matches<Weights>(
+            uniform_block::Rules::std140,
+            { UNIFORM_BLOCK_MEMBER(Weights, weights) }
+        ));
+        static_assert(!uniform_block::matches<Weights>(
+            uniform_block::Rules::std430,
+            { UNIFORM_BLOCK_MEMBER(Weights, weights) }
+        ));
+
+        template <size_t ValueCount>
+        auto uniform_values(const shader_program::ShaderProgram& program) -> void {
+            using Values = std::array<uniform_block::vec4, ValueCount / 4>;
+            constexpr uint64_t frames = 100;
+
+            const auto location = program.uniform(shader_program::uniform_name("value"));
+            const auto per_uniform = measure(
+                "set " + std::to_string(ValueCount) + " values per frame, one glUniform1f each",
+                frames,
+                [&](uint64_t frame) {
+                    // straight to the driver, the shadow copy would collapse these into one call
+                    for (size_t i = 0; i < ValueCount; ++i) {
+                        glUniform1f(location.location, static_cast<float>(frame + i));
+                    }
+                }
+            );
+
+            const auto values = std::make_unique<Values>();
+            const uniform_block::UniformBuffer<Values> buffer { 1 };
+            const auto block = measure(
+                "set " + std::to_string(ValueCount) + " values per frame, one block upload",
+                frames,
+                [&](uint64_t frame) {
+                    (*values)[frame % values->size()].x = static_cast<float>(frame);
+                    buffer.upload(*values);
+                }
+            );
+
+            std::cout << "BENCH: block upload speedup at " << ValueCount << " values: "
+                << block / per_uniform << "x" << '\n';
+        }
+
+        // Read syscalls the process made so far, 0 where /proc/self/io does not exist.
+        inline auto read_syscalls() -> uint64_t {
+            std::ifstream io { "/proc/self/io" };
+            std::string key;
+            uint64_t value = 0;
+            while (io >> key >> value) {
+                if (key == "syscr:") {
+                    return value;
+                }
+            }
+            return 0;
+        }
+
+        // Runs measure() over `paths` round robin, then prints the read syscalls per image and
+        // the file bytes per second. Reading /proc/self/io adds a few syscalls of its own.
+        template <typename Load>
+        auto ingestion(
+            const std::string& label,
+            const std::vector<std::string>& paths,
+            const std::vector<size_t>& sizes,
+            const uint64_t iterations,
+            Load&& load
+        ) -> void {
+            size_t bytes = 0;
+            for (const auto size : sizes) {
+                bytes += size;
+            }
+            const auto images = iterations * paths.size();
+            const auto syscalls_before = read_syscalls();
+            const auto per_second = measure(label, images, [&](uint64_t i) {
+                stbi_image_free(load(paths[i % paths.size()]));
+            });
+            const auto syscalls = read_syscalls() - syscalls_before;
+            const auto bytes_per_image =
+                static_cast<double>(bytes) / static_cast<double>(paths.size());
+            std::cout << "BENCH: " << label << ": "
+                << static_cast<double>(syscalls) / static_cast<double>(images)
+                << " read syscalls per image, " << per_second * bytes_per_image / 1e6
+                << " MB/s of files" << '\n';
+        }
+    } // namespace detail
+
+    inline auto uniform_blocks() -> void {
+        auto program =
+            shader_program::builder::ProgramBuilder {}
+            .add_shader_source(
+                GL_VERTEX_SHADER,
+                detail::uniform_values_vertex_shader
+            )->try_build();
+        if (!program.has_value()) {
+            return;
+        }
+        program->use();
+
+        const uniform_block::UniformBuffer<detail::Frame> frame { 0 };
+        program->bind_uniform_block("Frame", frame.binding());
+        frame.upload(detail::Frame {});
+
+        detail::uniform_values<1000>(*program);
+        detail::uniform_values<10000>(*program);
+        detail::uniform_values<100000>(*program);
+
+        glDeleteProgram(program->id());
+    }
+
+    // Startup cost of resolving every entry point versus installing trampolines, and of the
+    // extension scan glad used to do versus the hashed lookup. Leaves the lazy loader in place.
+    inline auto loader_startup(const GLADloadproc load) -> void {
+        constexpr uint64_t iterations = 100;
+
+        const auto eager = measure("gladLoadGLLoader", iterations, [&](uint64_t) {
+            gladLoadGLLoader(load);
+        });
+        const auto lazy = measure("gl_loader::load_lazy", iterations, [&](uint64_t) {
+            gl_loader::load_lazy(load);
+        });
+
+        // what glad's get_exts and has_ext did: copy every string, then strcmp through them
+        size_t copied_bytes = 0;
+        const auto copied = measure("extensions copied and searched", iterations, [&](uint64_t) {
+            auto count = 0;
+            glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+            auto** const copies = static_cast<char**>(std::malloc(count * sizeof(char*)));
+            copied_bytes = count * sizeof(char*);
+            for (auto i = 0; i < count; ++i) {
+                const auto* const extension = reinterpret_cast<const char*>(
+                    glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i))
+                );
+                const auto size = std::strlen(extension) + 1;
+                copies[i] = static_cast<char*>(std::malloc(size));
+                std::memcpy(copies[i], extension, size);
+                copied_bytes += size;
+            }
+            for (const auto* const name : gl_extensions::detail::extension_names) {
+                for (auto i = 0; i < count && 0 != std::strcmp(copies[i], name); ++i) {}
+            }
+            for (auto i = 0; i < count; ++i) {
+                std::free(copies[i]);
+            }
+            std::free(copies);
+        });
+        const auto hashed = measure("extensions hashed into a bitset", iterations, [](uint64_t) {
+            gl_extensions::detect();
+        });
+
+        std::cout << "BENCH: loader " << 1e6 / eager << " us eager, " << 1e6 / lazy
+            << " us lazy (" << lazy / eager << "x); extensions " << 1e6 / copied << " us and "
+            << copied_bytes << " bytes copied, " << 1e6 / hashed << " us hashed ("
+            << hashed / copied << "x)" << '\n';
+    }
+
+    // Cost of a cheap driver call with the call counting layer off and on.
+    inline auto gl_call_layer() -> void {
+        constexpr uint64_t iterations = 1000000;
+        const auto was_enabled = gl_calls::enabled();
+        auto value = 0;
+
+        gl_calls::set_enabled(false);
+        const auto direct = measure("glGetIntegerv, call layer off", iterations, [&](uint64_t) {
+            glGetIntegerv(GL_CURRENT_PROGRAM, &value);
+        });
+        gl_calls::set_enabled(true);
+        const auto hooked = measure("glGetIntegerv, call layer on", iterations, [&](uint64_t) {
+            glGetIntegerv(GL_CURRENT_PROGRAM, &value);
+        });
+        gl_calls::set_enabled(was_enabled);
+
+        std::cout << "BENCH: call layer overhead " << (1e9 / hooked - 1e9 / direct)
+            << " ns per call" << '\n';
+    }
+
+    // Cost of one empty zone. Does nothing unless LEARN_OPENGL_PROFILE is defined.
+    inline auto profiler_zones() -> void {
+#ifdef LEARN_OPENGL_PROFILE
+        // stays below the ring size, so every zone is recorded rather than dropped
+        constexpr uint64_t iterations = 8192;
+        const auto per_second = measure("profiler zone", iterations, [](uint64_t) {
+            PROFILE_ZONE("benchmark zone");
+        });
+        std::cout << "BENCH: profiler zone cost " << 1e9 / per_second << " ns" << '\n';
+#endif
+    }
+
+    // Loading whole images through stdio twice (stbi_info, then stbi_load), through one read
+    // into a buffer, and straight from a mapping. Read syscalls come from /proc/self/io, so
+    // they are only counted on Linux.
+    inline auto texture_ingestion(const std::vector<std::string>& paths) -> void {
+        constexpr uint64_t iterations = 20;
+        std::vector<size_t> sizes;
+        for (const auto& path : paths) {
+            const mapped_file::MappedFile file { path };
+            if (file.failed()) {
+                return;
+            }
+            sizes.push_back(file.size());
+        }
+
+        auto width = 0;
+        auto height = 0;
+        auto channels = 0;
+        const auto stdio_twice = [&](const std::string& path) {
+            stbi_info(path.c_str(), &width, &height, &channels);
+            return stbi_load(path.c_str(), &width, &height, &channels, 0);
+        };
+        const auto read_once = [&](const std::string& path) {
+            std::ifstream file { path, std::ios::binary | std::ios::ate };
+            std::vector<stbi_uc> bytes(static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            file.read(
+                reinterpret_cast<char*>(bytes.data()),
+                static_cast<std::streamsize>(bytes.size())
+            );
+            return stbi_load_from_memory(
+                bytes.data(),
+                static_cast<int>(bytes.size()),
+                &width,
+                &height,
+                &channels,
+                0
+            );
+        };
+        const auto mapped = [&](const std::string& path) {
+            const mapped_file::MappedFile file { path };
+            return stbi_load_from_memory(
+                file.data(),
+                static_cast<int>(file.size()),
+                &width,
+                &height,
+                &channels,
+                0
+            );
+        };
+        detail::ingestion("stbi_info + stbi_load", paths, sizes, iterations, stdio_twice);
+        detail::ingestion("ifstream + stbi_load_from_memory", paths, sizes, iterations, read_once);
+        detail::ingestion("mmap + stbi_load_from_memory", paths, sizes, iterations, mapped);
+    }
+
+    // Decoding a mixed corpus the way the texture workers do, with stb_image's allocations
+    // going to the heap, then to a per-thread arena.
+    inline auto arena_decoding(const std::vector<std::string>& paths) -> void {
+        constexpr uint64_t iterations = 20;
+        std::vector<std::unique_ptr<mapped_file::MappedFile>> files;
+        size_t input_bytes = 0;
+        size_t output_size = 0;
+        for (const auto& path : paths) {
+            auto file = std::make_unique<mapped_file::MappedFile>(path);
+            auto width = 0;
+            auto height = 0;
+            auto channels = 0;
+            const auto valid = !file->failed() && 0 != stbi_info_from_memory(
+                file->data(),
+                static_cast<int>(file->size()),
+                &width,
+                &height,
+                &channels
+            );
+            if (!valid) {
+                return;
+            }
+            input_bytes += file->size();
+            output_size = std::max(
+                output_size,
+                static_cast<size_t>(width) * static_cast<size_t>(height)
+                    * static_cast<size_t>(channels) + 1
+            );
+            files.push_back(std::move(file));
+        }
+
+        std::vector<stbi_uc> output(output_size);
+        const auto decode = [&](const uint64_t i) {
+            const auto& file = *files[i % files.size()];
+            auto width = 0;
+            auto height = 0;
+            auto channels = 0;
+            const auto size = static_cast<int>(file.size());
+            stbi_info_from_memory(file.data(), size, &width, &height, &channels);
+            stbi_load_from_memory_into(
+                file.data(),
+                size,
+                &width,
+                &height,
+                &channels,
+                0,
+                output.data(),
+                output.size()
+            );
+        };
+
+        const auto images = iterations * files.size();
+        const auto bytes_per_image =
+            static_cast<double>(input_bytes) / static_cast<double>(files.size());
+        for (const auto arena : { false, true }) {
+            const auto* const label = arena ? "decode with arena" : "decode with malloc";
+            // the first image of each kind grows the arena, steady state is what we are after
+            for (uint64_t i = 0; i < files.size(); ++i) {
+                const decode_arena::Scope scope {};
+                decode(i);
+            }
+            const auto allocations_before = decode_arena::heap_allocations();
+            const auto per_second = measure(label, images, [&](const uint64_t i) {
+                if (arena) {
+                    const decode_arena::Scope scope {};
+                    decode(i);
+                } else {
+                    decode(i);
+                }
+            });
+            const auto allocations = decode_arena::heap_allocations() - allocations_before;
+            std::cout << "BENCH: " << label << ": "
+                << static_cast<double>(allocations) / static_cast<double>(images)
+                << " heap allocations per image, " << per_second * bytes_per_image / 1e6
+                << " MB/s of files" << '\n';
+        }
+    }
+
+    // Decodes the JPEGs in `paths` with each set of kernels stb_image has for this CPU, checking
+    // that they all decode to the same bytes.
+    inline auto jpeg_kernels(const std::vector<std::string>& paths) -> void {
+        constexpr uint64_t iterations = 20;
+        std::vector<std::unique_ptr<mapped_file::MappedFile>> files;
+        for (const auto& path : paths) {
+            auto file = std::make_unique<mapped_file::MappedFile>(path);
+            if (file->failed()) {
+                return;
+            }
+            files.push_back(std::move(file));
+        }
+
+        const auto decode = [&](const uint64_t i) {
+            const auto& file = *files[i % files.size()];
+            auto width = 0;
+            auto height = 0;
+            auto channels = 0;
+            auto* const pixels = stbi_load_from_memory(
+                file.data(),
+                static_cast<int>(file.size()),
+                &width,
+                &height,
+                &channels,
+                0
+            );
+            std::vector<stbi_uc> bytes;
+            if (pixels != nullptr) {
+                bytes.assign(pixels, pixels + static_cast<size_t>(width) * height * channels);
+                stbi_image_free(pixels);
+            }
+            return bytes;
+        };
+
+        stbi_set_jpeg_simd_limit(STBI_simd_256);
+        const auto widest = stbi_jpeg_simd_level();
+        constexpr std::array<const char*, 3> names { "scalar", "SSE2/NEON", "AVX2" };
+        std::vector<std::vector<stbi_uc>> reference;
+        auto scalar_per_second = 0.0;
+        for (auto level = static_cast<int>(STBI_simd_none); level <= widest; ++level) {
+            stbi_set_jpeg_simd_limit(level);
+            auto identical = true;
+            for (uint64_t i = 0; i < files.size(); ++i) {
+                auto bytes = decode(i);
+                if (reference.size() <= i) {
+                    reference.push_back(std::move(bytes));
+                } else {
+                    identical = identical && bytes == reference[i];
+                }
+            }
+            const auto label = std::string { "jpeg decode, " }
+                + names.at(static_cast<size_t>(level)) + " kernels";
+            const auto per_second = measure(label, iterations * files.size(), [&](uint64_t i) {
+                decode(i);
+            });
+            if (level == STBI_simd_none) {
+                scalar_per_second = per_second;
+                continue;
+            }
+            std::cout << "BENCH: " << label << ": " << per_second / scalar_per_second
+                << "x scalar, same bytes: " << (identical ? "yes" : "no") << '\n';
+        }
+        stbi_set_jpeg_simd_limit(STBI_simd_256);
+    }
+
+    // Converts a planar YCbCr frame to RGB and RGBA with each set of kernels stb_image has for
+    // this CPU, for every chroma subsampling its fused upsamplers take, checking that they all
+    // convert to the same bytes.
+    inline auto jpeg_color_kernels() -> void {
+        constexpr uint64_t iterations = 20;
+        constexpr int32_t width = 1024;
+        constexpr int32_t height = 1024;
+        struct Subsampling {
+            const char* name;
+            int32_t hs;
+            int32_t vs;
+        };
+        constexpr std::array<Subsampling, 4> subsamplings {{
+            { "4:4:4", 1, 1 },
+            { "4:2:2", 2, 1 },
+            { "4:4:0", 1, 2 },
+            { "4:2:0", 2, 2 },
+        }};
+        constexpr std::array<const char*, 3> names { "scalar", "SSE2/NEON", "AVX2" };
+
+        // smooth gradients with some noise, like decoded photos
+        uint32_t seed = 1;
+        const auto plane = [&seed](const int32_t plane_width, const int32_t plane_height) {
+            std::vector<stbi_uc> samples(static_cast<size_t>(plane_width) * plane_height);
+            for (int32_t y = 0; y < plane_height; ++y) {
+                for (int32_t x = 0; x < plane_width; ++x) {
+                    seed = seed * 1664525U + 1013904223U;
+                    const auto noise = static_cast<int32_t>(seed >> 28U) - 8;
+                    samples[static_cast<size_t>(y) * plane_width + x] = static_cast<stbi_uc>(
+                        std::clamp((x + y) * 255 / (plane_width + plane_height) + noise, 0, 255)
+                    );
+                }
+            }
+            return samples;
+        };
+        const auto luma = plane(width, height);
+
+        stbi_set_jpeg_simd_limit(STBI_simd_256);
+        const auto widest = stbi_jpeg_simd_level();
+        const auto megapixels = static_cast<double>(width) * height / 1e6;
+        for (const auto& subsampling : subsamplings) {
+            const auto chroma_width = (width + subsampling.hs - 1) / subsampling.hs;
+            const auto chroma_height = (height + subsampling.vs - 1) / subsampling.vs;
+            const auto cb = plane(chroma_width, chroma_height);
+            const auto cr = plane(chroma_width, chroma_height);
+            for (const auto step : { 3, 4 }) {
+                std::vector<stbi_uc> reference;
+                std::vector<stbi_uc> output(static_cast<size_t>(width) * height * step + 1);
+                auto scalar_per_second = 0.0;
+                for (auto level = static_cast<int>(STBI_simd_none); level <= widest; ++level) {
+                    stbi_set_jpeg_simd_limit(level);
+                    const auto convert = [&](uint64_t) {
+                        stbi_jpeg_YCbCr_to_RGB(
+                            output.data(),
+                            luma.data(),
+                            cb.data(),
+                            cr.data(),
+                            width,
+                            height,
+                            subsampling.hs,
+                            subsampling.vs,
+                            step
+                        );
+                    };
+                    convert(0);
+                    const auto identical = reference.empty() || output == reference;
+                    reference = output;
+
+                    const auto label = std::string { "YCbCr " } + subsampling.name + " to "
+                        + (step == 3 ? "RGB" : "RGBA") + ", "
+                        + names.at(static_cast<size_t>(level)) + " kernels";
+                    const auto per_second = measure(label, iterations, convert);
+                    std::cout << "BENCH: " << label << ": " << per_second * megapixels
+                        << " megapixels/s";
+                    if (level == STBI_simd_none) {
+                        scalar_per_second = per_second;
+                    } else {
+                        std::cout << ", " << per_second / scalar_per_second
+                            << "x scalar, same bytes: " << (identical ? "yes" : "no");
+                    }
+                    std::cout << '\n';
+                }
+            }
+        }
+        stbi_set_jpeg_simd_limit(STBI_simd_256);
+    }
+
+    // Decodes the JPEGs in `paths` on the calling thread and with their restart intervals split
+    // across the workers of an idle texture loader, checking that both decode to the same bytes.
+    // Files without restart markers decode on the calling thread either way.
+    inline auto jpeg_restart_intervals(const std::vector<std::string>& paths) -> void {
+        constexpr uint64_t iterations = 20;
+        texture_loader::TextureLoader loader {};
+        for (const auto& path : paths) {
+            const mapped_file::MappedFile file { path };
+            if (file.failed()) {
+                return;
+            }
+            const auto decode = [&file] {
+                auto width = 0;
+                auto height = 0;
+                auto channels = 0;
+                auto* const pixels = stbi_load_from_memory(
+                    file.data(),
+                    static_cast<int>(file.size()),
+                    &width,
+                    &height,
+                    &channels,
+                    0
+                );
+                std::vector<stbi_uc> bytes;
+                if (pixels != nullptr) {
+                    bytes.assign(pixels, pixels + static_cast<size_t>(width) * height * channels);
+                    stbi_image_free(pixels);
+                }
+                return bytes;
+            };
+
+            stbi_set_jpeg_parallel_for(nullptr, nullptr);
+            const auto reference = decode();
+            const auto one_thread = path + " decode, one thread";
+            const auto sequential = measure(one_thread, iterations, [&](uint64_t) {
+                decode();
+            });
+            stbi_set_jpeg_parallel_for(texture_loader::TextureLoader::jpeg_parallel_for, &loader);
+            const auto identical = decode() == reference;
+            const auto label = path + " decode, restart intervals in parallel";
+            const auto parallel = measure(label, iterations, [&](uint64_t) {
+                decode();
+            });
+            std::cout << "BENCH: " << label << ": " << parallel / sequential << "x one thread on "
+                << std::max(std::thread::hardware_concurrency(), 1U)
+                << " hardware threads, same bytes: " << (identical ? "yes" : "no") << '\n';
+            stbi_set_jpeg_parallel_for(nullptr, nullptr);
+        }
+    }
+
+    // Creating a texture with every mip level: decoded RGBA8 pixels and glGenerateMipmap, against
+    // levels encoded ahead of time into each block compressed format the driver takes.
+    inline auto compressed_upload(const std::string& path) -> void {
+        constexpr uint64_t iterations = 20;
+        auto width = 0;
+        auto height = 0;
+        auto channels = 0;
+        auto* const pixels = stbi_load(path.c_str(), &width, &height, &channels, 4);
+        if (pixels == nullptr) {
+            return;
+        }
+        const auto levels = mip_chain::build(mip_chain::Image {
+            static_cast<uint32_t>(width),
+            static_cast<uint32_t>(height),
+            std::vector<uint8_t>(pixels, pixels + static_cast<size_t>(width) * height * 4),
+        });
+        stbi_image_free(pixels);
+
+        const auto upload = [](const std::string& label, const size_t bytes, auto&& create) {
+            const auto per_second = measure(label, iterations, [&](uint64_t) {
+                uint32_t texture = 0;
+                glGenTextures(1, &texture);
+                glBindTexture(GL_TEXTURE_2D, texture);
+                create();
+                // the upload is only done once the driver has the texture where it samples from
+                glFinish();
+                glDeleteTextures(1, &texture);
+            });
+            std::cout << "BENCH: " << label << ": " << bytes << " bytes uploaded, "
+                << static_cast<double>(bytes) * per_second / 1e6 << " MB/s" << '\n';
+        };
+
+        const auto& base = levels.front();
+        const auto decoded_bytes = base.pixels.size();
+        upload("glTexImage2D RGBA8 + glGenerateMipmap", decoded_bytes, [&] {
+            glTexImage2D(
+                GL_TEXTURE_2D,
+                0,
+                GL_RGBA8,
+                static_cast<GLsizei>(base.width),
+                static_cast<GLsizei>(base.height),
+                0,
+                GL_RGBA,
+                GL_UNSIGNED_BYTE,
+                base.pixels.data()
+            );
+            glGenerateMipmap(GL_TEXTURE_2D);
+        });
+
+        for (const auto format : texture_loader::detail::cooked_formats()) {
+            const auto& info = block_compression::info(format);
+            std::vector<std::vector<uint8_t>> encoded;
+            size_t encoded_bytes = 0;
+            const auto start = std::chrono::steady_clock::now();
+            for (const auto& level : levels) {
+                auto& blocks = encoded.emplace_back(
+                    block_compression::encoded_size(format, level.width, level.height)
+                );
+                block_compression::encode(
+                    format,
+                    level.pixels.data(),
+                    level.width,
+                    level.height,
+                    blocks.data()
+                );
+                encoded_bytes += blocks.size();
+            }
+            const std::chrono::duration<double, std::milli> encode_time {
+                std::chrono::steady_clock::now() - start
+            };
+
+            const auto label = std::string { "glCompressedTexImage2D " } + info.name;
+            upload(label, encoded_bytes, [&] {
+                for (size_t i = 0; i < levels.size(); ++i) {
+                    glCompressedTexImage2D(
+                        GL_TEXTURE_2D,
+                        static_cast<GLint>(i),
+                        info.internal_format,
+                        static_cast<GLsizei>(levels[i].width),
+                        static_cast<GLsizei>(levels[i].height),
+                        0,
+                        static_cast<GLsizei>(encoded[i].size()),
+                        encoded[i].data()
+                    );
+                }
+            });
+            std::cout << "BENCH: " << label << ": "
+                << static_cast<double>(decoded_bytes) * 4.0 / 3.0
+                    / static_cast<double>(encoded_bytes)
+                << "x less texture memory than RGBA8, cooked in " << encode_time.count() << " ms"
+                << '\n';
+        }
+    }
+
+    // Building a mip chain: glGenerateMipmap on the GL thread, against the CPU filters the
+    // cooker runs on one thread and on all of them, and uploading the levels they produce.
+    inline auto mip_generation(const std::string& path) -> void {
+        constexpr uint64_t iterations = 20;
+        auto width = 0;
+        auto height = 0;
+        auto channels = 0;
+        auto* const pixels = stbi_load(path.c_str(), &width, &height, &channels, 4);
+        if (pixels == nullptr) {
+            return;
+        }
+        const mip_chain::Image base {
+            static_cast<uint32_t>(width),
+            static_cast<uint32_t>(height),
+            std::vector<uint8_t>(pixels, pixels + static_cast<size_t>(width) * height * 4),
+        };
+        stbi_image_free(pixels);
+        const auto megapixels = static_cast<double>(width) * height / 1e6;
+
+        measure("glTexImage2D RGBA8 + glGenerateMipmap", iterations, [&](uint64_t) {
+            uint32_t texture = 0;
+            glGenTextures(1, &texture);
+            glBindTexture(GL_TEXTURE_2D, texture);
+            glTexImage2D(
+                GL_TEXTURE_2D,
+                0,
+                GL_RGBA8,
+                width,
+                height,
+                0,
+                GL_RGBA,
+                GL_UNSIGNED_BYTE,
+                base.pixels.data()
+            );
+            glGenerateMipmap(GL_TEXTURE_2D);
+            glFinish();
+            glDeleteTextures(1, &texture);
+        });
+
+        const auto hardware_threads = std::max(std::thread::hardware_concurrency(), 1U);
+        auto thread_counts = std::vector { 1U };
+        if (hardware_threads > 1) {
+            thread_counts.push_back(hardware_threads);
+        }
+        std::vector<mip_chain::Image> levels;
+        for (const auto filter : { mip_chain::Filter::box, mip_chain::Filter::kaiser }) {
+            std::vector<uint8_t> first_bytes;
+            auto identical = true;
+            for (const auto threads : thread_counts) {
+                const mip_chain::Options options { filter, true, threads };
+                const auto label = std::string { "mip_chain::build " }
+                    + (filter == mip_chain::Filter::box ? "box" : "kaiser") + ", "
+                    + std::to_string(threads) + " threads";
+                const auto per_second = measure(label, iterations, [&](uint64_t) {
+                    levels = mip_chain::build(base, options);
+                });
+                std::cout << "BENCH: " << label << ": " << per_second * megapixels
+                    << " megapixels/s of base level" << '\n';
+
+                std::vector<uint8_t> bytes;
+                for (const auto& level : levels) {
+                    bytes.insert(bytes.end(), level.pixels.begin(), level.pixels.end());
+                }
+                identical = identical && (first_bytes.empty() || bytes == first_bytes);
+                first_bytes = std::move(bytes);
+            }
+            if (hardware_threads > 1) {
+                std::cout << "BENCH: mip_chain::build: same bytes on 1 and " << hardware_threads
+                    << " threads: " << (identical ? "yes" : "no") << '\n';
+            }
+        }
+
+        // what the loader does with an rgba8 cooked file
+        const auto& extensions = gl_extensions::get();
+        const auto* const label = extensions.texture_storage
+            ? "glTexStorage2D + glTexSubImage2D per level"
+            : "glTexImage2D per level";
+        measure(label, iterations, [&](uint64_t) {
+            uint32_t texture = 0;
+            glGenTextures(1, &texture);
+            glBindTexture(GL_TEXTURE_2D, texture);
+            if (extensions.texture_storage) {
+                extensions.glTexStorage2D(
+                    GL_TEXTURE_2D,
+                    static_cast<GLsizei>(levels.size()),
+                    GL_RGBA8,
+                    width,
+                    height
+                );
+            }
+            for (size_t i = 0; i < levels.size(); ++i) {
+                const auto& level = levels[i];
+                if (extensions.texture_storage) {
+                    glTexSubImage2D(
+                        GL_TEXTURE_2D,
+                        static_cast<GLint>(i),
+                        0,
+                        0,
+                        static_cast<GLsizei>(level.width),
+                        static_cast<GLsizei>(level.height),
+                        GL_RGBA,
+                        GL_UNSIGNED_BYTE,
+                        level.pixels.data()
+                    );
+                } else {
+                    glTexImage2D(
+                        GL_TEXTURE_2D,
+                        static_cast<GLint>(i),
+                        GL_RGBA8,
+                        static_cast<GLsizei>(level.width),
+                        static_cast<GLsizei>(level.height),
+                        0,
+                        GL_RGBA,
+                        GL_UNSIGNED_BYTE,
+                        level.pixels.data()
+                    );
+                }
+            }
+            glFinish();
+            glDeleteTextures(1, &texture);
+        });
+    }
+
+    namespace detail {
+        constexpr auto sprite_vertex_shader = R"(#version 330 core
+layout (location = 0) in vec2 aCorner;
+// x, y, width, height in clip space
+layout (location = 1) in vec4 aRect;
+// left, bottom, right, top
+layout (location = 2) in vec4 aUv;
+layout (location = 3) in float aLayer;
+
+out vec3 TexCoord;
+
+void main() {
+    gl_Position = vec4(aRect.xy + aCorner * aRect.zw, 0.0, 1.0);
+    TexCoord = vec3(mix(aUv.xy, aUv.zw, aCorner), aLayer);
+}
+)";
+
+        constexpr auto sprite_fragment_shader = R"(#version 330 core
+out vec4 FragColor;
+
+in vec3 TexCoord;
+
+uniform sampler2D sprite;
+
+void main() {
+    FragColor = texture(sprite, TexCoord.xy);
+}
+)";
+
+        constexpr auto sprite_array_fragment_shader = R"(#version 330 core
+out vec4 FragColor;
+
+in vec3 TexCoord;
+
+uniform sampler2DArray sprites;
+
+void main() {
+    FragColor = texture(sprites, TexCoord);
+}
+)";
+
+        // What the instanced draws read per sprite.
+        struct SpriteInstance {
+            std::array<float, 4> rect;
+            std::array<float, 4> uv;
+            float layer;
+        };
+
+        // Points attributes 1 to 3 at the instances from `first` on, in the bound array buffer.
+        inline auto sprite_instances(const size_t first) -> void {
+            constexpr auto stride = static_cast<GLsizei>(sizeof(SpriteInstance));
+            const auto offset = first * sizeof(SpriteInstance);
+            glVertexAttribPointer(
+                1,
+                4,
+                GL_FLOAT,
+                GL_FALSE,
+                stride,
+                reinterpret_cast<void*>(offset + offsetof(SpriteInstance, rect))
+            );
+            glVertexAttribPointer(
+                2,
+                4,
+                GL_FLOAT,
+                GL_FALSE,
+                stride,
+                reinterpret_cast<void*>(offset + offsetof(SpriteInstance, uv))
+            );
+            glVertexAttribPointer(
+                3,
+                1,
+                GL_FLOAT,
+                GL_FALSE,
+                stride,
+                reinterpret_cast<void*>(offset + offsetof(SpriteInstance, layer))
+            );
+        }
+    } // namespace detail
+
+    // Drawing sprites that each use one of 64 textures of four sizes: a bind and a draw per
+    // sprite, one instanced draw per array once same sized textures are layers of an array,
+    // and one instanced draw for all of them once they are packed into an atlas.
+    inline auto sprite_draws() -> void {
+        constexpr uint64_t iterations = 10;
+        constexpr uint32_t texture_count = 64;
+        constexpr std::array<uint32_t, 4> sizes { 16, 32, 48, 64 };
+
+        using shader_program::builder::ProgramBuilder;
+        auto program = ProgramBuilder {}
+            .add_shader_source(GL_VERTEX_SHADER, detail::sprite_vertex_shader)
+            ->add_shader_source(GL_FRAGMENT_SHADER, detail::sprite_fragment_shader)
+            ->try_build();
+        auto array_program = ProgramBuilder {}
+            .add_shader_source(GL_VERTEX_SHADER, detail::sprite_vertex_shader)
+            ->add_shader_source(GL_FRAGMENT_SHADER, detail::sprite_array_fragment_shader)
+            ->try_build();
+        if (!program.has_value() || !array_program.has_value()) {
+            return;
+        }
+
+        std::vector<mip_chain::Image> images;
+        std::vector<uint32_t> textures(texture_count);
+        glGenTextures(texture_count, textures.data());
+        for (uint32_t i = 0; i < texture_count; ++i) {
+            const auto size = sizes[i % sizes.size()];
+            auto& image = images.emplace_back(
+                mip_chain::Image { size, size, std::vector<uint8_t>(size * size * 4) }
+            );
+            for (uint32_t y = 0; y < size; ++y) {
+                for (uint32_t x = 0; x < size; ++x) {
+                    auto* const texel = &image.pixels[(y * size + x) * 4];
+                    texel[0] = static_cast<uint8_t>(x * 255 / size);
+                    texel[1] = static_cast<uint8_t>(y * 255 / size);
+                    texel[2] = static_cast<uint8_t>(i * 37);
+                    texel[3] = 255;
+                }
+            }
+            glBindTexture(GL_TEXTURE_2D, textures[i]);
+            glTexImage2D(
+                GL_TEXTURE_2D,
+                0,
+                GL_RGBA8,
+                static_cast<GLsizei>(size),
+                static_cast<GLsizei>(size),
+                0,
+                GL_RGBA,
+                GL_UNSIGNED_BYTE,
+                image.pixels.data()
+            );
+            glGenerateMipmap(GL_TEXTURE_2D);
+        }
+
+        // the samplers read unit 0
+        glActiveTexture(GL_TEXTURE0);
+        const texture_atlas::LayerPacking layers { textures };
+        texture_atlas::Atlas atlas { 512, 4, 4 };
+        std::vector<texture_atlas::Region> regions;
+        for (const auto& image : images) {
+            const auto region = atlas.add(image);
+            if (!region.has_value()) {
+                break;
+            }
+            regions.push_back(*region);
+        }
+        const auto release = [&] {
+            glDeleteTextures(texture_count, textures.data());
+            glDeleteProgram(program->id());
+            glDeleteProgram(array_program->id());
+        };
+        if (regions.size() != images.size()) {
+            release();
+            return;
+        }
+        std::cout << "BENCH: sprite atlas: " << texture_count << " textures in "
+            << layers.arrays().size() << " arrays, or " << atlas.pages()
+            << " atlas pages " << atlas.coverage() * 100.0 << "% covered" << '\n';
+
+        uint32_t vao = 0;
+        std::array<uint32_t, 2> buffers {};
+        glGenVertexArrays(1, &vao);
+        glGenBuffers(static_cast<GLsizei>(buffers.size()), buffers.data());
+        glBindVertexArray(vao);
+        constexpr std::array<float, 8> corners { 0.0F, 0.0F, 1.0F, 0.0F, 0.0F, 1.0F, 1.0F, 1.0F };
+        glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners.data(), GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+        glEnableVertexAttribArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, buffers[1]);
+        for (uint32_t attribute = 1; attribute <= 3; ++attribute) {
+            glVertexAttribDivisor(attribute, 1);
+        }
+        glDisable(GL_BLEND);
+
+        for (const uint32_t sprites : { 256U, 4096U, 16384U }) {
+            // a grid over the whole viewport
+            const auto columns = static_cast<uint32_t>(std::ceil(std::sqrt(sprites)));
+            const auto cell = 2.0F / static_cast<float>(columns);
+            const auto rect = [&](const uint32_t sprite) -> std::array<float, 4> {
+                return {
+                    -1.0F + static_cast<float>(sprite % columns) * cell,
+                    -1.0F + static_cast<float>(sprite / columns) * cell,
+                    cell,
+                    cell,
+                };
+            };
+            const auto report = [sprites](
+                const std::string& label,
+                const double per_second,
+                const size_t draws
+            ) {
+                std::cout << "BENCH: " << label << ": " << per_second * sprites << " sprites/s, "
+                    << draws << " draw calls per frame" << '\n';
+            };
+
+            program->use();
+            for (uint32_t attribute = 1; attribute <= 3; ++attribute) {
+                glDisableVertexAttribArray(attribute);
+            }
+            const auto separate_label =
+                std::to_string(sprites) + " sprites, a texture bind and draw each";
+            report(
+                separate_label,
+                measure(separate_label, iterations, [&](uint64_t) {
+                    for (uint32_t sprite = 0; sprite < sprites; ++sprite) {
+                        glBindTexture(GL_TEXTURE_2D, textures[sprite % texture_count]);
+                        const auto [x, y, width, height] = rect(sprite);
+                        glVertexAttrib4f(1, x, y, width, height);
+                        glVertexAttrib4f(2, 0.0F, 0.0F, 1.0F, 1.0F);
+                        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+                    }
+                }),
+                sprites
+            );
+
+            array_program->use();
+            for (uint32_t attribute = 1; attribute <= 3; ++attribute) {
+                glEnableVertexAttribArray(attribute);
+            }
+
+            // instances grouped by the array their texture went to
+            std::vector<detail::SpriteInstance> instances;
+            std::vector<size_t> group_starts;
+            for (size_t array = 0; array < layers.arrays().size(); ++array) {
+                group_starts.push_back(instances.size());
+                for (uint32_t sprite = 0; sprite < sprites; ++sprite) {
+                    const auto& slot = layers.slot(sprite % texture_count);
+                    if (slot.array == array) {
+                        const auto layer = static_cast<float>(slot.layer);
+                        instances.push_back({ rect(sprite), { 0.0F, 0.0F, 1.0F, 1.0F }, layer });
+                    }
+                }
+            }
+            group_starts.push_back(instances.size());
+            glBufferData(
+                GL_ARRAY_BUFFER,
+                static_cast<GLsizeiptr>(instances.size() * sizeof(detail::SpriteInstance)),
+                instances.data(),
+                GL_STATIC_DRAW
+            );
+            const auto layers_label =
+                std::to_string(sprites) + " sprites, an instanced draw per texture array";
+            report(
+                layers_label,
+                measure(layers_label, iterations, [&](uint64_t) {
+                    for (size_t array = 0; array < layers.arrays().size(); ++array) {
+                        glBindTexture(GL_TEXTURE_2D_ARRAY, layers.arrays()[array].id);
+                        detail::sprite_instances(group_starts[array]);
+                        glDrawArraysInstanced(
+                            GL_TRIANGLE_STRIP,
+                            0,
+                            4,
+                            static_cast<GLsizei>(group_starts[array + 1] - group_starts[array])
+                        );
+                    }
+                }),
+                layers.arrays().size()
+            );
+
+            instances.clear();
+            for (uint32_t sprite = 0; sprite < sprites; ++sprite) {
+                const auto& region = regions[sprite % texture_count];
+                const auto layer = static_cast<float>(region.layer);
+                instances.push_back({ rect(sprite), region.uv, layer });
+            }
+            glBufferData(
+                GL_ARRAY_BUFFER,
+                static_cast<GLsizeiptr>(instances.size() * sizeof(detail::SpriteInstance)),
+                instances.data(),
+                GL_STATIC_DRAW
+            );
+            detail::sprite_instances(0);
+            const auto atlas_label = std::to_string(sprites) + " sprites, one atlas draw";
+            report(
+                atlas_label,
+                measure(atlas_label, iterations, [&](uint64_t) {
+                    glBindTexture(GL_TEXTURE_2D_ARRAY, atlas.id());
+                    glDrawArraysInstanced(
+                        GL_TRIANGLE_STRIP,
+                        0,
+                        4,
+                        static_cast<GLsizei>(sprites)
+                    );
+                }),
+                1
+            );
+        }
+
+        for (uint32_t attribute = 1; attribute <= 3; ++attribute) {
+            glVertexAttribDivisor(attribute, 0);
+        }
+        glBindVertexArray(0);
+        glDeleteVertexArrays(1, &vao);
+        glDeleteBuffers(static_cast<GLsizei>(buffers.size()), buffers.data());
+        release();
+    }
+    // Every benchmark above that needs the context, once. Call between frames, then invalidate
+    // the scene's state cache: they talk to GL directly. The stb_image settings the JPEG ones
+    // switch are the calling thread's, so texture decodes elsewhere keep theirs.
+    inline auto run() -> void {
+        uniform_sets();
+        uniform_blocks();
+        profiler_zones();
+        gl_call_layer();
+        texture_ingestion({ "container.jpg", "awesomeface.png" });
+        arena_decoding({ "container.jpg", "awesomeface.png" });
+        jpeg_kernels({ "container.jpg" });
+        jpeg_color_kernels();
+        jpeg_restart_intervals({ "container.jpg" });
+        compressed_upload("container.jpg");
+        mip_generation("container.jpg");
+        sprite_draws();
+    }
+} // namespace benchmarks
+
+#endif
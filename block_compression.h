@@ -0,0 +1,930 @@
+#pragma once
+
+#ifndef BLOCK_COMPRESSION_H
+#define BLOCK_COMPRESSION_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <glad/glad.h>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+    #define BLOCK_COMPRESSION_SSE2
+#endif
+
+#include "gl_extensions.h"
+
+// CPU encoders for the block compressed formats textures are cooked into, see cooker_main.cpp.
+// Every format stores 4x4 pixels in 8 or 16 bytes, which the GPU samples without unpacking:
+//
+//     bc1       RGB, 4 bpp. Two 5:6:5 endpoints and 2 bit indices.
+//     bc3       RGBA, 8 bpp. A bc1 color block and a block of 8 bit alpha endpoints with 3 bit
+//               indices.
+//     bc7       RGBA, 8 bpp. Mode 6 only: two 7:7:7:7 endpoints with a shared low bit each and 4
+//               bit indices.
+//     etc2      RGB, 4 bpp. The ETC1 compatible individual and differential modes, which every
+//               ETC2 decoder reads; the T, H and planar modes are not tried.
+//     etc2_eac  RGBA, 8 bpp. An EAC alpha block and an etc2 color block.
+//
+// The encoders go for a principal axis fit refined by least squares (bc), or a search of the
+// modifier tables around each half block's average (etc), rather than an exhaustive search:
+// good quality at a few megapixels per second per core, which is plenty for cooking offline.
+namespace block_compression {
+    enum class Format : uint8_t {
+        bc1,
+        bc3,
+        bc7,
+        etc2,
+        etc2_eac,
+        count,
+    };
+
+    struct FormatInfo {
+        const char* name;
+        GLenum internal_format;
+        // GL_RGB or GL_RGBA, what the format keeps of the source
+        GLenum base_format;
+        size_t block_bytes;
+    };
+
+    constexpr auto format_count = static_cast<size_t>(Format::count);
+
+    constexpr std::array<FormatInfo, format_count> formats { {
+        { "bc1", GL_COMPRESSED_RGB_S3TC_DXT1_EXT, GL_RGB, 8 },
+        { "bc3", GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, GL_RGBA, 16 },
+        { "bc7", GL_COMPRESSED_RGBA_BPTC_UNORM, GL_RGBA, 16 },
+        { "etc2", GL_COMPRESSED_RGB8_ETC2, GL_RGB, 8 },
+        { "etc2_eac", GL_COMPRESSED_RGBA8_ETC2_EAC, GL_RGBA, 16 },
+    } };
+
+    constexpr auto info(const Format format) -> const FormatInfo& {
+        return formats[static_cast<size_t>(format)];
+    }
+
+    inline auto find(const std::string_view name) -> std::optional<Format> {
+        for (size_t i = 0; i < format_count; ++i) {
+            if (formats[i].name == name) {
+                return static_cast<Format>(i);
+            }
+        }
+        return std::nullopt;
+    }
+
+    inline auto from_internal_format(const GLenum internal_format) -> std::optional<Format> {
+        for (size_t i = 0; i < format_count; ++i) {
+            if (formats[i].internal_format == internal_format) {
+                return static_cast<Format>(i);
+            }
+        }
+        return std::nullopt;
+    }
+
+    // Bytes of a `width` by `height` image, partial blocks at the edges included.
+    constexpr auto encoded_size(const Format format, const uint32_t width, const uint32_t height)
+        -> size_t {
+        return static_cast<size_t>((width + 3) / 4)
+            * static_cast<size_t>((height + 3) / 4)
+            * info(format).block_bytes;
+    }
+
+    namespace detail {
+        // One 4x4 block, pixel x + 4 * y, with a channel per array so the SSE2 kernel takes
+        // four pixels at once.
+        struct alignas(16) Block {
+            std::array<float, 16> r;
+            std::array<float, 16> g;
+            std::array<float, 16> b;
+            std::array<float, 16> a;
+        };
+
+        struct Color {
+            float r;
+            float g;
+            float b;
+            float a;
+        };
+
+        // Reads a block of a tightly packed RGBA image, repeating the last row and column where
+        // the image ends inside the block. `opaque` reads alpha as 255, for the RGB formats.
+        inline auto load_block(
+            const uint8_t* rgba,
+            const uint32_t width,
+            const uint32_t height,
+            const uint32_t block_x,
+            const uint32_t block_y,
+            const bool opaque
+        ) -> Block {
+            Block block {};
+            for (uint32_t y = 0; y < 4; ++y) {
+                const auto source_y = std::min(block_y * 4 + y, height - 1);
+                for (uint32_t x = 0; x < 4; ++x) {
+                    const auto source_x = std::min(block_x * 4 + x, width - 1);
+                    const auto* const pixel =
+                        rgba + (static_cast<size_t>(source_y) * width + source_x) * 4;
+                    const auto i = x + 4 * y;
+                    block.r[i] = pixel[0];
+                    block.g[i] = pixel[1];
+                    block.b[i] = pixel[2];
+                    block.a[i] = opaque ? 255.0F : pixel[3];
+                }
+            }
+            return block;
+        }
+
+        // For each of `pixels` pixels, a multiple of 4, the index of the closest of `count`
+        // palette colors, and the summed squared error. Channels and palette colors are whole
+        // numbers, so every sum is exact and both paths pick the same indices.
+        inline auto nearest(
+            const float* r,
+            const float* g,
+            const float* b,
+            const float* a,
+            const size_t pixels,
+            const Color* palette,
+            const size_t count,
+            uint8_t* indices
+        ) -> float {
+#ifdef BLOCK_COMPRESSION_SSE2
+            auto total = _mm_setzero_ps();
+            for (size_t i = 0; i < pixels; i += 4) {
+                const auto pixel_r = _mm_loadu_ps(r + i);
+                const auto pixel_g = _mm_loadu_ps(g + i);
+                const auto pixel_b = _mm_loadu_ps(b + i);
+                const auto pixel_a = _mm_loadu_ps(a + i);
+                auto best = _mm_set1_ps(std::numeric_limits<float>::max());
+                auto best_index = _mm_setzero_si128();
+                for (size_t c = 0; c < count; ++c) {
+                    const auto& color = palette[c];
+                    const auto delta_r = _mm_sub_ps(pixel_r, _mm_set1_ps(color.r));
+                    const auto delta_g = _mm_sub_ps(pixel_g, _mm_set1_ps(color.g));
+                    const auto delta_b = _mm_sub_ps(pixel_b, _mm_set1_ps(color.b));
+                    const auto delta_a = _mm_sub_ps(pixel_a, _mm_set1_ps(color.a));
+                    const auto error = _mm_add_ps(
+                        _mm_add_ps(_mm_mul_ps(delta_r, delta_r), _mm_mul_ps(delta_g, delta_g)),
+                        _mm_add_ps(_mm_mul_ps(delta_b, delta_b), _mm_mul_ps(delta_a, delta_a))
+                    );
+                    const auto closer = _mm_castps_si128(_mm_cmplt_ps(error, best));
+                    best = _mm_min_ps(error, best);
+                    best_index = _mm_or_si128(
+                        _mm_and_si128(closer, _mm_set1_epi32(static_cast<int32_t>(c))),
+                        _mm_andnot_si128(closer, best_index)
+                    );
+                }
+                total = _mm_add_ps(total, best);
+                alignas(16) std::array<int32_t, 4> lanes {};
+                _mm_store_si128(reinterpret_cast<__m128i*>(lanes.data()), best_index);
+                for (size_t lane = 0; lane < 4; ++lane) {
+                    indices[i + lane] = static_cast<uint8_t>(lanes[lane]);
+                }
+            }
+            alignas(16) std::array<float, 4> sums {};
+            _mm_store_ps(sums.data(), total);
+            return sums[0] + sums[1] + sums[2] + sums[3];
+#else
+            auto total = 0.0F;
+            for (size_t i = 0; i < pixels; ++i) {
+                auto best = std::numeric_limits<float>::max();
+                uint8_t best_index = 0;
+                for (size_t c = 0; c < count; ++c) {
+                    const auto& color = palette[c];
+                    const auto delta_r = r[i] - color.r;
+                    const auto delta_g = g[i] - color.g;
+                    const auto delta_b = b[i] - color.b;
+                    const auto delta_a = a[i] - color.a;
+                    const auto error = delta_r * delta_r + delta_g * delta_g
+                        + (delta_b * delta_b + delta_a * delta_a);
+                    if (error < best) {
+                        best = error;
+                        best_index = static_cast<uint8_t>(c);
+                    }
+                }
+                total += best;
+                indices[i] = best_index;
+            }
+            return total;
+#endif
+        }
+
+        inline auto nearest(
+            const Block& block,
+            const Color* palette,
+            const size_t count,
+            std::array<uint8_t, 16>& indices
+        ) -> float {
+            return nearest(
+                block.r.data(),
+                block.g.data(),
+                block.b.data(),
+                block.a.data(),
+                16,
+                palette,
+                count,
+                indices.data()
+            );
+        }
+
+        struct Line {
+            Color low;
+            Color high;
+        };
+
+        // The line through the block's colors along their principal axis, found by power
+        // iteration on the covariance matrix, from the smallest projection to the largest.
+        // Alpha only takes part when `alpha` is set.
+        inline auto principal_line(const Block& block, const bool alpha) -> Line {
+            std::array<float, 4> mean {};
+            for (size_t i = 0; i < 16; ++i) {
+                mean[0] += block.r[i];
+                mean[1] += block.g[i];
+                mean[2] += block.b[i];
+                mean[3] += block.a[i];
+            }
+            for (auto& channel : mean) {
+                channel /= 16.0F;
+            }
+
+            std::array<std::array<float, 4>, 4> covariance {};
+            for (size_t i = 0; i < 16; ++i) {
+                const std::array<float, 4> delta {
+                    block.r[i] - mean[0],
+                    block.g[i] - mean[1],
+                    block.b[i] - mean[2],
+                    alpha ? block.a[i] - mean[3] : 0.0F,
+                };
+                for (size_t row = 0; row < 4; ++row) {
+                    for (size_t column = 0; column < 4; ++column) {
+                        covariance[row][column] += delta[row] * delta[column];
+                    }
+                }
+            }
+
+            std::array<float, 4> axis { 1.0F, 1.0F, 1.0F, alpha ? 1.0F : 0.0F };
+            for (auto iteration = 0; iteration < 8; ++iteration) {
+                std::array<float, 4> next {};
+                for (size_t row = 0; row < 4; ++row) {
+                    for (size_t column = 0; column < 4; ++column) {
+                        next[row] += covariance[row][column] * axis[column];
+                    }
+                }
+                auto length = 0.0F;
+                for (const auto channel : next) {
+                    length += channel * channel;
+                }
+                if (length < 1e-12F) {
+                    break;
+                }
+                length = std::sqrt(length);
+                for (size_t channel = 0; channel < 4; ++channel) {
+                    axis[channel] = next[channel] / length;
+                }
+            }
+
+            auto low = std::numeric_limits<float>::max();
+            auto high = std::numeric_limits<float>::lowest();
+            for (size_t i = 0; i < 16; ++i) {
+                const auto projection = (block.r[i] - mean[0]) * axis[0]
+                    + (block.g[i] - mean[1]) * axis[1]
+                    + (block.b[i] - mean[2]) * axis[2]
+                    + (alpha ? (block.a[i] - mean[3]) * axis[3] : 0.0F);
+                low = std::min(low, projection);
+                high = std::max(high, projection);
+            }
+            const auto at = [&](const float t) {
+                return Color {
+                    mean[0] + axis[0] * t,
+                    mean[1] + axis[1] * t,
+                    mean[2] + axis[2] * t,
+                    mean[3] + axis[3] * t,
+                };
+            };
+            return Line { at(low), at(high) };
+        }
+
+        // The endpoints that best fit the block when pixel i sits `weights[i]` of the way from
+        // the low endpoint to the high one. nullopt when the weights do not pin the line down.
+        inline auto least_squares(const Block& block, const std::array<float, 16>& weights)
+            -> std::optional<Line> {
+            auto low_low = 0.0F;
+            auto low_high = 0.0F;
+            auto high_high = 0.0F;
+            std::array<float, 4> low_sum {};
+            std::array<float, 4> high_sum {};
+            for (size_t i = 0; i < 16; ++i) {
+                const auto high_weight = weights[i];
+                const auto low_weight = 1.0F - high_weight;
+                low_low += low_weight * low_weight;
+                low_high += low_weight * high_weight;
+                high_high += high_weight * high_weight;
+                const std::array<float, 4> pixel { block.r[i], block.g[i], block.b[i], block.a[i] };
+                for (size_t channel = 0; channel < 4; ++channel) {
+                    low_sum[channel] += low_weight * pixel[channel];
+                    high_sum[channel] += high_weight * pixel[channel];
+                }
+            }
+            const auto determinant = low_low * high_high - low_high * low_high;
+            if (std::abs(determinant) < 1e-6F) {
+                return std::nullopt;
+            }
+            std::array<float, 4> low {};
+            std::array<float, 4> high {};
+            for (size_t channel = 0; channel < 4; ++channel) {
+                low[channel] = std::clamp(
+                    (high_high * low_sum[channel] - low_high * high_sum[channel]) / determinant,
+                    0.0F,
+                    255.0F
+                );
+                high[channel] = std::clamp(
+                    (low_low * high_sum[channel] - low_high * low_sum[channel]) / determinant,
+                    0.0F,
+                    255.0F
+                );
+            }
+            return Line {
+                Color { low[0], low[1], low[2], low[3] },
+                Color { high[0], high[1], high[2], high[3] },
+            };
+        }
+
+        // Collects bits from the least significant end, for the little endian bc formats.
+        class BitWriter {
+            std::array<uint64_t, 2> words_ {};
+            uint32_t position_ { 0 };
+
+        public:
+            auto put(uint64_t value, uint32_t bits) -> void;
+            auto store(uint8_t* output, size_t bytes) const -> void;
+        };
+
+        inline auto BitWriter::put(const uint64_t value, const uint32_t bits) -> void {
+            for (uint32_t bit = 0; bit < bits; ++bit, ++this->position_) {
+                const auto set = (value >> bit) & 1U;
+                this->words_[this->position_ / 64] |= set << (this->position_ % 64);
+            }
+        }
+
+        inline auto BitWriter::store(uint8_t* output, const size_t bytes) const -> void {
+            for (size_t i = 0; i < bytes; ++i) {
+                output[i] = static_cast<uint8_t>(this->words_[i / 8] >> (i % 8 * 8));
+            }
+        }
+
+        inline auto store_big_endian(const uint64_t value, uint8_t* output) -> void {
+            for (size_t i = 0; i < 8; ++i) {
+                output[i] = static_cast<uint8_t>(value >> ((7 - i) * 8));
+            }
+        }
+
+        inline auto quantize(const float value, const int32_t maximum) -> int32_t {
+            const auto scaled = std::lround(value * static_cast<float>(maximum) / 255.0F);
+            return std::clamp(static_cast<int32_t>(scaled), 0, maximum);
+        }
+
+        inline auto pack_565(const Color& color) -> uint16_t {
+            return static_cast<uint16_t>(
+                quantize(color.r, 31) << 11 | quantize(color.g, 63) << 5 | quantize(color.b, 31)
+            );
+        }
+
+        // Expands the way decoders do, by repeating the top bits in the bottom ones.
+        inline auto unpack_565(const uint16_t packed) -> Color {
+            const auto r = (packed >> 11U) & 31U;
+            const auto g = (packed >> 5U) & 63U;
+            const auto b = packed & 31U;
+            return Color {
+                static_cast<float>(r << 3U | r >> 2U),
+                static_cast<float>(g << 2U | g >> 4U),
+                static_cast<float>(b << 3U | b >> 2U),
+                255.0F,
+            };
+        }
+
+        // Index 0 and 1 are the endpoints, 2 and 3 lie a third and two thirds of the way.
+        inline auto bc1_palette(const uint16_t color0, const uint16_t color1)
+            -> std::array<Color, 4> {
+            const auto first = unpack_565(color0);
+            const auto second = unpack_565(color1);
+            const auto between = [&](const float near, const float far) {
+                return std::floor((2.0F * near + far) / 3.0F);
+            };
+            return {
+                first,
+                second,
+                Color {
+                    between(first.r, second.r),
+                    between(first.g, second.g),
+                    between(first.b, second.b),
+                    255.0F,
+                },
+                Color {
+                    between(second.r, first.r),
+                    between(second.g, first.g),
+                    between(second.b, first.b),
+                    255.0F,
+                },
+            };
+        }
+
+        // Always in the four color mode: color0 is the larger of the two, unless they are
+        // equal and every index points at color0.
+        inline auto encode_bc1_block(const Block& block, uint8_t* output) -> void {
+            constexpr std::array<float, 4> weights { 0.0F, 1.0F, 1.0F / 3.0F, 2.0F / 3.0F };
+            auto line = principal_line(block, false);
+            auto best_error = std::numeric_limits<float>::max();
+            uint16_t best_color0 = 0;
+            uint16_t best_color1 = 0;
+            std::array<uint8_t, 16> best_indices {};
+            for (auto iteration = 0; iteration < 3; ++iteration) {
+                const auto color0 = pack_565(line.high);
+                const auto color1 = pack_565(line.low);
+                const auto palette = bc1_palette(color0, color1);
+                std::array<uint8_t, 16> indices {};
+                const auto error = nearest(block, palette.data(), palette.size(), indices);
+                if (error < best_error) {
+                    best_error = error;
+                    best_color0 = color0;
+                    best_color1 = color1;
+                    best_indices = indices;
+                }
+                std::array<float, 16> pixel_weights {};
+                for (size_t i = 0; i < 16; ++i) {
+                    // towards color0, the high end
+                    pixel_weights[i] = 1.0F - weights[indices[i]];
+                }
+                const auto fitted = least_squares(block, pixel_weights);
+                if (!fitted.has_value()) {
+                    break;
+                }
+                line = *fitted;
+            }
+
+            if (best_color0 < best_color1) {
+                std::swap(best_color0, best_color1);
+                for (auto& index : best_indices) {
+                    // 0 and 1 trade places, and so do 2 and 3
+                    index ^= 1U;
+                }
+            } else if (best_color0 == best_color1) {
+                best_indices = {};
+            }
+            BitWriter bits {};
+            bits.put(best_color0, 16);
+            bits.put(best_color1, 16);
+            for (const auto index : best_indices) {
+                bits.put(index, 2);
+            }
+            bits.store(output, 8);
+        }
+
+        // Eight alpha values between the largest and the smallest of the block.
+        inline auto encode_bc3_alpha_block(const Block& block, uint8_t* output) -> void {
+            const auto [low, high] = std::minmax_element(block.a.begin(), block.a.end());
+            const auto alpha0 = static_cast<uint32_t>(*high);
+            const auto alpha1 = static_cast<uint32_t>(*low);
+            std::array<float, 8> palette {
+                static_cast<float>(alpha0),
+                static_cast<float>(alpha1),
+            };
+            for (uint32_t i = 2; i < 8; ++i) {
+                palette[i] = static_cast<float>(((8 - i) * alpha0 + (i - 1) * alpha1) / 7);
+            }
+
+            BitWriter bits {};
+            bits.put(alpha0, 8);
+            bits.put(alpha1, 8);
+            for (const auto alpha : block.a) {
+                uint32_t best_index = 0;
+                // equal endpoints read as the six value mode, where index 0 is still alpha0
+                if (alpha0 != alpha1) {
+                    for (uint32_t i = 1; i < 8; ++i) {
+                        if (std::abs(palette[i] - alpha) < std::abs(palette[best_index] - alpha)) {
+                            best_index = i;
+                        }
+                    }
+                }
+                bits.put(best_index, 3);
+            }
+            bits.store(output, 8);
+        }
+
+        inline auto encode_bc3_block(const Block& block, uint8_t* output) -> void {
+            encode_bc3_alpha_block(block, output);
+            encode_bc1_block(block, output + 8);
+        }
+
+        constexpr std::array<uint32_t, 16> bc7_weights {
+            0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64,
+        };
+
+        struct Bc7Endpoint {
+            // 7 bits per channel, widened by the shared low bit
+            std::array<uint32_t, 4> channels;
+            uint32_t low_bit;
+
+            auto expanded(size_t channel) const -> uint32_t;
+        };
+
+        inline auto Bc7Endpoint::expanded(const size_t channel) const -> uint32_t {
+            return this->channels[channel] << 1U | this->low_bit;
+        }
+
+        inline auto quantize_bc7(const Color& color, const uint32_t low_bit) -> Bc7Endpoint {
+            const auto channel = [low_bit](const float value) {
+                const auto scaled = std::lround((value - static_cast<float>(low_bit)) / 2.0F);
+                return static_cast<uint32_t>(std::clamp(static_cast<int32_t>(scaled), 0, 127));
+            };
+            return Bc7Endpoint {
+                { channel(color.r), channel(color.g), channel(color.b), channel(color.a) },
+                low_bit,
+            };
+        }
+
+        inline auto bc7_palette(const Bc7Endpoint& low, const Bc7Endpoint& high)
+            -> std::array<Color, 16> {
+            std::array<Color, 16> palette {};
+            for (size_t i = 0; i < 16; ++i) {
+                const auto weight = bc7_weights[i];
+                std::array<float, 4> channels {};
+                for (size_t channel = 0; channel < 4; ++channel) {
+                    channels[channel] = static_cast<float>(
+                        ((64 - weight) * low.expanded(channel)
+                            + weight * high.expanded(channel) + 32) >> 6U
+                    );
+                }
+                palette[i] = Color { channels[0], channels[1], channels[2], channels[3] };
+            }
+            return palette;
+        }
+
+        // Mode 6, one subset: the mode bit, the endpoints channel by channel, their low bits and
+        // the indices, the first of which drops its top bit and so has to be below 8.
+        inline auto encode_bc7_block(const Block& block, uint8_t* output) -> void {
+            auto line = principal_line(block, true);
+            auto best_error = std::numeric_limits<float>::max();
+            Bc7Endpoint best_low {};
+            Bc7Endpoint best_high {};
+            std::array<uint8_t, 16> best_indices {};
+            for (auto iteration = 0; iteration < 3; ++iteration) {
+                auto improved = false;
+                for (uint32_t low_bits = 0; low_bits < 4; ++low_bits) {
+                    const auto low = quantize_bc7(line.low, low_bits & 1U);
+                    const auto high = quantize_bc7(line.high, low_bits >> 1U);
+                    const auto palette = bc7_palette(low, high);
+                    std::array<uint8_t, 16> indices {};
+                    const auto error = nearest(block, palette.data(), palette.size(), indices);
+                    if (error < best_error) {
+                        best_error = error;
+                        best_low = low;
+                        best_high = high;
+                        best_indices = indices;
+                        improved = true;
+                    }
+                }
+                if (!improved || best_error == 0.0F) {
+                    break;
+                }
+                std::array<float, 16> weights {};
+                for (size_t i = 0; i < 16; ++i) {
+                    weights[i] = static_cast<float>(bc7_weights[best_indices[i]]) / 64.0F;
+                }
+                const auto fitted = least_squares(block, weights);
+                if (!fitted.has_value()) {
+                    break;
+                }
+                line = *fitted;
+            }
+
+            if (best_indices[0] >= 8) {
+                std::swap(best_low, best_high);
+                for (auto& index : best_indices) {
+                    index = static_cast<uint8_t>(15 - index);
+                }
+            }
+            BitWriter bits {};
+            bits.put(1U << 6U, 7);
+            for (size_t channel = 0; channel < 4; ++channel) {
+                bits.put(best_low.channels[channel], 7);
+                bits.put(best_high.channels[channel], 7);
+            }
+            bits.put(best_low.low_bit, 1);
+            bits.put(best_high.low_bit, 1);
+            bits.put(best_indices[0], 3);
+            for (size_t i = 1; i < 16; ++i) {
+                bits.put(best_indices[i], 4);
+            }
+            bits.store(output, 16);
+        }
+
+        // How far the four indices move a half block's base color, small and large step, per
+        // table. Index bits 00 add the small step, 01 the large one, 10 and 11 subtract them.
+        constexpr std::array<std::array<int32_t, 2>, 8> etc_modifiers { {
+            { 2, 8 },
+            { 5, 17 },
+            { 9, 29 },
+            { 13, 42 },
+            { 18, 60 },
+            { 24, 80 },
+            { 33, 106 },
+            { 47, 183 },
+        } };
+
+        struct EtcHalf {
+            std::array<int32_t, 3> base;
+            uint32_t table;
+            float error;
+        };
+
+        // The best modifier table for 8 pixels around an expanded base color.
+        inline auto fit_etc_half(
+            const std::array<std::array<float, 8>, 4>& pixels,
+            const std::array<int32_t, 3>& base,
+            std::array<uint8_t, 8>& indices
+        ) -> EtcHalf {
+            EtcHalf best { base, 0, std::numeric_limits<float>::max() };
+            for (uint32_t table = 0; table < etc_modifiers.size(); ++table) {
+                std::array<Color, 4> palette {};
+                const std::array<int32_t, 4> steps {
+                    etc_modifiers[table][0],
+                    etc_modifiers[table][1],
+                    -etc_modifiers[table][0],
+                    -etc_modifiers[table][1],
+                };
+                for (size_t i = 0; i < 4; ++i) {
+                    const auto channel = [&](const size_t c) {
+                        return static_cast<float>(std::clamp(base[c] + steps[i], 0, 255));
+                    };
+                    palette[i] = Color { channel(0), channel(1), channel(2), 255.0F };
+                }
+                std::array<uint8_t, 8> table_indices {};
+                const auto error = nearest(
+                    pixels[0].data(),
+                    pixels[1].data(),
+                    pixels[2].data(),
+                    pixels[3].data(),
+                    8,
+                    palette.data(),
+                    palette.size(),
+                    table_indices.data()
+                );
+                if (error < best.error) {
+                    best.table = table;
+                    best.error = error;
+                    indices = table_indices;
+                }
+            }
+            return best;
+        }
+
+        // 64 bits, most significant first: base colors, the two tables, the differential and
+        // flip bits, then the top bits of every pixel's index followed by the low bits, pixels
+        // numbered down the columns.
+        inline auto encode_etc2_block(const Block& block, uint8_t* output) -> void {
+            auto best_error = std::numeric_limits<float>::max();
+            uint64_t best_bits = 0;
+            for (uint32_t flip = 0; flip < 2; ++flip) {
+                // without flip the halves are the left and right 2x4, with it the top and bottom
+                std::array<std::array<std::array<float, 8>, 4>, 2> halves {};
+                std::array<std::array<uint32_t, 8>, 2> half_pixels {};
+                std::array<size_t, 2> filled {};
+                for (uint32_t i = 0; i < 16; ++i) {
+                    const auto x = i % 4;
+                    const auto y = i / 4;
+                    const auto half = (flip != 0 ? y : x) / 2;
+                    auto& slot = filled[half];
+                    halves[half][0][slot] = block.r[i];
+                    halves[half][1][slot] = block.g[i];
+                    halves[half][2][slot] = block.b[i];
+                    halves[half][3][slot] = 255.0F;
+                    half_pixels[half][slot] = x * 4 + y;
+                    ++slot;
+                }
+                std::array<std::array<float, 3>, 2> averages {};
+                for (size_t half = 0; half < 2; ++half) {
+                    for (size_t channel = 0; channel < 3; ++channel) {
+                        auto sum = 0.0F;
+                        for (const auto value : halves[half][channel]) {
+                            sum += value;
+                        }
+                        averages[half][channel] = sum / 8.0F;
+                    }
+                }
+
+                for (uint32_t differential = 0; differential < 2; ++differential) {
+                    const auto maximum = differential != 0 ? 31 : 15;
+                    std::array<std::array<int32_t, 3>, 2> quantized {};
+                    std::array<std::array<int32_t, 3>, 2> bases {};
+                    auto representable = true;
+                    for (size_t half = 0; half < 2; ++half) {
+                        for (size_t channel = 0; channel < 3; ++channel) {
+                            const auto value = quantize(averages[half][channel], maximum);
+                            quantized[half][channel] = value;
+                            bases[half][channel] = differential != 0
+                                ? value << 3 | value >> 2
+                                : value << 4 | value;
+                        }
+                    }
+                    if (differential != 0) {
+                        for (size_t channel = 0; channel < 3; ++channel) {
+                            const auto delta = quantized[1][channel] - quantized[0][channel];
+                            representable = representable && delta >= -4 && delta <= 3;
+                        }
+                    }
+                    if (!representable) {
+                        continue;
+                    }
+
+                    std::array<std::array<uint8_t, 8>, 2> indices {};
+                    const std::array<EtcHalf, 2> fits {
+                        fit_etc_half(halves[0], bases[0], indices[0]),
+                        fit_etc_half(halves[1], bases[1], indices[1]),
+                    };
+                    const auto error = fits[0].error + fits[1].error;
+                    if (error >= best_error) {
+                        continue;
+                    }
+                    best_error = error;
+
+                    uint64_t bits = 0;
+                    for (size_t channel = 0; channel < 3; ++channel) {
+                        const auto shift = 59 - channel * 8;
+                        if (differential != 0) {
+                            const auto delta = quantized[1][channel] - quantized[0][channel];
+                            bits |= static_cast<uint64_t>(quantized[0][channel]) << shift;
+                            bits |= static_cast<uint64_t>(delta & 7) << (shift - 3);
+                        } else {
+                            bits |= static_cast<uint64_t>(quantized[0][channel]) << (shift + 1);
+                            bits |= static_cast<uint64_t>(quantized[1][channel]) << (shift - 3);
+                        }
+                    }
+                    bits |= static_cast<uint64_t>(fits[0].table) << 37U;
+                    bits |= static_cast<uint64_t>(fits[1].table) << 34U;
+                    bits |= static_cast<uint64_t>(differential) << 33U;
+                    bits |= static_cast<uint64_t>(flip) << 32U;
+                    for (size_t half = 0; half < 2; ++half) {
+                        for (size_t slot = 0; slot < 8; ++slot) {
+                            const auto pixel = half_pixels[half][slot];
+                            const auto index = indices[half][slot];
+                            bits |= static_cast<uint64_t>(index >> 1U) << (pixel + 16);
+                            bits |= static_cast<uint64_t>(index & 1U) << pixel;
+                        }
+                    }
+                    best_bits = bits;
+                }
+            }
+            store_big_endian(best_bits, output);
+        }
+
+        constexpr std::array<std::array<int32_t, 8>, 16> eac_modifiers { {
+            { -3, -6, -9, -15, 2, 5, 8, 14 },
+            { -3, -7, -10, -13, 2, 6, 9, 12 },
+            { -2, -5, -8, -13, 1, 4, 7, 12 },
+            { -2, -4, -6, -13, 1, 3, 5, 12 },
+            { -3, -6, -8, -12, 2, 5, 7, 11 },
+            { -3, -7, -9, -11, 2, 6, 8, 10 },
+            { -4, -7, -8, -11, 3, 6, 7, 10 },
+            { -3, -5, -8, -11, 2, 4, 7, 10 },
+            { -2, -6, -8, -10, 1, 5, 7, 9 },
+            { -2, -5, -8, -10, 1, 4, 7, 9 },
+            { -2, -4, -8, -10, 1, 3, 7, 9 },
+            { -2, -5, -7, -10, 1, 4, 6, 9 },
+            { -3, -4, -7, -10, 2, 3, 6, 9 },
+            { -1, -2, -3, -10, 0, 1, 2, 9 },
+            { -4, -6, -8, -9, 3, 5, 7, 8 },
+            { -3, -5, -7, -9, 2, 4, 6, 8 },
+        } };
+
+        // 64 bits, most significant first: base, multiplier, table, then a 3 bit index per
+        // pixel down the columns. Tries the multipliers that stretch each table over the
+        // block's range, and the bases that center it.
+        inline auto encode_eac_alpha_block(const Block& block, uint8_t* output) -> void {
+            const auto [low, high] = std::minmax_element(block.a.begin(), block.a.end());
+            const auto low_alpha = static_cast<int32_t>(*low);
+            const auto high_alpha = static_cast<int32_t>(*high);
+            auto best_error = std::numeric_limits<int32_t>::max();
+            uint64_t best_bits = 0;
+            for (uint32_t table = 0; table < eac_modifiers.size() && best_error != 0; ++table) {
+                const auto& modifiers = eac_modifiers[table];
+                const auto span = modifiers[7] - modifiers[3];
+                const auto fitting = std::clamp((high_alpha - low_alpha + span / 2) / span, 1, 15);
+                for (auto multiplier = std::max(fitting - 1, 1);
+                     multiplier <= std::min(fitting + 1, 15);
+                     ++multiplier) {
+                    const auto center = std::clamp(
+                        (low_alpha + high_alpha - (modifiers[7] + modifiers[3]) * multiplier) / 2,
+                        0,
+                        255
+                    );
+                    for (auto base = std::max(center - 1, 0);
+                         base <= std::min(center + 1, 255);
+                         ++base) {
+                        auto error = 0;
+                        uint64_t bits = static_cast<uint64_t>(base) << 56U
+                            | static_cast<uint64_t>(multiplier) << 52U
+                            | static_cast<uint64_t>(table) << 48U;
+                        for (uint32_t i = 0; i < 16 && error < best_error; ++i) {
+                            const auto alpha = static_cast<int32_t>(block.a[i]);
+                            auto pixel_error = std::numeric_limits<int32_t>::max();
+                            uint32_t pixel_index = 0;
+                            for (uint32_t index = 0; index < 8; ++index) {
+                                const auto value =
+                                    std::clamp(base + modifiers[index] * multiplier, 0, 255);
+                                const auto delta = value - alpha;
+                                if (delta * delta < pixel_error) {
+                                    pixel_error = delta * delta;
+                                    pixel_index = index;
+                                }
+                            }
+                            error += pixel_error;
+                            const auto pixel = (i % 4) * 4 + i / 4;
+                            bits |= static_cast<uint64_t>(pixel_index) << (45 - pixel * 3);
+                        }
+                        if (error < best_error) {
+                            best_error = error;
+                            best_bits = bits;
+                        }
+                    }
+                }
+            }
+            store_big_endian(best_bits, output);
+        }
+
+        inline auto encode_etc2_eac_block(const Block& block, uint8_t* output) -> void {
+            encode_eac_alpha_block(block, output);
+            encode_etc2_block(block, output + 8);
+        }
+
+        inline auto encode_block(const Format format, const Block& block, uint8_t* output)
+            -> void {
+            switch (format) {
+                case Format::bc1:
+                    encode_bc1_block(block, output);
+                    break;
+                case Format::bc3:
+                    encode_bc3_block(block, output);
+                    break;
+                case Format::bc7:
+                    encode_bc7_block(block, output);
+                    break;
+                case Format::etc2:
+                    encode_etc2_block(block, output);
+                    break;
+                case Format::etc2_eac:
+                    encode_etc2_eac_block(block, output);
+                    break;
+                case Format::count:
+                    break;
+            }
+        }
+    } // namespace detail
+
+    // Encodes a tightly packed RGBA image into encoded_size() bytes at `output`, blocks left to
+    // right and top to bottom in memory order, on up to `threads` threads (0 for one per
+    // hardware thread).
+    inline auto encode(
+        const Format format,
+        const uint8_t* rgba,
+        const uint32_t width,
+        const uint32_t height,
+        uint8_t* output,
+        uint32_t threads = 0
+    ) -> void {
+        const auto blocks_x = (width + 3) / 4;
+        const auto blocks_y = (height + 3) / 4;
+        const auto block_bytes = info(format).block_bytes;
+        const auto opaque = info(format).base_format == GL_RGB;
+        // rows of blocks are handed out one at a time, so uneven rows balance out
+        std::atomic<uint32_t> next_row { 0 };
+        const auto work = [&] {
+            for (auto row = next_row++; row < blocks_y; row = next_row++) {
+                for (uint32_t column = 0; column < blocks_x; ++column) {
+                    const auto block = detail::load_block(rgba, width, height, column, row, opaque);
+                    const auto offset = static_cast<size_t>(row) * blocks_x + column;
+                    detail::encode_block(format, block, output + offset * block_bytes);
+                }
+            }
+        };
+
+        if (threads == 0) {
+            threads = std::max(std::thread::hardware_concurrency(), 1U);
+        }
+        threads = std::min(threads, blocks_y);
+        std::vector<std::thread> workers;
+        for (uint32_t i = 1; i < threads; ++i) {
+            workers.emplace_back(work);
+        }
+        work();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+} // namespace block_compression
+
+#endif
@@ -0,0 +1,220 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "block_compression.h"
+#include "ktx_file.h"
+#include "mip_chain.h"
+#include "stb_image.h"
+
+// Cooks source images into KTX files next to them, every mip level included, which the texture
+// loader uploads in place of decoding the source and generating mipmaps. Sources are flipped to
+// the bottom-up row order GL takes, as TextureRequest::flip_vertically does, unless --top-down
+// is given.
+//
+//     learn-opengl-cooker [--format bc1|bc3|bc7|etc2|etc2_eac|rgba8]... [--filter box|kaiser]
+//         [--linear] [--threads n] [--top-down] source...
+//
+// Without --format, each source is cooked into every format it fits: bc7, bc1 and etc2 when it
+// is opaque, bc7, bc3 and etc2_eac when it has alpha, and rgba8 for drivers that take none of
+// those. The loader picks the first of those the driver supports, in that order.
+//
+// Mip levels are filtered in linear light with a Kaiser windowed sinc unless --filter box is
+// given; --linear filters the values as they are, for data that is not sRGB color.
+
+namespace {
+    struct Options {
+        std::vector<block_compression::Format> formats;
+        // uncompressed RGBA8 levels too
+        bool rgba8 { false };
+        mip_chain::Filter filter { mip_chain::Filter::kaiser };
+        bool srgb { true };
+        uint32_t threads { 0 };
+        bool bottom_up { true };
+        std::vector<std::string> sources;
+    };
+
+    auto parse_options(const int32_t argc, char** argv) -> std::optional<Options> {
+        Options options {};
+        for (auto i = 1; i < argc; ++i) {
+            const std::string_view argument { argv[i] };
+            const auto has_value = i + 1 < argc;
+            if (argument == "--format" && has_value && argv[i + 1] == ktx_file::rgba8_name) {
+                options.rgba8 = true;
+                ++i;
+            } else if (argument == "--format" && has_value) {
+                const auto format = block_compression::find(argv[++i]);
+                if (!format.has_value()) {
+                    std::cout << "ERROR: unknown format " << argv[i] << '\n';
+                    return std::nullopt;
+                }
+                options.formats.push_back(*format);
+            } else if (argument == "--filter" && has_value) {
+                const std::string_view filter { argv[++i] };
+                if (filter != "box" && filter != "kaiser") {
+                    std::cout << "ERROR: unknown filter " << filter << '\n';
+                    return std::nullopt;
+                }
+                options.filter =
+                    filter == "box" ? mip_chain::Filter::box : mip_chain::Filter::kaiser;
+            } else if (argument == "--linear") {
+                options.srgb = false;
+            } else if (argument == "--threads" && has_value) {
+                options.threads = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+            } else if (argument == "--top-down") {
+                options.bottom_up = false;
+            } else if (argument.substr(0, 2) == "--") {
+                std::cout << "ERROR: unknown option " << argument << '\n';
+                return std::nullopt;
+            } else {
+                options.sources.emplace_back(argument);
+            }
+        }
+        if (options.sources.empty()) {
+            std::cout << "usage: learn-opengl-cooker "
+                "[--format bc1|bc3|bc7|etc2|etc2_eac|rgba8]... [--filter box|kaiser] [--linear] "
+                "[--threads n] [--top-down] source..." << '\n';
+            return std::nullopt;
+        }
+        return options;
+    }
+
+    auto cook(const std::string& source, const Options& options) -> bool {
+        auto width = 0;
+        auto height = 0;
+        auto channels = 0;
+        stbi_set_flip_vertically_on_load(options.bottom_up ? 1 : 0);
+        auto* const pixels = stbi_load(source.c_str(), &width, &height, &channels, 4);
+        if (pixels == nullptr) {
+            std::cout << "ERROR: failed to load " << source << ": " << stbi_failure_reason()
+                << '\n';
+            return false;
+        }
+        using milliseconds = std::chrono::duration<double, std::milli>;
+        const auto mip_start = std::chrono::steady_clock::now();
+        const auto levels = mip_chain::build(
+            mip_chain::Image {
+                static_cast<uint32_t>(width),
+                static_cast<uint32_t>(height),
+                std::vector<uint8_t>(pixels, pixels + static_cast<size_t>(width) * height * 4),
+            },
+            mip_chain::Options { options.filter, options.srgb, options.threads }
+        );
+        stbi_image_free(pixels);
+        const milliseconds mip_time { std::chrono::steady_clock::now() - mip_start };
+        std::cout << "filtered " << source << ": " << levels.size() << " levels, "
+            << (options.filter == mip_chain::Filter::box ? "box" : "kaiser") << ", "
+            << (options.srgb ? "sRGB" : "linear") << ", " << mip_time.count() << " ms" << '\n';
+
+        auto formats = options.formats;
+        auto rgba8 = options.rgba8;
+        if (formats.empty() && !rgba8) {
+            rgba8 = true;
+            using block_compression::Format;
+            const auto alpha = channels == 2 || channels == 4;
+            formats = alpha
+                ? std::vector { Format::bc7, Format::bc3, Format::etc2_eac }
+                : std::vector { Format::bc7, Format::bc1, Format::etc2 };
+        }
+
+        // what the loader would upload without a cooked file, mip levels included
+        size_t uncompressed_size = 0;
+        for (const auto& level : levels) {
+            uncompressed_size += static_cast<size_t>(level.width) * level.height
+                * static_cast<size_t>(channels);
+        }
+
+        const auto write = [&](
+            const std::string& path,
+            const ktx_file::KtxFile& file,
+            const size_t size,
+            const milliseconds elapsed
+        ) {
+            if (!ktx_file::write(path, file)) {
+                return false;
+            }
+            std::cout << "cooked " << path << ": " << width << "x" << height << ", "
+                << levels.size() << " levels, " << size << " bytes, "
+                << static_cast<double>(uncompressed_size) / static_cast<double>(size)
+                << "x smaller, " << elapsed.count() << " ms" << '\n';
+            return true;
+        };
+
+        auto cooked = true;
+        for (const auto format : formats) {
+            const auto& info = block_compression::info(format);
+            const auto start = std::chrono::steady_clock::now();
+            std::vector<std::vector<uint8_t>> encoded;
+            ktx_file::KtxFile file {
+                info.internal_format,
+                info.base_format,
+                0,
+                0,
+                options.bottom_up,
+                {},
+            };
+            size_t size = 0;
+            for (const auto& level : levels) {
+                auto& blocks = encoded.emplace_back(
+                    block_compression::encoded_size(format, level.width, level.height)
+                );
+                block_compression::encode(
+                    format,
+                    level.pixels.data(),
+                    level.width,
+                    level.height,
+                    blocks.data(),
+                    options.threads
+                );
+                file.levels.push_back(
+                    ktx_file::Level { level.width, level.height, blocks.data(), blocks.size() }
+                );
+                size += blocks.size();
+            }
+            const milliseconds elapsed { std::chrono::steady_clock::now() - start };
+            const auto path = ktx_file::cooked_path(source, info.name);
+            cooked = write(path, file, size, elapsed) && cooked;
+        }
+
+        if (rgba8) {
+            ktx_file::KtxFile file {
+                GL_RGBA8,
+                GL_RGBA,
+                GL_UNSIGNED_BYTE,
+                GL_RGBA,
+                options.bottom_up,
+                {},
+            };
+            size_t size = 0;
+            for (const auto& level : levels) {
+                file.levels.push_back(ktx_file::Level {
+                    level.width,
+                    level.height,
+                    level.pixels.data(),
+                    level.pixels.size(),
+                });
+                size += level.pixels.size();
+            }
+            const auto path = ktx_file::cooked_path(source, ktx_file::rgba8_name);
+            cooked = write(path, file, size, mip_time) && cooked;
+        }
+        return cooked;
+    }
+} // namespace
+
+auto main(const int32_t argc, char** argv) -> int32_t {
+    const auto options = parse_options(argc, argv);
+    if (!options.has_value()) {
+        return EXIT_FAILURE;
+    }
+    auto succeeded = true;
+    for (const auto& source : options->sources) {
+        succeeded = cook(source, *options) && succeeded;
+    }
+    return succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,237 @@
+#pragma once
+
+#ifndef DECODE_ARENA_H
+#define DECODE_ARENA_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <new>
+
+// The allocator stb_image is built with, see stb_image.cpp. Decoding an image takes a few
+// dozen allocations (component and row buffers, zlib output grown by realloc, the JPEG
+// context); inside a Scope they come from a per-thread arena that is reset when the scope
+// ends, so a thread decoding image after image stops calling malloc once its arena has grown
+// to fit the largest.
+//
+//     {
+//         const decode_arena::Scope scope {};
+//         stbi_load_from_memory_into(...);
+//     }
+//
+// Memory stb_image hands out inside a scope is only valid until the scope ends, and must not
+// be freed after it either: decode with stbi_load_from_memory_into, or copy the result.
+namespace decode_arena {
+    namespace detail {
+        constexpr size_t alignment = 16;
+
+        // In front of every allocation, so release() and reallocate() work for memory from any
+        // thread, and from before or after a scope.
+        struct alignas(alignment) Header {
+            size_t size;
+            bool in_arena;
+        };
+        static_assert(sizeof(Header) == alignment);
+
+        constexpr auto padded(const size_t size) -> size_t {
+            return (sizeof(Header) + size + alignment - 1) / alignment * alignment;
+        }
+
+        inline std::atomic<uint64_t> heap_allocations { 0 };
+
+        class Arena {
+            static constexpr size_t none = std::numeric_limits<size_t>::max();
+            static constexpr size_t growth_granularity = size_t { 64 } << 10U;
+
+            std::byte* buffer_ { nullptr };
+            size_t capacity_ { 0 };
+            size_t offset_ { 0 };
+            // the most recent allocation, which can grow or shrink in place
+            size_t last_ { none };
+            // what the current image asked for, arena or not
+            size_t demand_ { 0 };
+
+        public:
+            Arena() = default;
+            ~Arena();
+
+            Arena(const Arena&) = delete;
+            auto operator=(const Arena&) -> Arena& = delete;
+
+            // nullptr when the arena is full, the caller goes to the heap then.
+            auto allocate(size_t size) -> Header*;
+            auto resize(Header* header, size_t size) -> bool;
+            auto release(Header* header) -> void;
+            // Frees everything, and grows the arena to what the last image needed.
+            auto reset() -> void;
+
+        private:
+            auto is_last(const Header* header) const -> bool;
+        };
+
+        inline Arena::~Arena() {
+            std::free(this->buffer_);
+        }
+
+        inline auto Arena::allocate(const size_t size) -> Header* {
+            const auto padded_size = padded(size);
+            this->demand_ += padded_size;
+            if (padded_size > this->capacity_ - this->offset_) {
+                return nullptr;
+            }
+            auto* const header = new (this->buffer_ + this->offset_) Header { size, true };
+            this->last_ = this->offset_;
+            this->offset_ += padded_size;
+            return header;
+        }
+
+        inline auto Arena::is_last(const Header* header) const -> bool {
+            return this->last_ != none
+                && reinterpret_cast<const std::byte*>(header) == this->buffer_ + this->last_;
+        }
+
+        inline auto Arena::resize(Header* header, const size_t size) -> bool {
+            if (!this->is_last(header)) {
+                return false;
+            }
+            const auto padded_size = padded(size);
+            if (padded_size > this->capacity_ - this->last_) {
+                return false;
+            }
+            this->demand_ += padded_size - std::min(padded_size, this->offset_ - this->last_);
+            this->offset_ = this->last_ + padded_size;
+            header->size = size;
+            return true;
+        }
+
+        inline auto Arena::release(Header* header) -> void {
+            // only the most recent allocation gives its space back, the rest waits for reset()
+            if (this->is_last(header)) {
+                this->offset_ = this->last_;
+                this->last_ = none;
+            }
+        }
+
+        inline auto Arena::reset() -> void {
+            if (this->demand_ > this->capacity_) {
+                std::free(this->buffer_);
+                this->capacity_ = (this->demand_ + growth_granularity - 1)
+                    / growth_granularity
+                    * growth_granularity;
+                // malloc aligns for any fundamental type, which covers Header
+                this->buffer_ = static_cast<std::byte*>(std::malloc(this->capacity_));
+                heap_allocations.fetch_add(1, std::memory_order_relaxed);
+                if (this->buffer_ == nullptr) {
+                    this->capacity_ = 0;
+                }
+            }
+            this->offset_ = 0;
+            this->last_ = none;
+            this->demand_ = 0;
+        }
+
+        inline auto thread_arena() -> Arena& {
+            thread_local Arena arena {};
+            return arena;
+        }
+
+        inline thread_local Arena* active = nullptr;
+
+        inline auto heap_allocate(const size_t size) -> Header* {
+            heap_allocations.fetch_add(1, std::memory_order_relaxed);
+            auto* const memory = std::malloc(sizeof(Header) + size);
+            if (memory == nullptr) {
+                return nullptr;
+            }
+            return new (memory) Header { size, false };
+        }
+    } // namespace detail
+
+    // Puts the calling thread's allocations from stb_image on its arena until destroyed.
+    class Scope {
+        detail::Arena* previous_;
+
+    public:
+        Scope();
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        auto operator=(const Scope&) -> Scope& = delete;
+    };
+
+    inline Scope::Scope():
+        previous_ { detail::active } {
+        detail::active = &detail::thread_arena();
+    }
+
+    inline Scope::~Scope() {
+        if (this->previous_ == nullptr) {
+            detail::active->reset();
+        }
+        detail::active = this->previous_;
+    }
+
+    inline auto allocate(const size_t size) -> void* {
+        detail::Header* header = nullptr;
+        if (detail::active != nullptr) {
+            header = detail::active->allocate(size);
+        }
+        if (header == nullptr) {
+            header = detail::heap_allocate(size);
+        }
+        return header != nullptr ? header + 1 : nullptr;
+    }
+
+    inline auto release(void* memory) -> void {
+        if (memory == nullptr) {
+            return;
+        }
+        auto* const header = static_cast<detail::Header*>(memory) - 1;
+        if (!header->in_arena) {
+            std::free(header);
+        } else if (detail::active != nullptr) {
+            detail::active->release(header);
+        }
+    }
+
+    inline auto reallocate(void* memory, const size_t old_size, const size_t new_size) -> void* {
+        static_cast<void>(old_size);
+        if (memory == nullptr) {
+            return allocate(new_size);
+        }
+        auto* const header = static_cast<detail::Header*>(memory) - 1;
+        const auto in_active_arena = header->in_arena && detail::active != nullptr;
+        if (in_active_arena && detail::active->resize(header, new_size)) {
+            return memory;
+        }
+        if (!header->in_arena && detail::active == nullptr) {
+            detail::heap_allocations.fetch_add(1, std::memory_order_relaxed);
+            auto* const resized = static_cast<detail::Header*>(
+                std::realloc(header, sizeof(detail::Header) + new_size)
+            );
+            if (resized == nullptr) {
+                return nullptr;
+            }
+            resized->size = new_size;
+            return resized + 1;
+        }
+
+        auto* const moved = allocate(new_size);
+        if (moved != nullptr) {
+            std::memcpy(moved, memory, std::min(header->size, new_size));
+            release(memory);
+        }
+        return moved;
+    }
+
+    // Calls to malloc and realloc on behalf of stb_image so far, arena growth included.
+    inline auto heap_allocations() -> uint64_t {
+        return detail::heap_allocations.load(std::memory_order_relaxed);
+    }
+} // namespace decode_arena
+
+#endif
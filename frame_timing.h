@@ -0,0 +1,294 @@
+#pragma once
+
+#ifndef FRAME_TIMING_H
+#define FRAME_TIMING_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <glad/glad.h>
+#include <iostream>
+#include <ostream>
+#include <vector>
+
+namespace frame_timing {
+    // Log-linear histogram of durations: 16 buckets per power of two nanoseconds, so percentiles
+    // are within about 3% of the recorded values at any scale.
+    class Histogram {
+        static constexpr uint32_t sub_buckets = 16;
+        static constexpr uint32_t sub_bucket_bits = 4;
+        // 2^40 ns is about 18 minutes, anything longer lands in the last bucket
+        static constexpr uint32_t max_exponent = 40;
+        static constexpr size_t bucket_count = (max_exponent - sub_bucket_bits + 2) * sub_buckets;
+
+        std::array<uint32_t, bucket_count> counts_ {};
+        uint64_t count_ { 0 };
+
+        static auto bucket_of(uint64_t nanoseconds) -> size_t;
+        static auto value_of(size_t bucket) -> uint64_t;
+
+    public:
+        auto record(std::chrono::nanoseconds duration) -> void;
+        auto count() const -> uint64_t;
+        // `fraction` in [0, 1], e.g. 0.99 for p99. Zero when nothing was recorded.
+        auto percentile(double fraction) const -> std::chrono::nanoseconds;
+        auto clear() -> void;
+    };
+
+    // Times named passes of each frame on the CPU and, with GL_TIMESTAMP queries, on the GPU.
+    // Queries are read back frames_in_flight frames later and only once the driver reports them
+    // available, so timing never stalls the pipeline; results that are still not in are dropped.
+    // Passes must not nest.
+    class FrameTimer {
+        static constexpr size_t frames_in_flight = 4;
+        static constexpr size_t max_passes = 16;
+
+        struct Pass {
+            const char* name;
+            Histogram cpu;
+            Histogram gpu;
+        };
+
+        struct Frame {
+            // start and end timestamp for each pass recorded this frame
+            std::array<uint32_t, max_passes * 2> queries {};
+            std::array<size_t, max_passes> passes {};
+            size_t pass_count { 0 };
+        };
+
+        using clock = std::chrono::steady_clock;
+
+        uint32_t report_interval_;
+        std::vector<Pass> passes_ {};
+        std::array<Frame, frames_in_flight> frames_ {};
+        Pass frame_ { "frame", {}, {} };
+
+        uint64_t frame_number_ { 0 };
+        uint64_t dropped_ { 0 };
+        bool in_frame_ { false };
+        clock::time_point frame_start_ {};
+        size_t current_pass_ { max_passes };
+        clock::time_point pass_start_ {};
+
+        auto current_frame() -> Frame&;
+        auto pass_index(const char* name) -> size_t;
+        auto collect(Frame& frame) -> void;
+
+    public:
+        // Prints a report every `report_interval` frames, never when it is 0.
+        explicit FrameTimer(uint32_t report_interval);
+        ~FrameTimer();
+
+        FrameTimer(const FrameTimer&) = delete;
+        auto operator=(const FrameTimer&) -> FrameTimer& = delete;
+
+        // The CPU frame time is measured from one begin_frame() to the next, so it includes
+        // whatever the caller does between frames, e.g. swapping buffers.
+        auto begin_frame() -> void;
+        auto begin_pass(const char* name) -> void;
+        auto end_pass() -> void;
+
+        // p50/p95/p99 in milliseconds of every pass since the last report, as one JSON object.
+        auto write_json(std::ostream& out) const -> void;
+        // Prints the JSON on a "TIMING: " line and starts new histograms.
+        auto report() -> void;
+    };
+
+    inline auto Histogram::bucket_of(const uint64_t nanoseconds) -> size_t {
+        if (nanoseconds < sub_buckets) {
+            return static_cast<size_t>(nanoseconds);
+        }
+        uint32_t exponent = 0;
+        for (auto value = nanoseconds; value > 1; value >>= 1U) {
+            ++exponent;
+        }
+        if (exponent > max_exponent) {
+            return bucket_count - 1;
+        }
+        const auto sub_bucket = (nanoseconds >> (exponent - sub_bucket_bits)) & (sub_buckets - 1);
+        return (exponent - sub_bucket_bits + 1) * sub_buckets + static_cast<size_t>(sub_bucket);
+    }
+
+    inline auto Histogram::value_of(const size_t bucket) -> uint64_t {
+        if (bucket < sub_buckets) {
+            return bucket;
+        }
+        const auto exponent = static_cast<uint32_t>(bucket / sub_buckets) + sub_bucket_bits - 1;
+        const auto sub_bucket = static_cast<uint64_t>(bucket % sub_buckets);
+        const auto width = uint64_t { 1 } << (exponent - sub_bucket_bits);
+        // middle of the bucket
+        return (sub_buckets + sub_bucket) * width + width / 2;
+    }
+
+    inline auto Histogram::record(const std::chrono::nanoseconds duration) -> void {
+        const auto nanoseconds = duration.count() < 0 ? 0 : duration.count();
+        ++this->counts_[bucket_of(static_cast<uint64_t>(nanoseconds))];
+        ++this->count_;
+    }
+
+    inline auto Histogram::count() const -> uint64_t {
+        return this->count_;
+    }
+
+    inline auto Histogram::percentile(const double fraction) const -> std::chrono::nanoseconds {
+        if (0 == this->count_) {
+            return std::chrono::nanoseconds { 0 };
+        }
+        auto rank = static_cast<uint64_t>(fraction * static_cast<double>(this->count_) + 0.5);
+        rank = rank < 1 ? 1 : rank > this->count_ ? this->count_ : rank;
+        uint64_t seen = 0;
+        for (size_t bucket = 0; bucket < bucket_count; ++bucket) {
+            seen += this->counts_[bucket];
+            if (seen >= rank) {
+                return std::chrono::nanoseconds { value_of(bucket) };
+            }
+        }
+        return std::chrono::nanoseconds { value_of(bucket_count - 1) };
+    }
+
+    inline auto Histogram::clear() -> void {
+        this->counts_.fill(0);
+        this->count_ = 0;
+    }
+
+    inline FrameTimer::FrameTimer(const uint32_t report_interval):
+        report_interval_ { report_interval } {
+        this->passes_.reserve(max_passes);
+        for (auto& frame : this->frames_) {
+            glGenQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+        }
+    }
+
+    inline FrameTimer::~FrameTimer() {
+        for (auto& frame : this->frames_) {
+            glDeleteQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+        }
+    }
+
+    inline auto FrameTimer::current_frame() -> Frame& {
+        return this->frames_[this->frame_number_ % frames_in_flight];
+    }
+
+    inline auto FrameTimer::pass_index(const char* name) -> size_t {
+        for (size_t i = 0; i < this->passes_.size(); ++i) {
+            if (this->passes_[i].name == name || 0 == std::strcmp(this->passes_[i].name, name)) {
+                return i;
+            }
+        }
+        if (this->passes_.size() == max_passes) {
+            return max_passes;
+        }
+        this->passes_.push_back(Pass { name, {}, {} });
+        return this->passes_.size() - 1;
+    }
+
+    inline auto FrameTimer::collect(Frame& frame) -> void {
+        if (0 == frame.pass_count) {
+            return;
+        }
+        const auto last_query = frame.queries[frame.pass_count * 2 - 1];
+        GLint available = 0;
+        glGetQueryObjectiv(last_query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (0 == available) {
+            ++this->dropped_;
+            frame.pass_count = 0;
+            return;
+        }
+
+        // queries complete in order, so the others are available too
+        uint64_t first = 0;
+        uint64_t last = 0;
+        for (size_t i = 0; i < frame.pass_count; ++i) {
+            uint64_t start = 0;
+            uint64_t end = 0;
+            glGetQueryObjectui64v(frame.queries[i * 2], GL_QUERY_RESULT, &start);
+            glGetQueryObjectui64v(frame.queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+            this->passes_[frame.passes[i]].gpu.record(
+                std::chrono::nanoseconds { static_cast<int64_t>(end - start) }
+            );
+            first = i == 0 ? start : first;
+            last = end;
+        }
+        this->frame_.gpu.record(std::chrono::nanoseconds { static_cast<int64_t>(last - first) });
+        frame.pass_count = 0;
+    }
+
+    inline auto FrameTimer::begin_frame() -> void {
+        const auto now = clock::now();
+        if (this->in_frame_) {
+            this->frame_.cpu.record(now - this->frame_start_);
+            ++this->frame_number_;
+            if (0 != this->report_interval_ && 0 == this->frame_number_ % this->report_interval_) {
+                this->report();
+            }
+        }
+        this->in_frame_ = true;
+        this->frame_start_ = now;
+        // this slot was last used frames_in_flight frames ago
+        this->collect(this->current_frame());
+    }
+
+    inline auto FrameTimer::begin_pass(const char* name) -> void {
+        auto& frame = this->current_frame();
+        this->current_pass_ = frame.pass_count == max_passes ? max_passes : this->pass_index(name);
+        if (this->current_pass_ == max_passes) {
+            return;
+        }
+        this->pass_start_ = clock::now();
+        frame.passes[frame.pass_count] = this->current_pass_;
+        glQueryCounter(frame.queries[frame.pass_count * 2], GL_TIMESTAMP);
+    }
+
+    inline auto FrameTimer::end_pass() -> void {
+        if (this->current_pass_ == max_passes) {
+            return;
+        }
+        auto& frame = this->current_frame();
+        glQueryCounter(frame.queries[frame.pass_count * 2 + 1], GL_TIMESTAMP);
+        ++frame.pass_count;
+        this->passes_[this->current_pass_].cpu.record(clock::now() - this->pass_start_);
+        this->current_pass_ = max_passes;
+    }
+
+    inline auto FrameTimer::write_json(std::ostream& out) const -> void {
+        const auto write_histogram = [&out](const Histogram& histogram) {
+            using milliseconds = std::chrono::duration<double, std::milli>;
+            out << "{\"count\":" << histogram.count()
+                << ",\"p50\":" << milliseconds { histogram.percentile(0.50) }.count()
+                << ",\"p95\":" << milliseconds { histogram.percentile(0.95) }.count()
+                << ",\"p99\":" << milliseconds { histogram.percentile(0.99) }.count() << "}";
+        };
+        const auto write_pass = [&](const Pass& pass) {
+            out << "{\"name\":\"" << pass.name << "\",\"cpu_ms\":";
+            write_histogram(pass.cpu);
+            out << ",\"gpu_ms\":";
+            write_histogram(pass.gpu);
+            out << "}";
+        };
+
+        out << "{\"frames\":" << this->frame_number_ << ",\"dropped_queries\":" << this->dropped_
+            << ",\"passes\":[";
+        write_pass(this->frame_);
+        for (const auto& pass : this->passes_) {
+            out << ",";
+            write_pass(pass);
+        }
+        out << "]}";
+    }
+
+    inline auto FrameTimer::report() -> void {
+        std::cout << "TIMING: ";
+        this->write_json(std::cout);
+        std::cout << '\n';
+
+        this->frame_.cpu.clear();
+        this->frame_.gpu.clear();
+        for (auto& pass : this->passes_) {
+            pass.cpu.clear();
+            pass.gpu.clear();
+        }
+    }
+} // namespace frame_timing
+
+#endif
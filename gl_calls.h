@@ -0,0 +1,158 @@
+#pragma once
+
+#ifndef GL_CALLS_H
+#define GL_CALLS_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <glad/glad.h>
+#include <iostream>
+#include <numeric>
+#include <type_traits>
+
+#include "gl_entry_points.h"
+
+// Counts and times calls into the driver by pointing glad's function pointers at generated
+// hooks. Nothing is hooked until set_enabled(true), and turning it off puts the driver's
+// pointers back, so a disabled layer costs nothing.
+namespace gl_calls {
+    using gl_entry_points::EntryPoint;
+    constexpr auto entry_point_count = gl_entry_points::count;
+
+    struct CallStats {
+        uint64_t calls { 0 };
+        std::chrono::nanoseconds time { 0 };
+    };
+
+    namespace detail {
+        using gl_entry_points::Proc;
+
+        struct Counter {
+            std::atomic<uint64_t> calls { 0 };
+            std::atomic<int64_t> nanoseconds { 0 };
+        };
+
+        struct State {
+            bool enabled { false };
+            // the driver's pointers, kept after disabling so a thread still inside a hook can
+            // finish its call
+            std::array<Proc, entry_point_count> originals {};
+            std::array<Counter, entry_point_count> counters {};
+            std::array<CallStats, entry_point_count> last_frame {};
+        };
+
+        inline State state {};
+
+        template <size_t Index, typename Function>
+        struct Hook;
+
+        // Any thread may call through a hook, e.g. the shader compiler's, so the counters are
+        // atomic.
+        template <size_t Index, typename Return, typename... Args>
+        struct Hook<Index, Return (APIENTRYP)(Args...)> {
+            static auto APIENTRY call(Args... args) -> Return {
+                using Function = Return (APIENTRYP)(Args...);
+                const auto original = reinterpret_cast<Function>(state.originals[Index]);
+                const auto start = std::chrono::steady_clock::now();
+                const auto record = [start] {
+                    auto& counter = state.counters[Index];
+                    counter.calls.fetch_add(1, std::memory_order_relaxed);
+                    counter.nanoseconds.fetch_add(
+                        (std::chrono::steady_clock::now() - start).count(),
+                        std::memory_order_relaxed
+                    );
+                };
+                if constexpr (std::is_void_v<Return>) {
+                    original(args...);
+                    record();
+                } else {
+                    const auto result = original(args...);
+                    record();
+                    return result;
+                }
+            }
+        };
+
+        template <size_t Index, typename Function>
+        auto swap(Function& pointer, const bool enable) -> void {
+            constexpr Function hook = &Hook<Index, Function>::call;
+            auto& original = state.originals[Index];
+            if (enable && pointer != nullptr && pointer != hook) {
+                original = reinterpret_cast<Proc>(pointer);
+                pointer = hook;
+            } else if (!enable && pointer == hook) {
+                pointer = reinterpret_cast<Function>(original);
+            }
+        }
+    } // namespace detail
+
+    // Call with every glad pointer loaded and between frames; other threads keep working, but
+    // may be counted or not while the pointers change.
+    inline auto set_enabled(const bool enabled) -> void {
+        detail::state.enabled = enabled;
+#define GL_ENTRY_POINT(name, type) \
+    detail::swap<gl_entry_points::index(EntryPoint::name)>(glad_gl##name, enabled);
+#include "gl_entry_points.inl"
+#undef GL_ENTRY_POINT
+    }
+
+    inline auto enabled() -> bool {
+        return detail::state.enabled;
+    }
+
+    // Moves the counts gathered since the previous call into last_frame().
+    inline auto begin_frame() -> void {
+        if (!detail::state.enabled) {
+            return;
+        }
+        for (size_t i = 0; i < entry_point_count; ++i) {
+            auto& counter = detail::state.counters[i];
+            detail::state.last_frame[i] = CallStats {
+                counter.calls.exchange(0, std::memory_order_relaxed),
+                std::chrono::nanoseconds {
+                    counter.nanoseconds.exchange(0, std::memory_order_relaxed)
+                },
+            };
+        }
+    }
+
+    inline auto last_frame(const EntryPoint entry_point) -> const CallStats& {
+        return detail::state.last_frame[gl_entry_points::index(entry_point)];
+    }
+
+    // Prints the `top` entry points the last frame spent the most driver time in.
+    inline auto report(const size_t top) -> void {
+        const auto& last_frame = detail::state.last_frame;
+        std::array<size_t, entry_point_count> order {};
+        std::iota(order.begin(), order.end(), size_t { 0 });
+        const auto shown = std::min(top, entry_point_count);
+        std::partial_sort(
+            order.begin(),
+            order.begin() + static_cast<std::ptrdiff_t>(shown),
+            order.end(),
+            [&last_frame](const size_t a, const size_t b) {
+                return last_frame[a].time > last_frame[b].time;
+            }
+        );
+
+        using milliseconds = std::chrono::duration<double, std::milli>;
+        uint64_t calls = 0;
+        std::chrono::nanoseconds time { 0 };
+        for (const auto& stats : last_frame) {
+            calls += stats.calls;
+            time += stats.time;
+        }
+        std::cout << "gl calls last frame: " << calls << " calls, "
+            << milliseconds { time }.count() << " ms in the driver" << '\n';
+        for (size_t i = 0; i < shown && 0 != last_frame[order[i]].calls; ++i) {
+            const auto& stats = last_frame[order[i]];
+            std::cout << "    " << gl_entry_points::names[order[i]] << ": " << stats.calls
+                << " calls, " << milliseconds { stats.time }.count() << " ms" << '\n';
+        }
+    }
+} // namespace gl_calls
+
+#endif
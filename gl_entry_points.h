@@ -0,0 +1,36 @@
+#pragma once
+
+#ifndef GL_ENTRY_POINTS_H
+#define GL_ENTRY_POINTS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <glad/glad.h>
+
+// Index and name of every function pointer glad declares, from gl_entry_points.inl.
+namespace gl_entry_points {
+    enum class EntryPoint : uint32_t {
+#define GL_ENTRY_POINT(name, type) name,
+#include "gl_entry_points.inl"
+#undef GL_ENTRY_POINT
+        count,
+    };
+
+    constexpr auto count = static_cast<size_t>(EntryPoint::count);
+
+    constexpr std::array<const char*, count> names {
+#define GL_ENTRY_POINT(name, type) "gl" #name,
+#include "gl_entry_points.inl"
+#undef GL_ENTRY_POINT
+    };
+
+    // Common type to store any of them in; cast back to the entry point's own type to call it.
+    using Proc = void (APIENTRYP)();
+
+    constexpr auto index(const EntryPoint entry_point) -> size_t {
+        return static_cast<size_t>(entry_point);
+    }
+} // namespace gl_entry_points
+
+#endif
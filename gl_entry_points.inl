@@ -0,0 +1,378 @@
+// Every entry point glad loads for OpenGL 3.3 core, as GL_ENTRY_POINT(name without the gl prefix,
+// function pointer type). The prefix is left off because glad #defines every glXxx name to its
+// pointer. Generated from Libraries/include/glad/glad.h; after updating glad, regenerate with
+//     sed -n 's/^GLAPI \(PFNGL[A-Z0-9_]*PROC\) glad_gl\([A-Za-z0-9_]*\);$/GL_ENTRY_POINT(\2, \1)/p'
+GL_ENTRY_POINT(CullFace, PFNGLCULLFACEPROC)
+GL_ENTRY_POINT(FrontFace, PFNGLFRONTFACEPROC)
+GL_ENTRY_POINT(Hint, PFNGLHINTPROC)
+GL_ENTRY_POINT(LineWidth, PFNGLLINEWIDTHPROC)
+GL_ENTRY_POINT(PointSize, PFNGLPOINTSIZEPROC)
+GL_ENTRY_POINT(PolygonMode, PFNGLPOLYGONMODEPROC)
+GL_ENTRY_POINT(Scissor, PFNGLSCISSORPROC)
+GL_ENTRY_POINT(TexParameterf, PFNGLTEXPARAMETERFPROC)
+GL_ENTRY_POINT(TexParameterfv, PFNGLTEXPARAMETERFVPROC)
+GL_ENTRY_POINT(TexParameteri, PFNGLTEXPARAMETERIPROC)
+GL_ENTRY_POINT(TexParameteriv, PFNGLTEXPARAMETERIVPROC)
+GL_ENTRY_POINT(TexImage1D, PFNGLTEXIMAGE1DPROC)
+GL_ENTRY_POINT(TexImage2D, PFNGLTEXIMAGE2DPROC)
+GL_ENTRY_POINT(DrawBuffer, PFNGLDRAWBUFFERPROC)
+GL_ENTRY_POINT(Clear, PFNGLCLEARPROC)
+GL_ENTRY_POINT(ClearColor, PFNGLCLEARCOLORPROC)
+GL_ENTRY_POINT(ClearStencil, PFNGLCLEARSTENCILPROC)
+GL_ENTRY_POINT(ClearDepth, PFNGLCLEARDEPTHPROC)
+GL_ENTRY_POINT(StencilMask, PFNGLSTENCILMASKPROC)
+GL_ENTRY_POINT(ColorMask, PFNGLCOLORMASKPROC)
+GL_ENTRY_POINT(DepthMask, PFNGLDEPTHMASKPROC)
+GL_ENTRY_POINT(Disable, PFNGLDISABLEPROC)
+GL_ENTRY_POINT(Enable, PFNGLENABLEPROC)
+GL_ENTRY_POINT(Finish, PFNGLFINISHPROC)
+GL_ENTRY_POINT(Flush, PFNGLFLUSHPROC)
+GL_ENTRY_POINT(BlendFunc, PFNGLBLENDFUNCPROC)
+GL_ENTRY_POINT(LogicOp, PFNGLLOGICOPPROC)
+GL_ENTRY_POINT(StencilFunc, PFNGLSTENCILFUNCPROC)
+GL_ENTRY_POINT(StencilOp, PFNGLSTENCILOPPROC)
+GL_ENTRY_POINT(DepthFunc, PFNGLDEPTHFUNCPROC)
+GL_ENTRY_POINT(PixelStoref, PFNGLPIXELSTOREFPROC)
+GL_ENTRY_POINT(PixelStorei, PFNGLPIXELSTOREIPROC)
+GL_ENTRY_POINT(ReadBuffer, PFNGLREADBUFFERPROC)
+GL_ENTRY_POINT(ReadPixels, PFNGLREADPIXELSPROC)
+GL_ENTRY_POINT(GetBooleanv, PFNGLGETBOOLEANVPROC)
+GL_ENTRY_POINT(GetDoublev, PFNGLGETDOUBLEVPROC)
+GL_ENTRY_POINT(GetError, PFNGLGETERRORPROC)
+GL_ENTRY_POINT(GetFloatv, PFNGLGETFLOATVPROC)
+GL_ENTRY_POINT(GetIntegerv, PFNGLGETINTEGERVPROC)
+GL_ENTRY_POINT(GetString, PFNGLGETSTRINGPROC)
+GL_ENTRY_POINT(GetTexImage, PFNGLGETTEXIMAGEPROC)
+GL_ENTRY_POINT(GetTexParameterfv, PFNGLGETTEXPARAMETERFVPROC)
+GL_ENTRY_POINT(GetTexParameteriv, PFNGLGETTEXPARAMETERIVPROC)
+GL_ENTRY_POINT(GetTexLevelParameterfv, PFNGLGETTEXLEVELPARAMETERFVPROC)
+GL_ENTRY_POINT(GetTexLevelParameteriv, PFNGLGETTEXLEVELPARAMETERIVPROC)
+GL_ENTRY_POINT(IsEnabled, PFNGLISENABLEDPROC)
+GL_ENTRY_POINT(DepthRange, PFNGLDEPTHRANGEPROC)
+GL_ENTRY_POINT(Viewport, PFNGLVIEWPORTPROC)
+GL_ENTRY_POINT(DrawArrays, PFNGLDRAWARRAYSPROC)
+GL_ENTRY_POINT(DrawElements, PFNGLDRAWELEMENTSPROC)
+GL_ENTRY_POINT(PolygonOffset, PFNGLPOLYGONOFFSETPROC)
+GL_ENTRY_POINT(CopyTexImage1D, PFNGLCOPYTEXIMAGE1DPROC)
+GL_ENTRY_POINT(CopyTexImage2D, PFNGLCOPYTEXIMAGE2DPROC)
+GL_ENTRY_POINT(CopyTexSubImage1D, PFNGLCOPYTEXSUBIMAGE1DPROC)
+GL_ENTRY_POINT(CopyTexSubImage2D, PFNGLCOPYTEXSUBIMAGE2DPROC)
+GL_ENTRY_POINT(TexSubImage1D, PFNGLTEXSUBIMAGE1DPROC)
+GL_ENTRY_POINT(TexSubImage2D, PFNGLTEXSUBIMAGE2DPROC)
+GL_ENTRY_POINT(BindTexture, PFNGLBINDTEXTUREPROC)
+GL_ENTRY_POINT(DeleteTextures, PFNGLDELETETEXTURESPROC)
+GL_ENTRY_POINT(GenTextures, PFNGLGENTEXTURESPROC)
+GL_ENTRY_POINT(IsTexture, PFNGLISTEXTUREPROC)
+GL_ENTRY_POINT(DrawRangeElements, PFNGLDRAWRANGEELEMENTSPROC)
+GL_ENTRY_POINT(TexImage3D, PFNGLTEXIMAGE3DPROC)
+GL_ENTRY_POINT(TexSubImage3D, PFNGLTEXSUBIMAGE3DPROC)
+GL_ENTRY_POINT(CopyTexSubImage3D, PFNGLCOPYTEXSUBIMAGE3DPROC)
+GL_ENTRY_POINT(ActiveTexture, PFNGLACTIVETEXTUREPROC)
+GL_ENTRY_POINT(SampleCoverage, PFNGLSAMPLECOVERAGEPROC)
+GL_ENTRY_POINT(CompressedTexImage3D, PFNGLCOMPRESSEDTEXIMAGE3DPROC)
+GL_ENTRY_POINT(CompressedTexImage2D, PFNGLCOMPRESSEDTEXIMAGE2DPROC)
+GL_ENTRY_POINT(CompressedTexImage1D, PFNGLCOMPRESSEDTEXIMAGE1DPROC)
+GL_ENTRY_POINT(CompressedTexSubImage3D, PFNGLCOMPRESSEDTEXSUBIMAGE3DPROC)
+GL_ENTRY_POINT(CompressedTexSubImage2D, PFNGLCOMPRESSEDTEXSUBIMAGE2DPROC)
+GL_ENTRY_POINT(CompressedTexSubImage1D, PFNGLCOMPRESSEDTEXSUBIMAGE1DPROC)
+GL_ENTRY_POINT(GetCompressedTexImage, PFNGLGETCOMPRESSEDTEXIMAGEPROC)
+GL_ENTRY_POINT(BlendFuncSeparate, PFNGLBLENDFUNCSEPARATEPROC)
+GL_ENTRY_POINT(MultiDrawArrays, PFNGLMULTIDRAWARRAYSPROC)
+GL_ENTRY_POINT(MultiDrawElements, PFNGLMULTIDRAWELEMENTSPROC)
+GL_ENTRY_POINT(PointParameterf, PFNGLPOINTPARAMETERFPROC)
+GL_ENTRY_POINT(PointParameterfv, PFNGLPOINTPARAMETERFVPROC)
+GL_ENTRY_POINT(PointParameteri, PFNGLPOINTPARAMETERIPROC)
+GL_ENTRY_POINT(PointParameteriv, PFNGLPOINTPARAMETERIVPROC)
+GL_ENTRY_POINT(BlendColor, PFNGLBLENDCOLORPROC)
+GL_ENTRY_POINT(BlendEquation, PFNGLBLENDEQUATIONPROC)
+GL_ENTRY_POINT(GenQueries, PFNGLGENQUERIESPROC)
+GL_ENTRY_POINT(DeleteQueries, PFNGLDELETEQUERIESPROC)
+GL_ENTRY_POINT(IsQuery, PFNGLISQUERYPROC)
+GL_ENTRY_POINT(BeginQuery, PFNGLBEGINQUERYPROC)
+GL_ENTRY_POINT(EndQuery, PFNGLENDQUERYPROC)
+GL_ENTRY_POINT(GetQueryiv, PFNGLGETQUERYIVPROC)
+GL_ENTRY_POINT(GetQueryObjectiv, PFNGLGETQUERYOBJECTIVPROC)
+GL_ENTRY_POINT(GetQueryObjectuiv, PFNGLGETQUERYOBJECTUIVPROC)
+GL_ENTRY_POINT(BindBuffer, PFNGLBINDBUFFERPROC)
+GL_ENTRY_POINT(DeleteBuffers, PFNGLDELETEBUFFERSPROC)
+GL_ENTRY_POINT(GenBuffers, PFNGLGENBUFFERSPROC)
+GL_ENTRY_POINT(IsBuffer, PFNGLISBUFFERPROC)
+GL_ENTRY_POINT(BufferData, PFNGLBUFFERDATAPROC)
+GL_ENTRY_POINT(BufferSubData, PFNGLBUFFERSUBDATAPROC)
+GL_ENTRY_POINT(GetBufferSubData, PFNGLGETBUFFERSUBDATAPROC)
+GL_ENTRY_POINT(MapBuffer, PFNGLMAPBUFFERPROC)
+GL_ENTRY_POINT(UnmapBuffer, PFNGLUNMAPBUFFERPROC)
+GL_ENTRY_POINT(GetBufferParameteriv, PFNGLGETBUFFERPARAMETERIVPROC)
+GL_ENTRY_POINT(GetBufferPointerv, PFNGLGETBUFFERPOINTERVPROC)
+GL_ENTRY_POINT(BlendEquationSeparate, PFNGLBLENDEQUATIONSEPARATEPROC)
+GL_ENTRY_POINT(DrawBuffers, PFNGLDRAWBUFFERSPROC)
+GL_ENTRY_POINT(StencilOpSeparate, PFNGLSTENCILOPSEPARATEPROC)
+GL_ENTRY_POINT(StencilFuncSeparate, PFNGLSTENCILFUNCSEPARATEPROC)
+GL_ENTRY_POINT(StencilMaskSeparate, PFNGLSTENCILMASKSEPARATEPROC)
+GL_ENTRY_POINT(AttachShader, PFNGLATTACHSHADERPROC)
+GL_ENTRY_POINT(BindAttribLocation, PFNGLBINDATTRIBLOCATIONPROC)
+GL_ENTRY_POINT(CompileShader, PFNGLCOMPILESHADERPROC)
+GL_ENTRY_POINT(CreateProgram, PFNGLCREATEPROGRAMPROC)
+GL_ENTRY_POINT(CreateShader, PFNGLCREATESHADERPROC)
+GL_ENTRY_POINT(DeleteProgram, PFNGLDELETEPROGRAMPROC)
+GL_ENTRY_POINT(DeleteShader, PFNGLDELETESHADERPROC)
+GL_ENTRY_POINT(DetachShader, PFNGLDETACHSHADERPROC)
+GL_ENTRY_POINT(DisableVertexAttribArray, PFNGLDISABLEVERTEXATTRIBARRAYPROC)
+GL_ENTRY_POINT(EnableVertexAttribArray, PFNGLENABLEVERTEXATTRIBARRAYPROC)
+GL_ENTRY_POINT(GetActiveAttrib, PFNGLGETACTIVEATTRIBPROC)
+GL_ENTRY_POINT(GetActiveUniform, PFNGLGETACTIVEUNIFORMPROC)
+GL_ENTRY_POINT(GetAttachedShaders, PFNGLGETATTACHEDSHADERSPROC)
+GL_ENTRY_POINT(GetAttribLocation, PFNGLGETATTRIBLOCATIONPROC)
+GL_ENTRY_POINT(GetProgramiv, PFNGLGETPROGRAMIVPROC)
+GL_ENTRY_POINT(GetProgramInfoLog, PFNGLGETPROGRAMINFOLOGPROC)
+GL_ENTRY_POINT(GetShaderiv, PFNGLGETSHADERIVPROC)
+GL_ENTRY_POINT(GetShaderInfoLog, PFNGLGETSHADERINFOLOGPROC)
+GL_ENTRY_POINT(GetShaderSource, PFNGLGETSHADERSOURCEPROC)
+GL_ENTRY_POINT(GetUniformLocation, PFNGLGETUNIFORMLOCATIONPROC)
+GL_ENTRY_POINT(GetUniformfv, PFNGLGETUNIFORMFVPROC)
+GL_ENTRY_POINT(GetUniformiv, PFNGLGETUNIFORMIVPROC)
+GL_ENTRY_POINT(GetVertexAttribdv, PFNGLGETVERTEXATTRIBDVPROC)
+GL_ENTRY_POINT(GetVertexAttribfv, PFNGLGETVERTEXATTRIBFVPROC)
+GL_ENTRY_POINT(GetVertexAttribiv, PFNGLGETVERTEXATTRIBIVPROC)
+GL_ENTRY_POINT(GetVertexAttribPointerv, PFNGLGETVERTEXATTRIBPOINTERVPROC)
+GL_ENTRY_POINT(IsProgram, PFNGLISPROGRAMPROC)
+GL_ENTRY_POINT(IsShader, PFNGLISSHADERPROC)
+GL_ENTRY_POINT(LinkProgram, PFNGLLINKPROGRAMPROC)
+GL_ENTRY_POINT(ShaderSource, PFNGLSHADERSOURCEPROC)
+GL_ENTRY_POINT(UseProgram, PFNGLUSEPROGRAMPROC)
+GL_ENTRY_POINT(Uniform1f, PFNGLUNIFORM1FPROC)
+GL_ENTRY_POINT(Uniform2f, PFNGLUNIFORM2FPROC)
+GL_ENTRY_POINT(Uniform3f, PFNGLUNIFORM3FPROC)
+GL_ENTRY_POINT(Uniform4f, PFNGLUNIFORM4FPROC)
+GL_ENTRY_POINT(Uniform1i, PFNGLUNIFORM1IPROC)
+GL_ENTRY_POINT(Uniform2i, PFNGLUNIFORM2IPROC)
+GL_ENTRY_POINT(Uniform3i, PFNGLUNIFORM3IPROC)
+GL_ENTRY_POINT(Uniform4i, PFNGLUNIFORM4IPROC)
+GL_ENTRY_POINT(Uniform1fv, PFNGLUNIFORM1FVPROC)
+GL_ENTRY_POINT(Uniform2fv, PFNGLUNIFORM2FVPROC)
+GL_ENTRY_POINT(Uniform3fv, PFNGLUNIFORM3FVPROC)
+GL_ENTRY_POINT(Uniform4fv, PFNGLUNIFORM4FVPROC)
+GL_ENTRY_POINT(Uniform1iv, PFNGLUNIFORM1IVPROC)
+GL_ENTRY_POINT(Uniform2iv, PFNGLUNIFORM2IVPROC)
+GL_ENTRY_POINT(Uniform3iv, PFNGLUNIFORM3IVPROC)
+GL_ENTRY_POINT(Uniform4iv, PFNGLUNIFORM4IVPROC)
+GL_ENTRY_POINT(UniformMatrix2fv, PFNGLUNIFORMMATRIX2FVPROC)
+GL_ENTRY_POINT(UniformMatrix3fv, PFNGLUNIFORMMATRIX3FVPROC)
+GL_ENTRY_POINT(UniformMatrix4fv, PFNGLUNIFORMMATRIX4FVPROC)
+GL_ENTRY_POINT(ValidateProgram, PFNGLVALIDATEPROGRAMPROC)
+GL_ENTRY_POINT(VertexAttrib1d, PFNGLVERTEXATTRIB1DPROC)
+GL_ENTRY_POINT(VertexAttrib1dv, PFNGLVERTEXATTRIB1DVPROC)
+GL_ENTRY_POINT(VertexAttrib1f, PFNGLVERTEXATTRIB1FPROC)
+GL_ENTRY_POINT(VertexAttrib1fv, PFNGLVERTEXATTRIB1FVPROC)
+GL_ENTRY_POINT(VertexAttrib1s, PFNGLVERTEXATTRIB1SPROC)
+GL_ENTRY_POINT(VertexAttrib1sv, PFNGLVERTEXATTRIB1SVPROC)
+GL_ENTRY_POINT(VertexAttrib2d, PFNGLVERTEXATTRIB2DPROC)
+GL_ENTRY_POINT(VertexAttrib2dv, PFNGLVERTEXATTRIB2DVPROC)
+GL_ENTRY_POINT(VertexAttrib2f, PFNGLVERTEXATTRIB2FPROC)
+GL_ENTRY_POINT(VertexAttrib2fv, PFNGLVERTEXATTRIB2FVPROC)
+GL_ENTRY_POINT(VertexAttrib2s, PFNGLVERTEXATTRIB2SPROC)
+GL_ENTRY_POINT(VertexAttrib2sv, PFNGLVERTEXATTRIB2SVPROC)
+GL_ENTRY_POINT(VertexAttrib3d, PFNGLVERTEXATTRIB3DPROC)
+GL_ENTRY_POINT(VertexAttrib3dv, PFNGLVERTEXATTRIB3DVPROC)
+GL_ENTRY_POINT(VertexAttrib3f, PFNGLVERTEXATTRIB3FPROC)
+GL_ENTRY_POINT(VertexAttrib3fv, PFNGLVERTEXATTRIB3FVPROC)
+GL_ENTRY_POINT(VertexAttrib3s, PFNGLVERTEXATTRIB3SPROC)
+GL_ENTRY_POINT(VertexAttrib3sv, PFNGLVERTEXATTRIB3SVPROC)
+GL_ENTRY_POINT(VertexAttrib4Nbv, PFNGLVERTEXATTRIB4NBVPROC)
+GL_ENTRY_POINT(VertexAttrib4Niv, PFNGLVERTEXATTRIB4NIVPROC)
+GL_ENTRY_POINT(VertexAttrib4Nsv, PFNGLVERTEXATTRIB4NSVPROC)
+GL_ENTRY_POINT(VertexAttrib4Nub, PFNGLVERTEXATTRIB4NUBPROC)
+GL_ENTRY_POINT(VertexAttrib4Nubv, PFNGLVERTEXATTRIB4NUBVPROC)
+GL_ENTRY_POINT(VertexAttrib4Nuiv, PFNGLVERTEXATTRIB4NUIVPROC)
+GL_ENTRY_POINT(VertexAttrib4Nusv, PFNGLVERTEXATTRIB4NUSVPROC)
+GL_ENTRY_POINT(VertexAttrib4bv, PFNGLVERTEXATTRIB4BVPROC)
+GL_ENTRY_POINT(VertexAttrib4d, PFNGLVERTEXATTRIB4DPROC)
+GL_ENTRY_POINT(VertexAttrib4dv, PFNGLVERTEXATTRIB4DVPROC)
+GL_ENTRY_POINT(VertexAttrib4f, PFNGLVERTEXATTRIB4FPROC)
+GL_ENTRY_POINT(VertexAttrib4fv, PFNGLVERTEXATTRIB4FVPROC)
+GL_ENTRY_POINT(VertexAttrib4iv, PFNGLVERTEXATTRIB4IVPROC)
+GL_ENTRY_POINT(VertexAttrib4s, PFNGLVERTEXATTRIB4SPROC)
+GL_ENTRY_POINT(VertexAttrib4sv, PFNGLVERTEXATTRIB4SVPROC)
+GL_ENTRY_POINT(VertexAttrib4ubv, PFNGLVERTEXATTRIB4UBVPROC)
+GL_ENTRY_POINT(VertexAttrib4uiv, PFNGLVERTEXATTRIB4UIVPROC)
+GL_ENTRY_POINT(VertexAttrib4usv, PFNGLVERTEXATTRIB4USVPROC)
+GL_ENTRY_POINT(VertexAttribPointer, PFNGLVERTEXATTRIBPOINTERPROC)
+GL_ENTRY_POINT(UniformMatrix2x3fv, PFNGLUNIFORMMATRIX2X3FVPROC)
+GL_ENTRY_POINT(UniformMatrix3x2fv, PFNGLUNIFORMMATRIX3X2FVPROC)
+GL_ENTRY_POINT(UniformMatrix2x4fv, PFNGLUNIFORMMATRIX2X4FVPROC)
+GL_ENTRY_POINT(UniformMatrix4x2fv, PFNGLUNIFORMMATRIX4X2FVPROC)
+GL_ENTRY_POINT(UniformMatrix3x4fv, PFNGLUNIFORMMATRIX3X4FVPROC)
+GL_ENTRY_POINT(UniformMatrix4x3fv, PFNGLUNIFORMMATRIX4X3FVPROC)
+GL_ENTRY_POINT(ColorMaski, PFNGLCOLORMASKIPROC)
+GL_ENTRY_POINT(GetBooleani_v, PFNGLGETBOOLEANI_VPROC)
+GL_ENTRY_POINT(GetIntegeri_v, PFNGLGETINTEGERI_VPROC)
+GL_ENTRY_POINT(Enablei, PFNGLENABLEIPROC)
+GL_ENTRY_POINT(Disablei, PFNGLDISABLEIPROC)
+GL_ENTRY_POINT(IsEnabledi, PFNGLISENABLEDIPROC)
+GL_ENTRY_POINT(BeginTransformFeedback, PFNGLBEGINTRANSFORMFEEDBACKPROC)
+GL_ENTRY_POINT(EndTransformFeedback, PFNGLENDTRANSFORMFEEDBACKPROC)
+GL_ENTRY_POINT(BindBufferRange, PFNGLBINDBUFFERRANGEPROC)
+GL_ENTRY_POINT(BindBufferBase, PFNGLBINDBUFFERBASEPROC)
+GL_ENTRY_POINT(TransformFeedbackVaryings, PFNGLTRANSFORMFEEDBACKVARYINGSPROC)
+GL_ENTRY_POINT(GetTransformFeedbackVarying, PFNGLGETTRANSFORMFEEDBACKVARYINGPROC)
+GL_ENTRY_POINT(ClampColor, PFNGLCLAMPCOLORPROC)
+GL_ENTRY_POINT(BeginConditionalRender, PFNGLBEGINCONDITIONALRENDERPROC)
+GL_ENTRY_POINT(EndConditionalRender, PFNGLENDCONDITIONALRENDERPROC)
+GL_ENTRY_POINT(VertexAttribIPointer, PFNGLVERTEXATTRIBIPOINTERPROC)
+GL_ENTRY_POINT(GetVertexAttribIiv, PFNGLGETVERTEXATTRIBIIVPROC)
+GL_ENTRY_POINT(GetVertexAttribIuiv, PFNGLGETVERTEXATTRIBIUIVPROC)
+GL_ENTRY_POINT(VertexAttribI1i, PFNGLVERTEXATTRIBI1IPROC)
+GL_ENTRY_POINT(VertexAttribI2i, PFNGLVERTEXATTRIBI2IPROC)
+GL_ENTRY_POINT(VertexAttribI3i, PFNGLVERTEXATTRIBI3IPROC)
+GL_ENTRY_POINT(VertexAttribI4i, PFNGLVERTEXATTRIBI4IPROC)
+GL_ENTRY_POINT(VertexAttribI1ui, PFNGLVERTEXATTRIBI1UIPROC)
+GL_ENTRY_POINT(VertexAttribI2ui, PFNGLVERTEXATTRIBI2UIPROC)
+GL_ENTRY_POINT(VertexAttribI3ui, PFNGLVERTEXATTRIBI3UIPROC)
+GL_ENTRY_POINT(VertexAttribI4ui, PFNGLVERTEXATTRIBI4UIPROC)
+GL_ENTRY_POINT(VertexAttribI1iv, PFNGLVERTEXATTRIBI1IVPROC)
+GL_ENTRY_POINT(VertexAttribI2iv, PFNGLVERTEXATTRIBI2IVPROC)
+GL_ENTRY_POINT(VertexAttribI3iv, PFNGLVERTEXATTRIBI3IVPROC)
+GL_ENTRY_POINT(VertexAttribI4iv, PFNGLVERTEXATTRIBI4IVPROC)
+GL_ENTRY_POINT(VertexAttribI1uiv, PFNGLVERTEXATTRIBI1UIVPROC)
+GL_ENTRY_POINT(VertexAttribI2uiv, PFNGLVERTEXATTRIBI2UIVPROC)
+GL_ENTRY_POINT(VertexAttribI3uiv, PFNGLVERTEXATTRIBI3UIVPROC)
+GL_ENTRY_POINT(VertexAttribI4uiv, PFNGLVERTEXATTRIBI4UIVPROC)
+GL_ENTRY_POINT(VertexAttribI4bv, PFNGLVERTEXATTRIBI4BVPROC)
+GL_ENTRY_POINT(VertexAttribI4sv, PFNGLVERTEXATTRIBI4SVPROC)
+GL_ENTRY_POINT(VertexAttribI4ubv, PFNGLVERTEXATTRIBI4UBVPROC)
+GL_ENTRY_POINT(VertexAttribI4usv, PFNGLVERTEXATTRIBI4USVPROC)
+GL_ENTRY_POINT(GetUniformuiv, PFNGLGETUNIFORMUIVPROC)
+GL_ENTRY_POINT(BindFragDataLocation, PFNGLBINDFRAGDATALOCATIONPROC)
+GL_ENTRY_POINT(GetFragDataLocation, PFNGLGETFRAGDATALOCATIONPROC)
+GL_ENTRY_POINT(Uniform1ui, PFNGLUNIFORM1UIPROC)
+GL_ENTRY_POINT(Uniform2ui, PFNGLUNIFORM2UIPROC)
+GL_ENTRY_POINT(Uniform3ui, PFNGLUNIFORM3UIPROC)
+GL_ENTRY_POINT(Uniform4ui, PFNGLUNIFORM4UIPROC)
+GL_ENTRY_POINT(Uniform1uiv, PFNGLUNIFORM1UIVPROC)
+GL_ENTRY_POINT(Uniform2uiv, PFNGLUNIFORM2UIVPROC)
+GL_ENTRY_POINT(Uniform3uiv, PFNGLUNIFORM3UIVPROC)
+GL_ENTRY_POINT(Uniform4uiv, PFNGLUNIFORM4UIVPROC)
+GL_ENTRY_POINT(TexParameterIiv, PFNGLTEXPARAMETERIIVPROC)
+GL_ENTRY_POINT(TexParameterIuiv, PFNGLTEXPARAMETERIUIVPROC)
+GL_ENTRY_POINT(GetTexParameterIiv, PFNGLGETTEXPARAMETERIIVPROC)
+GL_ENTRY_POINT(GetTexParameterIuiv, PFNGLGETTEXPARAMETERIUIVPROC)
+GL_ENTRY_POINT(ClearBufferiv, PFNGLCLEARBUFFERIVPROC)
+GL_ENTRY_POINT(ClearBufferuiv, PFNGLCLEARBUFFERUIVPROC)
+GL_ENTRY_POINT(ClearBufferfv, PFNGLCLEARBUFFERFVPROC)
+GL_ENTRY_POINT(ClearBufferfi, PFNGLCLEARBUFFERFIPROC)
+GL_ENTRY_POINT(GetStringi, PFNGLGETSTRINGIPROC)
+GL_ENTRY_POINT(IsRenderbuffer, PFNGLISRENDERBUFFERPROC)
+GL_ENTRY_POINT(BindRenderbuffer, PFNGLBINDRENDERBUFFERPROC)
+GL_ENTRY_POINT(DeleteRenderbuffers, PFNGLDELETERENDERBUFFERSPROC)
+GL_ENTRY_POINT(GenRenderbuffers, PFNGLGENRENDERBUFFERSPROC)
+GL_ENTRY_POINT(RenderbufferStorage, PFNGLRENDERBUFFERSTORAGEPROC)
+GL_ENTRY_POINT(GetRenderbufferParameteriv, PFNGLGETRENDERBUFFERPARAMETERIVPROC)
+GL_ENTRY_POINT(IsFramebuffer, PFNGLISFRAMEBUFFERPROC)
+GL_ENTRY_POINT(BindFramebuffer, PFNGLBINDFRAMEBUFFERPROC)
+GL_ENTRY_POINT(DeleteFramebuffers, PFNGLDELETEFRAMEBUFFERSPROC)
+GL_ENTRY_POINT(GenFramebuffers, PFNGLGENFRAMEBUFFERSPROC)
+GL_ENTRY_POINT(CheckFramebufferStatus, PFNGLCHECKFRAMEBUFFERSTATUSPROC)
+GL_ENTRY_POINT(FramebufferTexture1D, PFNGLFRAMEBUFFERTEXTURE1DPROC)
+GL_ENTRY_POINT(FramebufferTexture2D, PFNGLFRAMEBUFFERTEXTURE2DPROC)
+GL_ENTRY_POINT(FramebufferTexture3D, PFNGLFRAMEBUFFERTEXTURE3DPROC)
+GL_ENTRY_POINT(FramebufferRenderbuffer, PFNGLFRAMEBUFFERRENDERBUFFERPROC)
+GL_ENTRY_POINT(GetFramebufferAttachmentParameteriv, PFNGLGETFRAMEBUFFERATTACHMENTPARAMETERIVPROC)
+GL_ENTRY_POINT(GenerateMipmap, PFNGLGENERATEMIPMAPPROC)
+GL_ENTRY_POINT(BlitFramebuffer, PFNGLBLITFRAMEBUFFERPROC)
+GL_ENTRY_POINT(RenderbufferStorageMultisample, PFNGLRENDERBUFFERSTORAGEMULTISAMPLEPROC)
+GL_ENTRY_POINT(FramebufferTextureLayer, PFNGLFRAMEBUFFERTEXTURELAYERPROC)
+GL_ENTRY_POINT(MapBufferRange, PFNGLMAPBUFFERRANGEPROC)
+GL_ENTRY_POINT(FlushMappedBufferRange, PFNGLFLUSHMAPPEDBUFFERRANGEPROC)
+GL_ENTRY_POINT(BindVertexArray, PFNGLBINDVERTEXARRAYPROC)
+GL_ENTRY_POINT(DeleteVertexArrays, PFNGLDELETEVERTEXARRAYSPROC)
+GL_ENTRY_POINT(GenVertexArrays, PFNGLGENVERTEXARRAYSPROC)
+GL_ENTRY_POINT(IsVertexArray, PFNGLISVERTEXARRAYPROC)
+GL_ENTRY_POINT(DrawArraysInstanced, PFNGLDRAWARRAYSINSTANCEDPROC)
+GL_ENTRY_POINT(DrawElementsInstanced, PFNGLDRAWELEMENTSINSTANCEDPROC)
+GL_ENTRY_POINT(TexBuffer, PFNGLTEXBUFFERPROC)
+GL_ENTRY_POINT(PrimitiveRestartIndex, PFNGLPRIMITIVERESTARTINDEXPROC)
+GL_ENTRY_POINT(CopyBufferSubData, PFNGLCOPYBUFFERSUBDATAPROC)
+GL_ENTRY_POINT(GetUniformIndices, PFNGLGETUNIFORMINDICESPROC)
+GL_ENTRY_POINT(GetActiveUniformsiv, PFNGLGETACTIVEUNIFORMSIVPROC)
+GL_ENTRY_POINT(GetActiveUniformName, PFNGLGETACTIVEUNIFORMNAMEPROC)
+GL_ENTRY_POINT(GetUniformBlockIndex, PFNGLGETUNIFORMBLOCKINDEXPROC)
+GL_ENTRY_POINT(GetActiveUniformBlockiv, PFNGLGETACTIVEUNIFORMBLOCKIVPROC)
+GL_ENTRY_POINT(GetActiveUniformBlockName, PFNGLGETACTIVEUNIFORMBLOCKNAMEPROC)
+GL_ENTRY_POINT(UniformBlockBinding, PFNGLUNIFORMBLOCKBINDINGPROC)
+GL_ENTRY_POINT(DrawElementsBaseVertex, PFNGLDRAWELEMENTSBASEVERTEXPROC)
+GL_ENTRY_POINT(DrawRangeElementsBaseVertex, PFNGLDRAWRANGEELEMENTSBASEVERTEXPROC)
+GL_ENTRY_POINT(DrawElementsInstancedBaseVertex, PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXPROC)
+GL_ENTRY_POINT(MultiDrawElementsBaseVertex, PFNGLMULTIDRAWELEMENTSBASEVERTEXPROC)
+GL_ENTRY_POINT(ProvokingVertex, PFNGLPROVOKINGVERTEXPROC)
+GL_ENTRY_POINT(FenceSync, PFNGLFENCESYNCPROC)
+GL_ENTRY_POINT(IsSync, PFNGLISSYNCPROC)
+GL_ENTRY_POINT(DeleteSync, PFNGLDELETESYNCPROC)
+GL_ENTRY_POINT(ClientWaitSync, PFNGLCLIENTWAITSYNCPROC)
+GL_ENTRY_POINT(WaitSync, PFNGLWAITSYNCPROC)
+GL_ENTRY_POINT(GetInteger64v, PFNGLGETINTEGER64VPROC)
+GL_ENTRY_POINT(GetSynciv, PFNGLGETSYNCIVPROC)
+GL_ENTRY_POINT(GetInteger64i_v, PFNGLGETINTEGER64I_VPROC)
+GL_ENTRY_POINT(GetBufferParameteri64v, PFNGLGETBUFFERPARAMETERI64VPROC)
+GL_ENTRY_POINT(FramebufferTexture, PFNGLFRAMEBUFFERTEXTUREPROC)
+GL_ENTRY_POINT(TexImage2DMultisample, PFNGLTEXIMAGE2DMULTISAMPLEPROC)
+GL_ENTRY_POINT(TexImage3DMultisample, PFNGLTEXIMAGE3DMULTISAMPLEPROC)
+GL_ENTRY_POINT(GetMultisamplefv, PFNGLGETMULTISAMPLEFVPROC)
+GL_ENTRY_POINT(SampleMaski, PFNGLSAMPLEMASKIPROC)
+GL_ENTRY_POINT(BindFragDataLocationIndexed, PFNGLBINDFRAGDATALOCATIONINDEXEDPROC)
+GL_ENTRY_POINT(GetFragDataIndex, PFNGLGETFRAGDATAINDEXPROC)
+GL_ENTRY_POINT(GenSamplers, PFNGLGENSAMPLERSPROC)
+GL_ENTRY_POINT(DeleteSamplers, PFNGLDELETESAMPLERSPROC)
+GL_ENTRY_POINT(IsSampler, PFNGLISSAMPLERPROC)
+GL_ENTRY_POINT(BindSampler, PFNGLBINDSAMPLERPROC)
+GL_ENTRY_POINT(SamplerParameteri, PFNGLSAMPLERPARAMETERIPROC)
+GL_ENTRY_POINT(SamplerParameteriv, PFNGLSAMPLERPARAMETERIVPROC)
+GL_ENTRY_POINT(SamplerParameterf, PFNGLSAMPLERPARAMETERFPROC)
+GL_ENTRY_POINT(SamplerParameterfv, PFNGLSAMPLERPARAMETERFVPROC)
+GL_ENTRY_POINT(SamplerParameterIiv, PFNGLSAMPLERPARAMETERIIVPROC)
+GL_ENTRY_POINT(SamplerParameterIuiv, PFNGLSAMPLERPARAMETERIUIVPROC)
+GL_ENTRY_POINT(GetSamplerParameteriv, PFNGLGETSAMPLERPARAMETERIVPROC)
+GL_ENTRY_POINT(GetSamplerParameterIiv, PFNGLGETSAMPLERPARAMETERIIVPROC)
+GL_ENTRY_POINT(GetSamplerParameterfv, PFNGLGETSAMPLERPARAMETERFVPROC)
+GL_ENTRY_POINT(GetSamplerParameterIuiv, PFNGLGETSAMPLERPARAMETERIUIVPROC)
+GL_ENTRY_POINT(QueryCounter, PFNGLQUERYCOUNTERPROC)
+GL_ENTRY_POINT(GetQueryObjecti64v, PFNGLGETQUERYOBJECTI64VPROC)
+GL_ENTRY_POINT(GetQueryObjectui64v, PFNGLGETQUERYOBJECTUI64VPROC)
+GL_ENTRY_POINT(VertexAttribDivisor, PFNGLVERTEXATTRIBDIVISORPROC)
+GL_ENTRY_POINT(VertexAttribP1ui, PFNGLVERTEXATTRIBP1UIPROC)
+GL_ENTRY_POINT(VertexAttribP1uiv, PFNGLVERTEXATTRIBP1UIVPROC)
+GL_ENTRY_POINT(VertexAttribP2ui, PFNGLVERTEXATTRIBP2UIPROC)
+GL_ENTRY_POINT(VertexAttribP2uiv, PFNGLVERTEXATTRIBP2UIVPROC)
+GL_ENTRY_POINT(VertexAttribP3ui, PFNGLVERTEXATTRIBP3UIPROC)
+GL_ENTRY_POINT(VertexAttribP3uiv, PFNGLVERTEXATTRIBP3UIVPROC)
+GL_ENTRY_POINT(VertexAttribP4ui, PFNGLVERTEXATTRIBP4UIPROC)
+GL_ENTRY_POINT(VertexAttribP4uiv, PFNGLVERTEXATTRIBP4UIVPROC)
+GL_ENTRY_POINT(VertexP2ui, PFNGLVERTEXP2UIPROC)
+GL_ENTRY_POINT(VertexP2uiv, PFNGLVERTEXP2UIVPROC)
+GL_ENTRY_POINT(VertexP3ui, PFNGLVERTEXP3UIPROC)
+GL_ENTRY_POINT(VertexP3uiv, PFNGLVERTEXP3UIVPROC)
+GL_ENTRY_POINT(VertexP4ui, PFNGLVERTEXP4UIPROC)
+GL_ENTRY_POINT(VertexP4uiv, PFNGLVERTEXP4UIVPROC)
+GL_ENTRY_POINT(TexCoordP1ui, PFNGLTEXCOORDP1UIPROC)
+GL_ENTRY_POINT(TexCoordP1uiv, PFNGLTEXCOORDP1UIVPROC)
+GL_ENTRY_POINT(TexCoordP2ui, PFNGLTEXCOORDP2UIPROC)
+GL_ENTRY_POINT(TexCoordP2uiv, PFNGLTEXCOORDP2UIVPROC)
+GL_ENTRY_POINT(TexCoordP3ui, PFNGLTEXCOORDP3UIPROC)
+GL_ENTRY_POINT(TexCoordP3uiv, PFNGLTEXCOORDP3UIVPROC)
+GL_ENTRY_POINT(TexCoordP4ui, PFNGLTEXCOORDP4UIPROC)
+GL_ENTRY_POINT(TexCoordP4uiv, PFNGLTEXCOORDP4UIVPROC)
+GL_ENTRY_POINT(MultiTexCoordP1ui, PFNGLMULTITEXCOORDP1UIPROC)
+GL_ENTRY_POINT(MultiTexCoordP1uiv, PFNGLMULTITEXCOORDP1UIVPROC)
+GL_ENTRY_POINT(MultiTexCoordP2ui, PFNGLMULTITEXCOORDP2UIPROC)
+GL_ENTRY_POINT(MultiTexCoordP2uiv, PFNGLMULTITEXCOORDP2UIVPROC)
+GL_ENTRY_POINT(MultiTexCoordP3ui, PFNGLMULTITEXCOORDP3UIPROC)
+GL_ENTRY_POINT(MultiTexCoordP3uiv, PFNGLMULTITEXCOORDP3UIVPROC)
+GL_ENTRY_POINT(MultiTexCoordP4ui, PFNGLMULTITEXCOORDP4UIPROC)
+GL_ENTRY_POINT(MultiTexCoordP4uiv, PFNGLMULTITEXCOORDP4UIVPROC)
+GL_ENTRY_POINT(NormalP3ui, PFNGLNORMALP3UIPROC)
+GL_ENTRY_POINT(NormalP3uiv, PFNGLNORMALP3UIVPROC)
+GL_ENTRY_POINT(ColorP3ui, PFNGLCOLORP3UIPROC)
+GL_ENTRY_POINT(ColorP3uiv, PFNGLCOLORP3UIVPROC)
+GL_ENTRY_POINT(ColorP4ui, PFNGLCOLORP4UIPROC)
+GL_ENTRY_POINT(ColorP4uiv, PFNGLCOLORP4UIVPROC)
+GL_ENTRY_POINT(SecondaryColorP3ui, PFNGLSECONDARYCOLORP3UIPROC)
+GL_ENTRY_POINT(SecondaryColorP3uiv, PFNGLSECONDARYCOLORP3UIVPROC)
@@ -0,0 +1,331 @@
+#pragma once
+
+#ifndef GL_EXTENSIONS_H
+#define GL_EXTENSIONS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <glad/glad.h>
+
+// glad is generated for plain 3.3 core without extensions, so everything newer that we opt
+// into is declared and loaded here.
+
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+    #define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+    #define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+    #define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+#ifndef GL_COMPLETION_STATUS_KHR
+    #define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+#ifndef GL_MAP_PERSISTENT_BIT
+    #define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+    #define GL_MAP_COHERENT_BIT 0x0080
+#endif
+#ifndef GL_CLIENT_STORAGE_BIT
+    #define GL_CLIENT_STORAGE_BIT 0x0200
+#endif
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+    #define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+    #define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+    #define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+#ifndef GL_COMPRESSED_RGB8_ETC2
+    #define GL_COMPRESSED_RGB8_ETC2 0x9274
+#endif
+#ifndef GL_COMPRESSED_RGBA8_ETC2_EAC
+    #define GL_COMPRESSED_RGBA8_ETC2_EAC 0x9278
+#endif
+
+typedef void (APIENTRYP PFNGLGETPROGRAMBINARYPROC)(
+    GLuint program,
+    GLsizei bufSize,
+    GLsizei* length,
+    GLenum* binaryFormat,
+    void* binary
+);
+typedef void (APIENTRYP PFNGLPROGRAMBINARYPROC)(
+    GLuint program,
+    GLenum binaryFormat,
+    const void* binary,
+    GLsizei length
+);
+typedef void (APIENTRYP PFNGLPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC)(
+    GLenum target,
+    GLsizeiptr size,
+    const void* data,
+    GLbitfield flags
+);
+typedef void (APIENTRYP PFNGLTEXSTORAGE2DPROC)(
+    GLenum target,
+    GLsizei levels,
+    GLenum internalformat,
+    GLsizei width,
+    GLsizei height
+);
+typedef void (APIENTRYP PFNGLTEXSTORAGE3DPROC)(
+    GLenum target,
+    GLsizei levels,
+    GLenum internalformat,
+    GLsizei width,
+    GLsizei height,
+    GLsizei depth
+);
+typedef void (APIENTRYP PFNGLCOPYIMAGESUBDATAPROC)(
+    GLuint srcName,
+    GLenum srcTarget,
+    GLint srcLevel,
+    GLint srcX,
+    GLint srcY,
+    GLint srcZ,
+    GLuint dstName,
+    GLenum dstTarget,
+    GLint dstLevel,
+    GLint dstX,
+    GLint dstY,
+    GLint dstZ,
+    GLsizei srcWidth,
+    GLsizei srcHeight,
+    GLsizei srcDepth
+);
+
+namespace gl_extensions {
+    // The extensions we look for. The driver's list is matched against these once, in load().
+    enum class Extension : uint32_t {
+        ARB_buffer_storage,
+        ARB_copy_image,
+        ARB_ES3_compatibility,
+        ARB_get_program_binary,
+        ARB_parallel_shader_compile,
+        ARB_texture_compression_bptc,
+        ARB_texture_storage,
+        EXT_texture_compression_s3tc,
+        KHR_parallel_shader_compile,
+        count,
+    };
+
+    namespace detail {
+        constexpr auto extension_count = static_cast<size_t>(Extension::count);
+
+        constexpr std::array<const char*, extension_count> extension_names {
+            "GL_ARB_buffer_storage",
+            "GL_ARB_copy_image",
+            "GL_ARB_ES3_compatibility",
+            "GL_ARB_get_program_binary",
+            "GL_ARB_parallel_shader_compile",
+            "GL_ARB_texture_compression_bptc",
+            "GL_ARB_texture_storage",
+            "GL_EXT_texture_compression_s3tc",
+            "GL_KHR_parallel_shader_compile",
+        };
+
+        // FNV-1a, with the seed folded into the offset basis
+        constexpr auto hash(const char* name, const uint32_t seed) -> uint32_t {
+            auto hash = 2166136261U ^ seed;
+            for (; *name != '\0'; ++name) {
+                hash ^= static_cast<uint8_t>(*name);
+                hash *= 16777619U;
+            }
+            return hash;
+        }
+
+        constexpr size_t slot_count = 32;
+        constexpr uint8_t empty_slot = 0xFF;
+        // the bits have to fit Extensions::available
+        static_assert(extension_count < slot_count && extension_count <= 64);
+
+        // First seed for which every name gets a slot of its own, found at compile time.
+        constexpr auto find_seed() -> uint32_t {
+            for (uint32_t seed = 0;; ++seed) {
+                std::array<bool, slot_count> taken {};
+                auto collision = false;
+                for (const auto* const name : extension_names) {
+                    auto& slot = taken[hash(name, seed) % slot_count];
+                    collision = collision || slot;
+                    slot = true;
+                }
+                if (!collision) {
+                    return seed;
+                }
+            }
+        }
+
+        constexpr auto seed = find_seed();
+
+        constexpr auto build_slots() -> std::array<uint8_t, slot_count> {
+            std::array<uint8_t, slot_count> slots {};
+            for (auto& slot : slots) {
+                slot = empty_slot;
+            }
+            for (size_t i = 0; i < extension_count; ++i) {
+                slots[hash(extension_names[i], seed) % slot_count] = static_cast<uint8_t>(i);
+            }
+            return slots;
+        }
+
+        constexpr auto slots = build_slots();
+
+        // Index of `name` in extension_names, or extension_count for an extension we do not
+        // track. One hash and at most one strcmp, no matter how many we track.
+        inline auto find(const char* name) -> size_t {
+            const auto index = slots[hash(name, seed) % slot_count];
+            if (index == empty_slot || 0 != std::strcmp(extension_names[index], name)) {
+                return extension_count;
+            }
+            return index;
+        }
+    } // namespace detail
+
+    struct Extensions {
+        // one bit per Extension the driver reports
+        uint64_t available { 0 };
+
+        bool get_program_binary { false };
+        PFNGLGETPROGRAMBINARYPROC glGetProgramBinary { nullptr };
+        PFNGLPROGRAMBINARYPROC glProgramBinary { nullptr };
+        PFNGLPROGRAMPARAMETERIPROC glProgramParameteri { nullptr };
+
+        // KHR_parallel_shader_compile or its ARB twin, which share GL_COMPLETION_STATUS
+        bool parallel_shader_compile { false };
+        PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glMaxShaderCompilerThreads { nullptr };
+
+        // immutable buffers, which can stay mapped while the GPU reads them
+        bool buffer_storage { false };
+        PFNGLBUFFERSTORAGEPROC glBufferStorage { nullptr };
+
+        // immutable textures, every mip level allocated up front
+        bool texture_storage { false };
+        PFNGLTEXSTORAGE2DPROC glTexStorage2D { nullptr };
+        PFNGLTEXSTORAGE3DPROC glTexStorage3D { nullptr };
+
+        // texel copies between textures without a round trip through client memory
+        bool copy_image { false };
+        PFNGLCOPYIMAGESUBDATAPROC glCopyImageSubData { nullptr };
+
+        // block compressed formats glCompressedTexImage2D takes: BC1 and BC3, BC7, and ETC2
+        // with EAC alpha
+        bool texture_compression_s3tc { false };
+        bool texture_compression_bptc { false };
+        bool texture_compression_etc2 { false };
+    };
+
+    inline auto get() -> Extensions& {
+        static Extensions extensions {};
+        return extensions;
+    }
+
+    inline auto is_core(const int major, const int minor) -> bool {
+        return GLVersion.major > major || (GLVersion.major == major && GLVersion.minor >= minor);
+    }
+
+    // Reads the driver's extension list straight from glGetStringi, without copying it.
+    inline auto detect() -> uint64_t {
+        uint64_t available = 0;
+        auto count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (auto i = 0; i < count; ++i) {
+            const auto* const extension =
+                reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+            if (extension == nullptr) {
+                continue;
+            }
+            const auto index = detail::find(extension);
+            if (index != detail::extension_count) {
+                available |= uint64_t { 1 } << index;
+            }
+        }
+        return available;
+    }
+
+    // Valid after load().
+    inline auto has(const Extension extension) -> bool {
+        return 0 != (get().available & (uint64_t { 1 } << static_cast<uint32_t>(extension)));
+    }
+
+    // Must run after gladLoadGLLoader or gl_loader::load_lazy, with the same loader.
+    inline auto load(const GLADloadproc load) -> void {
+        auto& extensions = get();
+        extensions = Extensions {};
+        extensions.available = detect();
+
+        if (is_core(4, 1) || has(Extension::ARB_get_program_binary)) {
+            extensions.glGetProgramBinary =
+                reinterpret_cast<PFNGLGETPROGRAMBINARYPROC>(load("glGetProgramBinary"));
+            extensions.glProgramBinary =
+                reinterpret_cast<PFNGLPROGRAMBINARYPROC>(load("glProgramBinary"));
+            extensions.glProgramParameteri =
+                reinterpret_cast<PFNGLPROGRAMPARAMETERIPROC>(load("glProgramParameteri"));
+
+            auto format_count = 0;
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+            extensions.get_program_binary = extensions.glGetProgramBinary != nullptr
+                && extensions.glProgramBinary != nullptr
+                && extensions.glProgramParameteri != nullptr
+                && format_count > 0;
+        }
+
+        if (has(Extension::KHR_parallel_shader_compile)) {
+            extensions.glMaxShaderCompilerThreads =
+                reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(
+                    load("glMaxShaderCompilerThreadsKHR")
+                );
+        } else if (has(Extension::ARB_parallel_shader_compile)) {
+            extensions.glMaxShaderCompilerThreads =
+                reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(
+                    load("glMaxShaderCompilerThreadsARB")
+                );
+        }
+        if (extensions.glMaxShaderCompilerThreads != nullptr) {
+            extensions.parallel_shader_compile = true;
+            // let the driver pick as many compiler threads as it sees fit
+            constexpr auto implementation_maximum = 0xFFFFFFFFU;
+            extensions.glMaxShaderCompilerThreads(implementation_maximum);
+        }
+
+        if (is_core(4, 4) || has(Extension::ARB_buffer_storage)) {
+            extensions.glBufferStorage =
+                reinterpret_cast<PFNGLBUFFERSTORAGEPROC>(load("glBufferStorage"));
+            extensions.buffer_storage = extensions.glBufferStorage != nullptr;
+        }
+
+        if (is_core(4, 2) || has(Extension::ARB_texture_storage)) {
+            extensions.glTexStorage2D =
+                reinterpret_cast<PFNGLTEXSTORAGE2DPROC>(load("glTexStorage2D"));
+            extensions.glTexStorage3D =
+                reinterpret_cast<PFNGLTEXSTORAGE3DPROC>(load("glTexStorage3D"));
+            extensions.texture_storage =
+                extensions.glTexStorage2D != nullptr && extensions.glTexStorage3D != nullptr;
+        }
+
+        if (is_core(4, 3) || has(Extension::ARB_copy_image)) {
+            extensions.glCopyImageSubData =
+                reinterpret_cast<PFNGLCOPYIMAGESUBDATAPROC>(load("glCopyImageSubData"));
+            extensions.copy_image = extensions.glCopyImageSubData != nullptr;
+        }
+
+        extensions.texture_compression_s3tc = has(Extension::EXT_texture_compression_s3tc);
+        extensions.texture_compression_bptc =
+            is_core(4, 2) || has(Extension::ARB_texture_compression_bptc);
+        extensions.texture_compression_etc2 =
+            is_core(4, 3) || has(Extension::ARB_ES3_compatibility);
+    }
+} // namespace gl_extensions
+
+#endif
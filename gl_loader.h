@@ -0,0 +1,88 @@
+#pragma once
+
+#ifndef GL_LOADER_H
+#define GL_LOADER_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <glad/glad.h>
+
+#include "gl_entry_points.h"
+
+// Alternative to gladLoadGLLoader that resolves nothing up front: every glad pointer starts out
+// at a trampoline that asks the loader for the real function on its first call, stores it over
+// itself and forwards. A program that touches a few dozen of the ~370 entry points only pays
+// for those.
+namespace gl_loader {
+    namespace detail {
+        using gl_entry_points::Proc;
+
+        inline GLADloadproc loader { nullptr };
+        inline std::array<std::atomic<Proc>, gl_entry_points::count> resolved {};
+        inline std::atomic<uint32_t> resolved_count { 0 };
+
+        template <size_t Index, typename Function, Function* Pointer>
+        struct Trampoline;
+
+        template <
+            size_t Index,
+            typename Return,
+            typename... Args,
+            Return (APIENTRYP* Pointer)(Args...)
+        >
+        struct Trampoline<Index, Return (APIENTRYP)(Args...), Pointer> {
+            static auto APIENTRY call(Args... args) -> Return {
+                using Function = Return (APIENTRYP)(Args...);
+                auto proc = resolved[Index].load(std::memory_order_acquire);
+                if (proc == nullptr) {
+                    // racing threads resolve the same address, only the first one counts it
+                    proc = reinterpret_cast<Proc>(loader(gl_entry_points::names[Index]));
+                    Proc expected = nullptr;
+                    if (resolved[Index].compare_exchange_strong(expected, proc)) {
+                        resolved_count.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+                const auto function = reinterpret_cast<Function>(proc);
+                // leave the pointer alone when something else took it over, e.g. gl_calls, whose
+                // hook keeps calling through here and finds the resolved address above
+                if (*Pointer == &call) {
+                    *Pointer = function;
+                }
+                return function(args...);
+            }
+        };
+    } // namespace detail
+
+    // Drop-in for gladLoadGLLoader. `load` is kept and called later, from whichever thread
+    // first uses an entry point, so it must stay valid and work on every thread with a
+    // context from the same share group.
+    inline auto load_lazy(const GLADloadproc load) -> bool {
+        if (0 == gladLoadGLVersion(load)) {
+            return false;
+        }
+        detail::loader = load;
+        for (auto& proc : detail::resolved) {
+            proc.store(nullptr, std::memory_order_relaxed);
+        }
+        detail::resolved_count.store(0, std::memory_order_relaxed);
+
+#define GL_ENTRY_POINT(name, type) \
+    glad_gl##name = &detail::Trampoline< \
+        gl_entry_points::index(gl_entry_points::EntryPoint::name), \
+        type, \
+        &glad_gl##name \
+    >::call;
+#include "gl_entry_points.inl"
+#undef GL_ENTRY_POINT
+        return true;
+    }
+
+    // How many entry points were resolved since load_lazy.
+    inline auto resolved() -> uint32_t {
+        return detail::resolved_count.load(std::memory_order_relaxed);
+    }
+} // namespace gl_loader
+
+#endif
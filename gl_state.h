@@ -0,0 +1,246 @@
+#pragma once
+
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include <array>
+#include <cstdint>
+#include <glad/glad.h>
+
+namespace gl_state {
+    struct StateStats {
+        uint64_t issued { 0 };
+        uint64_t filtered { 0 };
+    };
+
+    // Remembers the bindings and pipeline state it set and drops calls that would not change
+    // anything. Code that talks to GL directly must call invalidate() afterwards, and so must
+    // anyone who deletes an object that may still be bound.
+    class StateCache {
+        static constexpr uint32_t unknown = 0xFFFFFFFFU;
+        static constexpr size_t texture_unit_count = 16;
+        static constexpr std::array<GLenum, 3> texture_targets {
+            GL_TEXTURE_2D,
+            GL_TEXTURE_2D_ARRAY,
+            GL_TEXTURE_CUBE_MAP,
+        };
+        static constexpr std::array<GLenum, 5> buffer_targets {
+            GL_ARRAY_BUFFER,
+            GL_ELEMENT_ARRAY_BUFFER,
+            GL_UNIFORM_BUFFER,
+            GL_PIXEL_UNPACK_BUFFER,
+            GL_COPY_WRITE_BUFFER,
+        };
+        static constexpr std::array<GLenum, 5> capabilities {
+            GL_BLEND,
+            GL_CULL_FACE,
+            GL_DEPTH_TEST,
+            GL_SCISSOR_TEST,
+            GL_STENCIL_TEST,
+        };
+
+        bool enabled_ { true };
+        uint32_t program_ { unknown };
+        uint32_t vertex_array_ { unknown };
+        uint32_t active_unit_ { unknown };
+        std::array<std::array<uint32_t, texture_targets.size()>, texture_unit_count> textures_ {};
+        std::array<uint32_t, buffer_targets.size()> buffers_ {};
+        std::array<uint32_t, capabilities.size()> capabilities_ {};
+        std::array<uint32_t, 2> blend_func_ {};
+        uint32_t depth_func_ { unknown };
+        uint32_t polygon_mode_ { unknown };
+
+        StateStats frame_ {};
+        StateStats last_frame_ {};
+        StateStats total_ {};
+
+        template <size_t N>
+        static constexpr auto index_of(const std::array<GLenum, N>& values, const GLenum value)
+            -> size_t {
+            for (size_t i = 0; i < N; ++i) {
+                if (values[i] == value) {
+                    return i;
+                }
+            }
+            return N;
+        }
+
+        // Returns true when `cached` already holds `value`; otherwise records it.
+        auto filter(uint32_t& cached, uint32_t value) -> bool;
+        auto issue() -> void;
+
+    public:
+        StateCache();
+
+        // Turning the cache off sends every call to the driver; turning it back on starts from
+        // unknown state.
+        auto set_enabled(bool enabled) -> void;
+        auto enabled() const -> bool;
+        auto invalidate() -> void;
+
+        // Starts a new frame's counters; the finished frame's stay readable as last_frame().
+        auto begin_frame() -> void;
+        auto last_frame() const -> const StateStats&;
+        auto total() const -> const StateStats&;
+
+        auto use_program(uint32_t program) -> void;
+        auto bind_vertex_array(uint32_t vertex_array) -> void;
+        auto active_texture(uint32_t unit) -> void;
+        auto bind_texture(uint32_t unit, GLenum target, uint32_t texture) -> void;
+        auto bind_buffer(GLenum target, uint32_t buffer) -> void;
+        auto set_capability(GLenum capability, bool enabled) -> void;
+        auto blend_func(GLenum source, GLenum destination) -> void;
+        auto depth_func(GLenum function) -> void;
+        auto polygon_mode(GLenum mode) -> void;
+    };
+
+    inline StateCache::StateCache() {
+        this->invalidate();
+    }
+
+    inline auto StateCache::filter(uint32_t& cached, const uint32_t value) -> bool {
+        if (this->enabled_ && cached == value) {
+            ++this->frame_.filtered;
+            ++this->total_.filtered;
+            return true;
+        }
+        cached = this->enabled_ ? value : unknown;
+        return false;
+    }
+
+    inline auto StateCache::issue() -> void {
+        ++this->frame_.issued;
+        ++this->total_.issued;
+    }
+
+    inline auto StateCache::set_enabled(const bool enabled) -> void {
+        this->enabled_ = enabled;
+        this->invalidate();
+    }
+
+    inline auto StateCache::enabled() const -> bool {
+        return this->enabled_;
+    }
+
+    inline auto StateCache::invalidate() -> void {
+        this->program_ = unknown;
+        this->vertex_array_ = unknown;
+        this->active_unit_ = unknown;
+        for (auto& unit : this->textures_) {
+            unit.fill(unknown);
+        }
+        this->buffers_.fill(unknown);
+        this->capabilities_.fill(unknown);
+        this->blend_func_.fill(unknown);
+        this->depth_func_ = unknown;
+        this->polygon_mode_ = unknown;
+    }
+
+    inline auto StateCache::begin_frame() -> void {
+        this->last_frame_ = this->frame_;
+        this->frame_ = StateStats {};
+    }
+
+    inline auto StateCache::last_frame() const -> const StateStats& {
+        return this->last_frame_;
+    }
+
+    inline auto StateCache::total() const -> const StateStats& {
+        return this->total_;
+    }
+
+    inline auto StateCache::use_program(const uint32_t program) -> void {
+        if (this->filter(this->program_, program)) {
+            return;
+        }
+        glUseProgram(program);
+        this->issue();
+    }
+
+    inline auto StateCache::bind_vertex_array(const uint32_t vertex_array) -> void {
+        if (this->filter(this->vertex_array_, vertex_array)) {
+            return;
+        }
+        glBindVertexArray(vertex_array);
+        this->issue();
+        // the element array binding belongs to the vertex array
+        this->buffers_[index_of(buffer_targets, GL_ELEMENT_ARRAY_BUFFER)] = unknown;
+    }
+
+    inline auto StateCache::active_texture(const uint32_t unit) -> void {
+        if (this->filter(this->active_unit_, unit)) {
+            return;
+        }
+        glActiveTexture(GL_TEXTURE0 + unit);
+        this->issue();
+    }
+
+    inline auto StateCache::bind_texture(
+        const uint32_t unit,
+        const GLenum target,
+        const uint32_t texture
+    ) -> void {
+        const auto target_index = index_of(texture_targets, target);
+        if (unit < texture_unit_count && target_index < texture_targets.size()
+            && this->filter(this->textures_[unit][target_index], texture)) {
+            return;
+        }
+        this->active_texture(unit);
+        glBindTexture(target, texture);
+        this->issue();
+    }
+
+    inline auto StateCache::bind_buffer(const GLenum target, const uint32_t buffer) -> void {
+        const auto target_index = index_of(buffer_targets, target);
+        if (target_index < buffer_targets.size()
+            && this->filter(this->buffers_[target_index], buffer)) {
+            return;
+        }
+        glBindBuffer(target, buffer);
+        this->issue();
+    }
+
+    inline auto StateCache::set_capability(const GLenum capability, const bool enabled) -> void {
+        const auto capability_index = index_of(capabilities, capability);
+        if (capability_index < capabilities.size()
+            && this->filter(this->capabilities_[capability_index], enabled ? 1U : 0U)) {
+            return;
+        }
+        if (enabled) {
+            glEnable(capability);
+        } else {
+            glDisable(capability);
+        }
+        this->issue();
+    }
+
+    inline auto StateCache::blend_func(const GLenum source, const GLenum destination) -> void {
+        if (this->enabled_ && this->blend_func_[0] == source
+            && this->blend_func_[1] == destination) {
+            ++this->frame_.filtered;
+            ++this->total_.filtered;
+            return;
+        }
+        this->blend_func_ = { this->enabled_ ? source : unknown, destination };
+        glBlendFunc(source, destination);
+        this->issue();
+    }
+
+    inline auto StateCache::depth_func(const GLenum function) -> void {
+        if (this->filter(this->depth_func_, function)) {
+            return;
+        }
+        glDepthFunc(function);
+        this->issue();
+    }
+
+    inline auto StateCache::polygon_mode(const GLenum mode) -> void {
+        if (this->filter(this->polygon_mode_, mode)) {
+            return;
+        }
+        glPolygonMode(GL_FRONT_AND_BACK, mode);
+        this->issue();
+    }
+} // namespace gl_state
+
+#endif
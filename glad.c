@@ -1055,9 +1055,11 @@ static void load_GL_VERSION_3_3(GLADloadproc load) {
 	glad_glSecondaryColorP3uiv = (PFNGLSECONDARYCOLORP3UIVPROC)load("glSecondaryColorP3uiv");
 }
 static int find_extensionsGL(void) {
-	if (!get_exts()) return 0;
+	/* Nothing is generated for extensions, so copying every extension string just to free
+	 * it again only costs startup time. gl_extensions.h detects the ones we use. */
+	(void)&get_exts;
 	(void)&has_ext;
-	free_exts();
+	(void)&free_exts;
 	return 1;
 }
 
@@ -1115,12 +1117,18 @@ static void find_coreGL(void) {
 	}
 }
 
-int gladLoadGLLoader(GLADloadproc load) {
+int gladLoadGLVersion(GLADloadproc load) {
 	GLVersion.major = 0; GLVersion.minor = 0;
 	glGetString = (PFNGLGETSTRINGPROC)load("glGetString");
 	if(glGetString == NULL) return 0;
 	if(glGetString(GL_VERSION) == NULL) return 0;
 	find_coreGL();
+	if (!find_extensionsGL()) return 0;
+	return GLVersion.major != 0 || GLVersion.minor != 0;
+}
+
+int gladLoadGLLoader(GLADloadproc load) {
+	if (!gladLoadGLVersion(load)) return 0;
 	load_GL_VERSION_1_0(load);
 	load_GL_VERSION_1_1(load);
 	load_GL_VERSION_1_2(load);
@@ -1133,8 +1141,6 @@ int gladLoadGLLoader(GLADloadproc load) {
 	load_GL_VERSION_3_1(load);
 	load_GL_VERSION_3_2(load);
 	load_GL_VERSION_3_3(load);
-
-	if (!find_extensionsGL()) return 0;
-	return GLVersion.major != 0 || GLVersion.minor != 0;
+	return 1;
 }
 
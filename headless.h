@@ -0,0 +1,249 @@
+#pragma once
+
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <glad/glad.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Offscreen rendering without a window system, e.g. Mesa llvmpipe on a machine without a GPU
+// or display.
+namespace headless {
+    // An EGL context on the surfaceless platform, plus a second context from the same share
+    // group for the shader compiler thread. Neither has a default framebuffer, so render into a
+    // Framebuffer.
+    class Context {
+        bool err_ { false };
+        EGLDisplay display_ { EGL_NO_DISPLAY };
+        EGLContext context_ { EGL_NO_CONTEXT };
+        EGLContext shared_context_ { EGL_NO_CONTEXT };
+
+    public:
+        Context(int32_t major, int32_t minor);
+        ~Context();
+
+        Context(const Context&) = delete;
+        auto operator=(const Context&) -> Context& = delete;
+
+        auto failed() const -> bool;
+        auto make_current() const -> bool;
+        auto make_shared_current() const -> bool;
+        auto release() const -> void;
+
+        // For gladLoadGLLoader and gl_extensions::load.
+        static auto get_proc_address(const char* name) -> void*;
+    };
+
+    // Color and depth renderbuffers behind a framebuffer object.
+    class Framebuffer {
+        uint32_t framebuffer_id_ { 0 };
+        uint32_t color_id_ { 0 };
+        uint32_t depth_id_ { 0 };
+        int32_t width_;
+        int32_t height_;
+
+    public:
+        Framebuffer(int32_t width, int32_t height);
+        ~Framebuffer();
+
+        Framebuffer(const Framebuffer&) = delete;
+        auto operator=(const Framebuffer&) -> Framebuffer& = delete;
+
+        auto complete() const -> bool;
+        // Binds the framebuffer and sets the viewport to cover it.
+        auto bind() const -> void;
+        // Tightly packed RGBA rows, bottom row first like glReadPixels.
+        auto read_pixels() const -> std::vector<uint8_t>;
+        // Writes the current contents as a binary PPM, top row first.
+        auto write_ppm(const std::string& path) const -> bool;
+    };
+
+    namespace detail {
+        inline auto has_client_extension(const char* name) -> bool {
+            const auto* const extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+            return extensions != nullptr && std::strstr(extensions, name) != nullptr;
+        }
+    } // namespace detail
+
+    inline Context::Context(const int32_t major, const int32_t minor) {
+        // prefer the surfaceless platform, the default display may try to reach an X server
+        if (detail::has_client_extension("EGL_MESA_platform_surfaceless")) {
+            const auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+                eglGetProcAddress("eglGetPlatformDisplayEXT")
+            );
+            if (get_platform_display != nullptr) {
+                this->display_ = get_platform_display(
+                    EGL_PLATFORM_SURFACELESS_MESA,
+                    EGL_DEFAULT_DISPLAY,
+                    nullptr
+                );
+            }
+        }
+        if (this->display_ == EGL_NO_DISPLAY) {
+            this->display_ = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        }
+
+        EGLint egl_major = 0;
+        EGLint egl_minor = 0;
+        if (this->display_ == EGL_NO_DISPLAY
+            || EGL_TRUE != eglInitialize(this->display_, &egl_major, &egl_minor)) {
+            std::cout << "ERROR: could not initialize an EGL display" << '\n';
+            this->err_ = true;
+            return;
+        }
+        if (EGL_TRUE != eglBindAPI(EGL_OPENGL_API)) {
+            std::cout << "ERROR: EGL display does not support desktop OpenGL" << '\n';
+            this->err_ = true;
+            return;
+        }
+
+        const std::array<EGLint, 7> attributes {
+            EGL_CONTEXT_MAJOR_VERSION,
+            major,
+            EGL_CONTEXT_MINOR_VERSION,
+            minor,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK,
+            EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE,
+        };
+        // EGL_KHR_no_config_context, so neither context needs a surface-compatible config
+        this->context_ = eglCreateContext(
+            this->display_,
+            EGL_NO_CONFIG_KHR,
+            EGL_NO_CONTEXT,
+            attributes.data()
+        );
+        if (this->context_ != EGL_NO_CONTEXT) {
+            this->shared_context_ = eglCreateContext(
+                this->display_,
+                EGL_NO_CONFIG_KHR,
+                this->context_,
+                attributes.data()
+            );
+        }
+        if (this->context_ == EGL_NO_CONTEXT || this->shared_context_ == EGL_NO_CONTEXT) {
+            std::cout << "ERROR: could not create an OpenGL " << major << "." << minor
+                << " core context, EGL error 0x" << std::hex << eglGetError() << std::dec
+                << '\n';
+            this->err_ = true;
+        }
+    }
+
+    inline Context::~Context() {
+        if (this->display_ == EGL_NO_DISPLAY) {
+            return;
+        }
+        eglMakeCurrent(this->display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (this->shared_context_ != EGL_NO_CONTEXT) {
+            eglDestroyContext(this->display_, this->shared_context_);
+        }
+        if (this->context_ != EGL_NO_CONTEXT) {
+            eglDestroyContext(this->display_, this->context_);
+        }
+        eglTerminate(this->display_);
+    }
+
+    inline auto Context::failed() const -> bool {
+        return this->err_;
+    }
+
+    inline auto Context::make_current() const -> bool {
+        return EGL_TRUE
+            == eglMakeCurrent(this->display_, EGL_NO_SURFACE, EGL_NO_SURFACE, this->context_);
+    }
+
+    inline auto Context::make_shared_current() const -> bool {
+        return EGL_TRUE == eglMakeCurrent(
+            this->display_,
+            EGL_NO_SURFACE,
+            EGL_NO_SURFACE,
+            this->shared_context_
+        );
+    }
+
+    inline auto Context::release() const -> void {
+        eglMakeCurrent(this->display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    }
+
+    inline auto Context::get_proc_address(const char* name) -> void* {
+        return reinterpret_cast<void*>(eglGetProcAddress(name));
+    }
+
+    inline Framebuffer::Framebuffer(const int32_t width, const int32_t height):
+        width_ { width },
+        height_ { height } {
+        glGenRenderbuffers(1, &this->color_id_);
+        glBindRenderbuffer(GL_RENDERBUFFER, this->color_id_);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+        glGenRenderbuffers(1, &this->depth_id_);
+        glBindRenderbuffer(GL_RENDERBUFFER, this->depth_id_);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+
+        glGenFramebuffers(1, &this->framebuffer_id_);
+        glBindFramebuffer(GL_FRAMEBUFFER, this->framebuffer_id_);
+        glFramebufferRenderbuffer(
+            GL_FRAMEBUFFER,
+            GL_COLOR_ATTACHMENT0,
+            GL_RENDERBUFFER,
+            this->color_id_
+        );
+        glFramebufferRenderbuffer(
+            GL_FRAMEBUFFER,
+            GL_DEPTH_STENCIL_ATTACHMENT,
+            GL_RENDERBUFFER,
+            this->depth_id_
+        );
+    }
+
+    inline Framebuffer::~Framebuffer() {
+        glDeleteFramebuffers(1, &this->framebuffer_id_);
+        glDeleteRenderbuffers(1, &this->depth_id_);
+        glDeleteRenderbuffers(1, &this->color_id_);
+    }
+
+    inline auto Framebuffer::complete() const -> bool {
+        glBindFramebuffer(GL_FRAMEBUFFER, this->framebuffer_id_);
+        return GL_FRAMEBUFFER_COMPLETE == glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    }
+
+    inline auto Framebuffer::bind() const -> void {
+        glBindFramebuffer(GL_FRAMEBUFFER, this->framebuffer_id_);
+        glViewport(0, 0, this->width_, this->height_);
+    }
+
+    inline auto Framebuffer::read_pixels() const -> std::vector<uint8_t> {
+        std::vector<uint8_t> pixels(static_cast<size_t>(this->width_) * this->height_ * 4);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, this->framebuffer_id_);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, this->width_, this->height_, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        return pixels;
+    }
+
+    inline auto Framebuffer::write_ppm(const std::string& path) const -> bool {
+        const auto pixels = this->read_pixels();
+        std::ofstream file { path, std::ios::binary | std::ios::trunc };
+        file << "P6\n" << this->width_ << " " << this->height_ << "\n255\n";
+        const auto row_size = static_cast<size_t>(this->width_) * 4;
+        for (auto y = this->height_; y-- > 0;) {
+            const auto* const row = pixels.data() + static_cast<size_t>(y) * row_size;
+            for (size_t x = 0; x < row_size; x += 4) {
+                file.write(reinterpret_cast<const char*>(row + x), 3);
+            }
+        }
+        if (file.fail()) {
+            std::cout << "ERROR: could not write \"" << path << "\"" << '\n';
+            return false;
+        }
+        return true;
+    }
+} // namespace headless
+
+#endif
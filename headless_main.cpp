@@ -0,0 +1,136 @@
+#include <glad/glad.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "benchmarks.h"
+#include "gl_calls.h"
+#include "gl_extensions.h"
+#include "gl_loader.h"
+#include "headless.h"
+#include "profiler.h"
+#include "program_cache.h"
+#include "scene.h"
+
+// Runs the render loop offscreen for a fixed number of frames, then prints the frame rate and a
+// checksum of the last frame, and optionally writes it out as a PPM. Run it from the repository
+// root so the shaders and textures are found. With LEARN_OPENGL_GL_CALLS set in the environment,
+// driver calls are counted and the last frame's busiest entry points are printed too.
+//
+//     learn-opengl-headless [frames] [output.ppm]
+
+auto main(const int32_t argc, char** argv) -> int32_t {
+    constexpr auto window_width = 800;
+    constexpr auto window_height = 600;
+    // the real program compiles in the background, give it this long to replace the fallback
+    constexpr auto ready_timeout = std::chrono::seconds { 30 };
+
+    PROFILE_SESSION("trace.json");
+    PROFILE_THREAD("render");
+
+    const auto frames = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 300ULL;
+    const std::string output_path = argc > 2 ? argv[2] : "";
+
+    const headless::Context context { 3, 3 };
+    if (context.failed() || !context.make_current()) {
+        return EXIT_FAILURE;
+    }
+
+    const auto get_proc_address = reinterpret_cast<GLADloadproc>(
+        headless::Context::get_proc_address
+    );
+    if (!gl_loader::load_lazy(get_proc_address)) {
+        std::cout << "Failed to initialize GLAD" << '\n';
+        return EXIT_FAILURE;
+    }
+    gl_extensions::load(get_proc_address);
+#ifdef LEARN_OPENGL_BENCHMARKS
+    benchmarks::loader_startup(get_proc_address);
+#endif
+    std::cout << "renderer: " << program_cache::detail::gl_string(GL_RENDERER) << ", "
+        << program_cache::detail::gl_string(GL_VERSION) << '\n';
+
+    const headless::Framebuffer framebuffer { window_width, window_height };
+    if (!framebuffer.complete()) {
+        std::cout << "ERROR: offscreen framebuffer is incomplete" << '\n';
+        return EXIT_FAILURE;
+    }
+    framebuffer.bind();
+
+    constexpr std::array<float, 4> gl_clear_color { 0.2F, 0.3F, 0.3F, 1.0F };
+    glClearColor(
+        gl_clear_color[0],
+        gl_clear_color[1],
+        gl_clear_color[2],
+        gl_clear_color[3]
+    );
+
+    auto active_scene = std::make_unique<scene::Scene>(
+        [&context] { return context.make_shared_current(); },
+        [&context] { context.release(); }
+    );
+    const auto ready_deadline = std::chrono::steady_clock::now() + ready_timeout;
+    while (!active_scene->ready() && std::chrono::steady_clock::now() < ready_deadline) {
+        active_scene->frame();
+        glFinish();
+    }
+    if (!active_scene->ready()) {
+        std::cout << "ERROR: scene was not ready after " << ready_timeout.count()
+            << " s, measuring what is loaded" << '\n';
+    }
+    if (active_scene->failed()) {
+        return EXIT_FAILURE;
+    }
+#ifdef LEARN_OPENGL_BENCHMARKS
+    // once, between frames, with nothing left loading
+    benchmarks::run();
+    active_scene->state().invalidate();
+#endif
+
+    gl_calls::set_enabled(std::getenv("LEARN_OPENGL_GL_CALLS") != nullptr);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (uint64_t frame = 0; frame < frames; ++frame) {
+        PROFILE_ZONE("frame");
+        active_scene->frame();
+        // stands in for the swap, which is what submits a windowed frame
+        PROFILE_ZONE("glFlush");
+        glFlush();
+    }
+    glFinish();
+    const auto seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start
+    ).count();
+    std::cout << "rendered " << frames << " frames in " << seconds * 1000.0 << " ms ("
+        << static_cast<double>(frames) / seconds << " frames/s)" << '\n';
+
+    // to compare frames between runs and machines
+    const auto pixels = framebuffer.read_pixels();
+    const auto checksum = program_cache::detail::fnv1a(
+        program_cache::detail::fnv1a_offset_basis,
+        pixels.data(),
+        pixels.size()
+    );
+    std::cout << "frame checksum: " << std::hex << std::setw(16) << std::setfill('0') << checksum
+        << std::dec << '\n';
+
+    active_scene->report();
+    std::cout << "entry points resolved: " << gl_loader::resolved() << " of "
+        << gl_entry_points::count << '\n';
+    if (gl_calls::enabled()) {
+        gl_calls::report(10);
+        gl_calls::set_enabled(false);
+    }
+    active_scene.reset();
+
+    if (!output_path.empty() && !framebuffer.write_ppm(output_path)) {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
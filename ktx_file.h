@@ -0,0 +1,282 @@
+#pragma once
+
+#ifndef KTX_FILE_H
+#define KTX_FILE_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <glad/glad.h>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "block_compression.h"
+
+// KTX 1 files holding a 2D texture and its mip levels, what the cooker writes and the texture
+// loader uploads: block compressed, or RGBA8 for textures that stay uncompressed. Only the parts
+// of the format we use are read: one face, no array layers, no depth, and the KTXorientation
+// key.
+namespace ktx_file {
+    // One mip level, pointing into the bytes the file was read from or written out of.
+    struct Level {
+        uint32_t width;
+        uint32_t height;
+        const uint8_t* data;
+        size_t size;
+    };
+
+    struct KtxFile {
+        GLenum internal_format { 0 };
+        // GL_RGB or GL_RGBA
+        GLenum base_internal_format { 0 };
+        // GL_UNSIGNED_BYTE and GL_RGBA for RGBA8 levels, both 0 when they are compressed
+        GLenum type { 0 };
+        GLenum format { 0 };
+        // the first row is the bottom one, the way glTexImage2D takes it (KTXorientation T=u)
+        bool bottom_up { false };
+        // largest first
+        std::vector<Level> levels;
+    };
+
+    namespace detail {
+        constexpr std::array<uint8_t, 12> identifier {
+            0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n',
+        };
+        constexpr uint32_t endianness = 0x04030201;
+        constexpr std::string_view orientation_key = "KTXorientation";
+
+        // The fields after the identifier, in file order.
+        struct Header {
+            uint32_t endianness;
+            uint32_t gl_type;
+            uint32_t gl_type_size;
+            uint32_t gl_format;
+            uint32_t gl_internal_format;
+            uint32_t gl_base_internal_format;
+            uint32_t pixel_width;
+            uint32_t pixel_height;
+            uint32_t pixel_depth;
+            uint32_t array_elements;
+            uint32_t faces;
+            uint32_t mipmap_levels;
+            uint32_t key_value_bytes;
+        };
+        static_assert(sizeof(Header) == 13 * sizeof(uint32_t));
+
+        constexpr auto padded(const size_t size) -> size_t {
+            return (size + 3) / 4 * 4;
+        }
+
+        // Levels from `width` by `height` down to 1x1: floor(log2(max(width, height))) + 1.
+        constexpr auto full_chain(const uint32_t width, const uint32_t height) -> uint32_t {
+            uint32_t levels = 1;
+            for (auto extent = std::max(width, height); extent > 1; extent /= 2) {
+                ++levels;
+            }
+            return levels;
+        }
+
+        // Reads a uint32_t at `offset`, nullopt past the end.
+        inline auto read_u32(const uint8_t* bytes, const size_t size, const size_t offset)
+            -> std::optional<uint32_t> {
+            if (offset > size || size - offset < sizeof(uint32_t)) {
+                return std::nullopt;
+            }
+            uint32_t value = 0;
+            std::memcpy(&value, bytes + offset, sizeof(value));
+            return value;
+        }
+    } // namespace detail
+
+    // Reads a compressed or RGBA8 2D texture from a whole KTX file in memory, which has to
+    // outlive the result. Prints why, naming the file `name`, and returns nullopt when it is not
+    // one we can upload.
+    inline auto parse(const uint8_t* bytes, const size_t size, const std::string& name)
+        -> std::optional<KtxFile> {
+        const auto fail = [&name](const char* reason) {
+            std::cout << "ERROR: failed to read " << name << ": " << reason << '\n';
+            return std::nullopt;
+        };
+
+        detail::Header header {};
+        if (size < detail::identifier.size() + sizeof(header)
+            || 0 != std::memcmp(bytes, detail::identifier.data(), detail::identifier.size())) {
+            return fail("not a KTX 1 file");
+        }
+        std::memcpy(&header, bytes + detail::identifier.size(), sizeof(header));
+        if (header.endianness != detail::endianness) {
+            return fail("written on a machine of the other endianness");
+        }
+        const auto compressed = header.gl_type == 0 && header.gl_format == 0;
+        const auto rgba8 = header.gl_type == GL_UNSIGNED_BYTE && header.gl_format == GL_RGBA;
+        if (!compressed && !rgba8) {
+            return fail("neither compressed nor RGBA8");
+        }
+        const auto block_format = block_compression::from_internal_format(
+            header.gl_internal_format
+        );
+        if (compressed && !block_format.has_value()) {
+            return fail("not a block compressed format we cook");
+        }
+        const auto base_format = compressed
+            ? block_compression::info(*block_format).base_format
+            : static_cast<GLenum>(GL_RGBA);
+        if (rgba8 && header.gl_internal_format != GL_RGBA8) {
+            return fail("RGBA8 levels with an internal format other than GL_RGBA8");
+        }
+        if (header.gl_base_internal_format != base_format) {
+            return fail("base internal format does not match the internal format");
+        }
+        const auto is_2d = header.pixel_width > 0
+            && header.pixel_height > 0
+            && header.pixel_depth == 0
+            && header.array_elements == 0
+            && header.faces == 1;
+        if (!is_2d) {
+            return fail("not a 2D texture");
+        }
+
+        KtxFile file {};
+        file.internal_format = header.gl_internal_format;
+        file.base_internal_format = header.gl_base_internal_format;
+        file.type = header.gl_type;
+        file.format = header.gl_format;
+
+        auto offset = detail::identifier.size() + sizeof(header);
+        const auto key_values_end = offset + static_cast<size_t>(header.key_value_bytes);
+        if (key_values_end > size) {
+            return fail("truncated key and value data");
+        }
+        while (offset < key_values_end) {
+            const auto length = detail::read_u32(bytes, key_values_end, offset);
+            offset += sizeof(uint32_t);
+            if (!length.has_value() || *length > key_values_end - offset) {
+                return fail("truncated key and value data");
+            }
+            // the key ends at the first NUL, the value runs to the end of the pair
+            const std::string_view pair { reinterpret_cast<const char*>(bytes + offset), *length };
+            const auto key_end = pair.find('\0');
+            if (key_end != std::string_view::npos
+                && pair.substr(0, key_end) == detail::orientation_key) {
+                file.bottom_up = pair.find("T=u", key_end) != std::string_view::npos;
+            }
+            offset += detail::padded(*length);
+        }
+        offset = key_values_end;
+
+        // 0 levels asks the reader to generate them, which we never write
+        const auto level_count = std::max(header.mipmap_levels, 1U);
+        if (level_count > detail::full_chain(header.pixel_width, header.pixel_height)) {
+            return fail("more mip levels than the full chain down to 1x1");
+        }
+        auto width = header.pixel_width;
+        auto height = header.pixel_height;
+        for (uint32_t level = 0; level < level_count; ++level) {
+            const auto image_size = detail::read_u32(bytes, size, offset);
+            offset += sizeof(uint32_t);
+            if (!image_size.has_value() || *image_size > size - offset) {
+                return fail("truncated mip level");
+            }
+            // the upload reads exactly this much, whatever the file claims
+            const auto expected_size = compressed
+                ? block_compression::encoded_size(*block_format, width, height)
+                : static_cast<size_t>(width) * height * 4;
+            if (*image_size != expected_size) {
+                return fail("mip level size does not match its dimensions");
+            }
+            file.levels.push_back(Level { width, height, bytes + offset, *image_size });
+            offset += detail::padded(*image_size);
+            width = std::max(width / 2, 1U);
+            height = std::max(height / 2, 1U);
+        }
+        return file;
+    }
+
+    // Writes `file` to `path`, with `bottom_up` recorded as the orientation. Prints why and
+    // returns false on failure.
+    inline auto write(const std::string& path, const KtxFile& file) -> bool {
+        if (file.levels.empty()) {
+            std::cout << "ERROR: could not write " << path << ": no mip levels" << '\n';
+            return false;
+        }
+
+        std::string orientation { detail::orientation_key };
+        orientation += '\0';
+        orientation += file.bottom_up ? "S=r,T=u" : "S=r,T=d";
+        orientation += '\0';
+        const auto pair_size = static_cast<uint32_t>(orientation.size());
+
+        const detail::Header header {
+            detail::endianness,
+            file.type,
+            1,
+            file.format,
+            file.internal_format,
+            file.base_internal_format,
+            file.levels.front().width,
+            file.levels.front().height,
+            0,
+            0,
+            1,
+            static_cast<uint32_t>(file.levels.size()),
+            static_cast<uint32_t>(sizeof(pair_size) + detail::padded(pair_size)),
+        };
+
+        constexpr std::array<char, 3> padding {};
+        std::ofstream output { path, std::ios::binary | std::ios::trunc };
+        output.write(
+            reinterpret_cast<const char*>(detail::identifier.data()),
+            static_cast<std::streamsize>(detail::identifier.size())
+        );
+        output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        output.write(reinterpret_cast<const char*>(&pair_size), sizeof(pair_size));
+        output.write(orientation.data(), static_cast<std::streamsize>(orientation.size()));
+        output.write(
+            padding.data(),
+            static_cast<std::streamsize>(detail::padded(pair_size) - pair_size)
+        );
+        for (const auto& level : file.levels) {
+            const auto image_size = static_cast<uint32_t>(level.size);
+            output.write(reinterpret_cast<const char*>(&image_size), sizeof(image_size));
+            output.write(
+                reinterpret_cast<const char*>(level.data),
+                static_cast<std::streamsize>(level.size)
+            );
+            output.write(
+                padding.data(),
+                static_cast<std::streamsize>(detail::padded(level.size) - level.size)
+            );
+        }
+        if (output.fail()) {
+            std::cout << "ERROR: could not write " << path << '\n';
+            return false;
+        }
+        return true;
+    }
+
+    // What cooked_path calls the format of uncompressed RGBA8 files.
+    constexpr std::string_view rgba8_name = "rgba8";
+
+    // Where `source` cooked into the format named `format` goes, next to it:
+    // container.jpg in bc7 is container.bc7.ktx.
+    inline auto cooked_path(const std::string& source, const std::string_view format)
+        -> std::string {
+        const auto slash = source.find_last_of("/\\");
+        const auto dot = source.rfind('.');
+        const auto has_extension =
+            dot != std::string::npos && (slash == std::string::npos || dot > slash);
+        auto path = has_extension ? source.substr(0, dot) : source;
+        path += '.';
+        path += format;
+        path += ".ktx";
+        return path;
+    }
+} // namespace ktx_file
+
+#endif
@@ -3,13 +3,20 @@
 
 #include <array>
 #include <cassert>
-#include <cstddef>
 #include <cstdint>
 #include <iostream>
-#include <string>
+#include <memory>
 
-#include "shader_program.h"
-#include "stb_image.h"
+#include "benchmarks.h"
+#include "gl_calls.h"
+#include "gl_extensions.h"
+#include "gl_loader.h"
+#include "profiler.h"
+#include "scene.h"
+
+#ifndef _MSC_VER
+    #define __assume(expression) static_cast<void>(0)
+#endif
 
 // #define REMAP(value, min1, max1, min2, max2)\
 //     ((min2) + ((value) - (min1)) * ((max2) - (min2)) / ((max1) - (min1)))
@@ -39,6 +46,9 @@ namespace {
 // https://learnopengl.com/Getting-started/Transformations
 
 auto main() -> int32_t {
+    PROFILE_SESSION("trace.json");
+    PROFILE_THREAD("render");
+
     glfwInit();
 
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -63,11 +73,15 @@ auto main() -> int32_t {
     __assume(window != nullptr);
     glfwMakeContextCurrent(window);
 
-    if (0 == gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress))) {
+    if (!gl_loader::load_lazy(reinterpret_cast<GLADloadproc>(glfwGetProcAddress))) {
         std::cout << "Failed to initialize GLAD" << '\n';
         glfwTerminate();
         return EXIT_FAILURE;
     }
+    gl_extensions::load(reinterpret_cast<GLADloadproc>(glfwGetProcAddress));
+#ifdef LEARN_OPENGL_BENCHMARKS
+    benchmarks::loader_startup(reinterpret_cast<GLADloadproc>(glfwGetProcAddress));
+#endif
 
     glViewport(0, 0, window_width, window_height);
 
@@ -80,204 +94,73 @@ auto main() -> int32_t {
         gl_clear_color[3]
     );
 
-    uint32_t vao = 0;
-    glGenVertexArrays(1, &vao);
-    glBindVertexArray(vao);
-
-    constexpr auto stride = 8;
-    constexpr auto vertices_len = static_cast<size_t>(stride) * static_cast<size_t>(3);
-    constexpr std::array<float, vertices_len> vertices = {
-        // bottom right
-        // v
-        0.5F,
-        -0.5F,
-        0.0F,
-        // c
-        1.0F,
-        0.0F,
-        0.0F,
-        // t
-        1.0F,
-        0.0F,
-        // bottom left
-        // v
-        -0.5F,
-        -0.5F,
-        0.0F,
-        // c
-        0.0F,
-        1.0F,
-        0.0F,
-        // t
-        0.0F,
-        0.0F,
-        // top
-        // v
-        0.0F,
-        0.5F,
-        0.0F,
-        // c
-        0.0F,
-        0.0F,
-        1.0F,
-        // t
-        0.5F,
-        1.0F
-    };
-
-    uint32_t vbo = 0;
-    glGenBuffers(1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(
-        GL_ARRAY_BUFFER,
-        sizeof(vertices),
-        static_cast<const void*>(vertices.data()),
-        GL_STATIC_DRAW
-    );
-    glVertexAttribPointer(
-        0,
-        3,
-        GL_FLOAT,
-        GL_FALSE,
-        stride * sizeof(float),
-        static_cast<void*>(nullptr)
-    );
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(
-        1,
-        3,
-        GL_FLOAT,
-        GL_FALSE,
-        stride * sizeof(float),
-        reinterpret_cast<void*>(3 * sizeof(float))
-    );
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(
-        2,
-        2,
-        GL_FLOAT,
-        GL_FALSE,
-        stride * sizeof(float),
-        reinterpret_cast<void*>(6 * sizeof(float))
-    );
-    glEnableVertexAttribArray(2);
-
-    stbi_set_flip_vertically_on_load(true);
-
-    const std::string container_jpg_path = "container.jpg";
-    int32_t container_jpg_width {};
-    int32_t container_jpg_height {};
-    int32_t container_jpg_nr_channels {};
-    const auto container_jpg_sanity = stbi_info(
-        container_jpg_path.c_str(),
-        &container_jpg_width,
-        &container_jpg_height,
-        &container_jpg_nr_channels
-    );
-    if (1 != container_jpg_sanity) {
-        std::cout << "failed to load container.jpg" << '\n';
-        glfwTerminate();
-        return EXIT_FAILURE;
-    }
-    auto* const container_jpg_data = stbi_load(
-        container_jpg_path.c_str(),
-        &container_jpg_width,
-        &container_jpg_height,
-        &container_jpg_nr_channels,
-        0
-    );
-    uint32_t container_jpg_texture {};
-    glGenTextures(1, &container_jpg_texture);
-    glBindTexture(GL_TEXTURE_2D, container_jpg_texture);
-    glTexImage2D(
-        GL_TEXTURE_2D,
-        0,
-        GL_RGB,
-        container_jpg_width,
-        container_jpg_height,
-        0,
-        GL_RGB,
-        GL_UNSIGNED_BYTE,
-        container_jpg_data
-    );
-    stbi_image_free(container_jpg_data);
-    glGenerateMipmap(GL_TEXTURE_2D);
+    // the compiler thread gets its own invisible window whose context shares our objects
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* compiler_window = glfwCreateWindow(1, 1, "", nullptr, window);
 
-    const std::string awesomeface_png_path = "awesomeface.png";
-    int32_t awesomeface_png_width {};
-    int32_t awesomeface_png_height {};
-    int32_t awesomeface_png_nr_channels {};
-    const auto awesomeface_png_sanity = stbi_info(
-        awesomeface_png_path.c_str(),
-        &awesomeface_png_width,
-        &awesomeface_png_height,
-        &awesomeface_png_nr_channels
-    );
-    if (1 != awesomeface_png_sanity) {
-        std::cout << "failed to load awesomeface.png" << '\n';
-        glfwTerminate();
-        return EXIT_FAILURE;
-    }
-    auto* const awesomeface_png_data = stbi_load(
-        awesomeface_png_path.c_str(),
-        &awesomeface_png_width,
-        &awesomeface_png_height,
-        &awesomeface_png_nr_channels,
-        0
-    );
-    uint32_t awesomeface_png_texture {};
-    glGenTextures(1, &awesomeface_png_texture);
-    glBindTexture(GL_TEXTURE_2D, awesomeface_png_texture);
-    glTexImage2D(
-        GL_TEXTURE_2D,
-        0,
-        GL_RGB,
-        awesomeface_png_width,
-        awesomeface_png_height,
-        0,
-        GL_RGBA,
-        GL_UNSIGNED_BYTE,
-        awesomeface_png_data
+    auto active_scene = std::make_unique<scene::Scene>(
+        [compiler_window] {
+            glfwMakeContextCurrent(compiler_window);
+            return compiler_window != nullptr;
+        },
+        [] { glfwMakeContextCurrent(nullptr); }
     );
-    stbi_image_free(awesomeface_png_data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_MIRRORED_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    const auto program =
-        shader_program::builder::ProgramBuilder {}
-        .add_shader(
-            GL_VERTEX_SHADER,
-            "shaders/shader.vs.glsl"
-        )->add_shader(
-            GL_FRAGMENT_SHADER,
-            "shaders/shader.fs.glsl"
-        )->build();
-    program.use();
-    program.set_int("texture2", 1);
-
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    auto state_toggle_down = false;
+    auto call_toggle_down = false;
+#ifdef LEARN_OPENGL_BENCHMARKS
+    auto benchmarked = false;
+#endif
 
     while (0 == glfwWindowShouldClose(window)) {
+        PROFILE_ZONE("frame");
         process_input(window);
-        glClear(GL_COLOR_BUFFER_BIT);
-
-        program.use();
 
-        glBindVertexArray(vao);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, container_jpg_texture);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, awesomeface_png_texture);
-        glDrawArrays(GL_TRIANGLES, 0, 3);
+        // C toggles the state cache, to compare against sending every call to the driver
+        const auto state_toggle_pressed = glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS;
+        if (state_toggle_pressed && !state_toggle_down) {
+            auto& gl_state = active_scene->state();
+            gl_state.set_enabled(!gl_state.enabled());
+            std::cout << "state cache " << (gl_state.enabled() ? "on" : "off") << ", last frame: "
+                << gl_state.last_frame().issued << " issued, " << gl_state.last_frame().filtered
+                << " filtered" << '\n';
+        }
+        state_toggle_down = state_toggle_pressed;
+
+        // G counts driver calls, and prints the busiest entry points of the last frame when
+        // pressed again
+        const auto call_toggle_pressed = glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS;
+        if (call_toggle_pressed && !call_toggle_down) {
+            if (gl_calls::enabled()) {
+                gl_calls::report(10);
+            }
+            gl_calls::set_enabled(!gl_calls::enabled());
+        }
+        call_toggle_down = call_toggle_pressed;
+
+#ifdef LEARN_OPENGL_BENCHMARKS
+        // once, between frames, with nothing left loading
+        if (!benchmarked && active_scene->ready()) {
+            benchmarks::run();
+            active_scene->state().invalidate();
+            benchmarked = true;
+        }
+#endif
+        active_scene->frame();
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        {
+            PROFILE_ZONE("glfwSwapBuffers");
+            glfwSwapBuffers(window);
+        }
+        {
+            PROFILE_ZONE("glfwPollEvents");
+            glfwPollEvents();
+        }
     }
 
+    active_scene->report();
+    std::cout << "entry points resolved: " << gl_loader::resolved() << " of "
+        << gl_entry_points::count << '\n';
+    active_scene.reset();
     glfwTerminate();
 
     return EXIT_SUCCESS;
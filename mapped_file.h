@@ -0,0 +1,101 @@
+#pragma once
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#else
+    #include <fstream>
+#endif
+
+namespace mapped_file {
+    // A whole file, read only. On Linux the file is mapped, so it is opened once, never copied,
+    // and paged in by sequential read-ahead as it is consumed. Elsewhere it is read into memory.
+    class MappedFile {
+        const uint8_t* data_ { nullptr };
+        size_t size_ { 0 };
+#ifndef __linux__
+        std::vector<uint8_t> bytes_;
+#endif
+
+    public:
+        explicit MappedFile(const std::string& path);
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        auto operator=(const MappedFile&) -> MappedFile& = delete;
+
+        // True when the file could not be opened, or is empty.
+        auto failed() const -> bool;
+        auto data() const -> const uint8_t*;
+        auto size() const -> size_t;
+    };
+
+    inline MappedFile::MappedFile(const std::string& path) {
+#ifdef __linux__
+        const auto fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        struct stat status {};
+        if (fstat(fd, &status) == 0 && status.st_size > 0) {
+            const auto size = static_cast<size_t>(status.st_size);
+            auto* const mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping != MAP_FAILED) {
+                // only advice, the mapping works the same if the kernel ignores it
+                madvise(mapping, size, MADV_SEQUENTIAL);
+                this->data_ = static_cast<const uint8_t*>(mapping);
+                this->size_ = size;
+            }
+        }
+        // the mapping keeps the file alive
+        close(fd);
+#else
+        std::ifstream file { path, std::ios::binary | std::ios::ate };
+        if (file.fail()) {
+            return;
+        }
+        this->bytes_.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(
+            reinterpret_cast<char*>(this->bytes_.data()),
+            static_cast<std::streamsize>(this->bytes_.size())
+        );
+        if (!file.fail()) {
+            this->data_ = this->bytes_.data();
+            this->size_ = this->bytes_.size();
+        }
+#endif
+    }
+
+    inline MappedFile::~MappedFile() {
+#ifdef __linux__
+        if (this->data_ != nullptr) {
+            munmap(const_cast<uint8_t*>(this->data_), this->size_);
+        }
+#endif
+    }
+
+    inline auto MappedFile::failed() const -> bool {
+        return this->size_ == 0;
+    }
+
+    inline auto MappedFile::data() const -> const uint8_t* {
+        return this->data_;
+    }
+
+    inline auto MappedFile::size() const -> size_t {
+        return this->size_;
+    }
+} // namespace mapped_file
+
+#endif
@@ -0,0 +1,361 @@
+#pragma once
+
+#ifndef MIP_CHAIN_H
+#define MIP_CHAIN_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+    #define MIP_CHAIN_SSE2
+#endif
+
+// Mip levels built on the CPU at cook time, so they no longer depend on what the driver's
+// glGenerateMipmap does, or cost anything at load time.
+//
+// Each level is filtered from the one above it, kept in linear light as floats between levels,
+// so rounding does not pile up down the chain. The filter is separable and runs on tiles of the
+// level being built, one tile per thread at a time; a pixel's four channels fill one SSE2
+// register. Every path does the same float operations in the same order, so the output is the
+// same bit for bit on any machine.
+namespace mip_chain {
+    enum class Filter : uint8_t {
+        // the 2x2 pixels below, cheap and a little blurry
+        box,
+        // a Kaiser windowed sinc over 8x8 pixels, sharper, with slight ringing at hard edges
+        kaiser,
+    };
+
+    struct Options {
+        Filter filter { Filter::kaiser };
+        // RGB is sRGB encoded and filtered in linear light; alpha is always linear. Turn off for
+        // data that is not color, like normal maps.
+        bool srgb { true };
+        // 0 for one per hardware thread
+        uint32_t threads { 0 };
+    };
+
+    struct Image {
+        uint32_t width;
+        uint32_t height;
+        // RGBA, tightly packed
+        std::vector<uint8_t> pixels;
+    };
+
+    namespace detail {
+        constexpr uint32_t tile_size = 64;
+        constexpr size_t kaiser_radius = 4;
+
+        // A level in linear light, four floats per pixel.
+        struct Linear {
+            uint32_t width;
+            uint32_t height;
+            std::vector<float> pixels;
+        };
+
+        // Where the taps of output pixel x start relative to source pixel 2x, and their weights.
+        struct Kernel {
+            int32_t first;
+            std::vector<float> weights;
+        };
+
+        // Zeroth order modified Bessel function of the first kind, for the Kaiser window.
+        inline auto bessel_i0(const double x) -> double {
+            auto sum = 1.0;
+            auto term = 1.0;
+            for (auto k = 1; k < 32; ++k) {
+                term *= (x / (2.0 * k)) * (x / (2.0 * k));
+                sum += term;
+            }
+            return sum;
+        }
+
+        inline auto kernel(const Filter filter) -> Kernel {
+            if (filter == Filter::box) {
+                return Kernel { 0, { 0.5F, 0.5F } };
+            }
+            // halving the resolution halves the cutoff: sinc(d / 2), windowed to the radius,
+            // with taps half a pixel either side of the output pixel's center at 2x + 0.5
+            constexpr auto beta = 4.0;
+            constexpr auto pi = 3.14159265358979323846;
+            std::vector<double> weights;
+            auto sum = 0.0;
+            for (size_t tap = 0; tap < 2 * kaiser_radius; ++tap) {
+                const auto distance = static_cast<double>(tap) - kaiser_radius + 0.5;
+                const auto x = pi * distance / 2.0;
+                const auto sinc = std::sin(x) / x;
+                const auto ratio = distance / kaiser_radius;
+                const auto window = bessel_i0(beta * std::sqrt(1.0 - ratio * ratio))
+                    / bessel_i0(beta);
+                weights.push_back(sinc * window);
+                sum += sinc * window;
+            }
+            Kernel result { 1 - static_cast<int32_t>(kaiser_radius), {} };
+            for (const auto weight : weights) {
+                result.weights.push_back(static_cast<float>(weight / sum));
+            }
+            return result;
+        }
+
+        inline auto decode_table() -> const std::array<float, 256>& {
+            static const auto table = [] {
+                std::array<float, 256> values {};
+                for (size_t i = 0; i < values.size(); ++i) {
+                    const auto encoded = static_cast<double>(i) / 255.0;
+                    values[i] = static_cast<float>(
+                        encoded <= 0.04045
+                            ? encoded / 12.92
+                            : std::pow((encoded + 0.055) / 1.055, 2.4)
+                    );
+                }
+                return values;
+            }();
+            return table;
+        }
+
+        // Indexed by linear light in 1/65535 steps, fine enough to round to the nearest 8 bit
+        // sRGB value even near black where the curve is steepest.
+        constexpr size_t encode_steps = 65536;
+
+        inline auto encode_table() -> const std::vector<uint8_t>& {
+            static const auto table = [] {
+                std::vector<uint8_t> values(encode_steps);
+                for (size_t i = 0; i < values.size(); ++i) {
+                    const auto linear = static_cast<double>(i) / (encode_steps - 1);
+                    const auto encoded = linear <= 0.0031308
+                        ? linear * 12.92
+                        : 1.055 * std::pow(linear, 1.0 / 2.4) - 0.055;
+                    values[i] = static_cast<uint8_t>(std::lround(encoded * 255.0));
+                }
+                return values;
+            }();
+            return table;
+        }
+
+        inline auto to_linear(const Image& image, const bool srgb) -> Linear {
+            const auto& decode = decode_table();
+            Linear linear { image.width, image.height, std::vector<float>(image.pixels.size()) };
+            for (size_t i = 0; i < image.pixels.size(); ++i) {
+                const auto value = image.pixels[i];
+                const auto is_alpha = i % 4 == 3;
+                linear.pixels[i] = srgb && !is_alpha
+                    ? decode[value]
+                    : static_cast<float>(value) / 255.0F;
+            }
+            return linear;
+        }
+
+        // Four channels of one pixel, in a register where there is SSE2.
+#ifdef MIP_CHAIN_SSE2
+        using Pixel = __m128;
+
+        inline auto load(const float* pixel) -> Pixel {
+            return _mm_loadu_ps(pixel);
+        }
+
+        inline auto store(float* pixel, const Pixel value) -> void {
+            _mm_storeu_ps(pixel, value);
+        }
+
+        inline auto zero() -> Pixel {
+            return _mm_setzero_ps();
+        }
+
+        inline auto add_weighted(const Pixel sum, const float weight, const Pixel value)
+            -> Pixel {
+            return _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weight), value));
+        }
+
+        inline auto saturate(const Pixel value) -> Pixel {
+            return _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0F));
+        }
+
+        // Rounds to nearest even, as std::lrint does in the default rounding mode.
+        inline auto round_scaled(const Pixel value, const float scale) -> std::array<int32_t, 4> {
+            alignas(16) std::array<int32_t, 4> rounded {};
+            _mm_store_si128(
+                reinterpret_cast<__m128i*>(rounded.data()),
+                _mm_cvtps_epi32(_mm_mul_ps(value, _mm_set1_ps(scale)))
+            );
+            return rounded;
+        }
+#else
+        using Pixel = std::array<float, 4>;
+
+        inline auto load(const float* pixel) -> Pixel {
+            return { pixel[0], pixel[1], pixel[2], pixel[3] };
+        }
+
+        inline auto store(float* pixel, const Pixel& value) -> void {
+            std::copy(value.begin(), value.end(), pixel);
+        }
+
+        inline auto zero() -> Pixel {
+            return {};
+        }
+
+        inline auto add_weighted(Pixel sum, const float weight, const Pixel& value) -> Pixel {
+            for (size_t channel = 0; channel < 4; ++channel) {
+                sum[channel] += weight * value[channel];
+            }
+            return sum;
+        }
+
+        inline auto saturate(Pixel value) -> Pixel {
+            for (auto& channel : value) {
+                channel = std::min(std::max(channel, 0.0F), 1.0F);
+            }
+            return value;
+        }
+
+        inline auto round_scaled(const Pixel& value, const float scale)
+            -> std::array<int32_t, 4> {
+            std::array<int32_t, 4> rounded {};
+            for (size_t channel = 0; channel < 4; ++channel) {
+                rounded[channel] = static_cast<int32_t>(std::lrint(value[channel] * scale));
+            }
+            return rounded;
+        }
+#endif
+
+        // Builds one tile of `next` from `source`: the horizontal pass over every source row
+        // the tile's vertical taps reach, then the vertical pass, then the 8 bit output.
+        inline auto filter_tile(
+            const Linear& source,
+            const Kernel& kernel,
+            const bool srgb,
+            const uint32_t tile_x,
+            const uint32_t tile_y,
+            Linear& next,
+            Image& output
+        ) -> void {
+            const auto x_begin = tile_x * tile_size;
+            const auto x_end = std::min(x_begin + tile_size, next.width);
+            const auto y_begin = tile_y * tile_size;
+            const auto y_end = std::min(y_begin + tile_size, next.height);
+            const auto taps = static_cast<int32_t>(kernel.weights.size());
+            const auto clamp_to = [](const int32_t value, const uint32_t size) {
+                return static_cast<uint32_t>(
+                    std::clamp(value, 0, static_cast<int32_t>(size) - 1)
+                );
+            };
+
+            const auto row_begin =
+                clamp_to(static_cast<int32_t>(y_begin * 2) + kernel.first, source.height);
+            const auto row_end = clamp_to(
+                static_cast<int32_t>((y_end - 1) * 2) + kernel.first + taps - 1,
+                source.height
+            ) + 1;
+            const auto columns = x_end - x_begin;
+            std::vector<float> rows(static_cast<size_t>(row_end - row_begin) * columns * 4);
+            for (auto row = row_begin; row < row_end; ++row) {
+                const auto* const line =
+                    &source.pixels[static_cast<size_t>(row) * source.width * 4];
+                for (auto x = x_begin; x < x_end; ++x) {
+                    auto sum = zero();
+                    for (auto tap = 0; tap < taps; ++tap) {
+                        const auto column = clamp_to(
+                            static_cast<int32_t>(x * 2) + kernel.first + tap,
+                            source.width
+                        );
+                        sum = add_weighted(sum, kernel.weights[tap], load(&line[column * 4]));
+                    }
+                    const auto index = (static_cast<size_t>(row - row_begin) * columns
+                        + (x - x_begin)) * 4;
+                    store(&rows[index], sum);
+                }
+            }
+
+            const auto& encode = encode_table();
+            const auto encode_scale = static_cast<float>(encode_steps - 1);
+            for (auto y = y_begin; y < y_end; ++y) {
+                for (auto x = x_begin; x < x_end; ++x) {
+                    auto sum = zero();
+                    for (auto tap = 0; tap < taps; ++tap) {
+                        const auto row = clamp_to(
+                            static_cast<int32_t>(y * 2) + kernel.first + tap,
+                            source.height
+                        );
+                        const auto index = (static_cast<size_t>(row - row_begin) * columns
+                            + (x - x_begin)) * 4;
+                        sum = add_weighted(sum, kernel.weights[tap], load(&rows[index]));
+                    }
+                    // the sinc's negative lobes overshoot at hard edges
+                    const auto value = saturate(sum);
+                    const auto pixel = (static_cast<size_t>(y) * next.width + x) * 4;
+                    store(&next.pixels[pixel], value);
+
+                    const auto bytes = round_scaled(value, 255.0F);
+                    const auto steps = round_scaled(value, encode_scale);
+                    for (size_t channel = 0; channel < 4; ++channel) {
+                        const auto is_alpha = channel == 3;
+                        output.pixels[pixel + channel] = srgb && !is_alpha
+                            ? encode[static_cast<size_t>(steps[channel])]
+                            : static_cast<uint8_t>(bytes[channel]);
+                    }
+                }
+            }
+        }
+    } // namespace detail
+
+    // `image` followed by every level down to 1x1, each half the size of the one above,
+    // rounded down.
+    inline auto build(Image image, const Options& options = {}) -> std::vector<Image> {
+        std::vector<Image> levels;
+        const auto kernel = detail::kernel(options.filter);
+        auto source = detail::to_linear(image, options.srgb);
+        levels.push_back(std::move(image));
+        const auto hardware_threads = std::max(std::thread::hardware_concurrency(), 1U);
+        const auto threads = options.threads != 0 ? options.threads : hardware_threads;
+
+        while (source.width > 1 || source.height > 1) {
+            const auto width = std::max(source.width / 2, 1U);
+            const auto height = std::max(source.height / 2, 1U);
+            const auto pixel_count = static_cast<size_t>(width) * height * 4;
+            detail::Linear next { width, height, std::vector<float>(pixel_count) };
+            Image output { width, height, std::vector<uint8_t>(pixel_count) };
+
+            const auto tiles_x = (width + detail::tile_size - 1) / detail::tile_size;
+            const auto tiles_y = (height + detail::tile_size - 1) / detail::tile_size;
+            const auto tile_count = tiles_x * tiles_y;
+            std::atomic<uint32_t> next_tile { 0 };
+            const auto work = [&] {
+                for (auto tile = next_tile++; tile < tile_count; tile = next_tile++) {
+                    const auto tile_x = tile % tiles_x;
+                    const auto tile_y = tile / tiles_x;
+                    detail::filter_tile(
+                        source,
+                        kernel,
+                        options.srgb,
+                        tile_x,
+                        tile_y,
+                        next,
+                        output
+                    );
+                }
+            };
+            std::vector<std::thread> workers;
+            for (uint32_t i = 1; i < std::min(threads, tile_count); ++i) {
+                workers.emplace_back(work);
+            }
+            work();
+            for (auto& worker : workers) {
+                worker.join();
+            }
+
+            levels.push_back(std::move(output));
+            source = std::move(next);
+        }
+        return levels;
+    }
+} // namespace mip_chain
+
+#endif
@@ -0,0 +1,296 @@
+#pragma once
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// Scoped CPU zones, written to Chrome trace JSON (chrome://tracing, ui.perfetto.dev).
+//
+//     PROFILE_SESSION("trace.json");   // once, in main()
+//     PROFILE_THREAD("compiler");      // optional, names the calling thread in the trace
+//     PROFILE_ZONE("draw");            // times the rest of the enclosing scope
+//
+// Names must be string literals, or otherwise outlive the session. Without
+// LEARN_OPENGL_PROFILE every macro expands to nothing.
+
+#ifdef LEARN_OPENGL_PROFILE
+    #include <array>
+    #include <atomic>
+    #include <chrono>
+    #include <condition_variable>
+    #include <cstdint>
+    #include <fstream>
+    #include <iomanip>
+    #include <iostream>
+    #include <memory>
+    #include <mutex>
+    #include <string>
+    #include <thread>
+    #include <utility>
+    #include <vector>
+
+    #if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        #include <intrin.h>
+        #define PROFILE_HAS_TSC 1
+    #elif defined(__x86_64__) || defined(__i386__)
+        #include <x86intrin.h>
+        #define PROFILE_HAS_TSC 1
+    #endif
+
+namespace profiler {
+    // Times are in ticks of detail::now(), the session converts them when writing.
+    struct Event {
+        const char* name;
+        uint64_t begin;
+        uint64_t end;
+    };
+
+    // Single producer, single consumer: the owning thread pushes finished zones, the session's
+    // flush thread drains them. Zones that find the ring full are dropped and counted.
+    class ThreadBuffer {
+        static constexpr uint64_t capacity = uint64_t { 1 } << 14U;
+
+        std::array<Event, capacity> events_ {};
+        alignas(64) std::atomic<uint64_t> head_ { 0 };
+        alignas(64) std::atomic<uint64_t> tail_ { 0 };
+        std::atomic<uint64_t> dropped_ { 0 };
+
+    public:
+        const uint32_t thread_id;
+        // guarded by the registry mutex
+        std::string name {};
+
+        explicit ThreadBuffer(uint32_t id);
+
+        auto push(const Event& event) -> void;
+        // Calls `consume` for every event pushed so far, oldest first.
+        template <typename Consume>
+        auto drain(Consume&& consume) -> void;
+        auto dropped() const -> uint64_t;
+    };
+
+    namespace detail {
+        struct Registry {
+            std::mutex mutex;
+            std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+        };
+
+        inline auto registry() -> Registry& {
+            static Registry instance {};
+            return instance;
+        }
+
+        inline auto now_ns() -> uint64_t {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()
+            ).count());
+        }
+
+        // The time stamp counter costs a fraction of a steady_clock read and is invariant on
+        // every x86 CPU this will run on.
+        inline auto now() -> uint64_t {
+    #ifdef PROFILE_HAS_TSC
+            return __rdtsc();
+    #else
+            return now_ns();
+    #endif
+        }
+
+        // Kept alive by the registry, so events survive their thread until the session ends.
+        inline auto thread_buffer() -> ThreadBuffer& {
+            thread_local ThreadBuffer* buffer = nullptr;
+            if (buffer == nullptr) {
+                auto& registry = detail::registry();
+                const std::lock_guard lock { registry.mutex };
+                const auto id = static_cast<uint32_t>(registry.buffers.size() + 1);
+                registry.buffers.push_back(std::make_shared<ThreadBuffer>(id));
+                buffer = registry.buffers.back().get();
+            }
+            return *buffer;
+        }
+    } // namespace detail
+
+    inline auto set_thread_name(std::string name) -> void {
+        auto& buffer = detail::thread_buffer();
+        const std::lock_guard lock { detail::registry().mutex };
+        buffer.name = std::move(name);
+    }
+
+    class Zone {
+        const char* name_;
+        uint64_t begin_;
+
+    public:
+        explicit Zone(const char* name);
+        ~Zone();
+
+        Zone(const Zone&) = delete;
+        auto operator=(const Zone&) -> Zone& = delete;
+    };
+
+    // Owns the output file and a thread that drains every thread's ring into it a few times a
+    // second, so the rings can stay small. The trace is completed when the session ends.
+    class Session {
+        std::ofstream file_;
+        bool first_event_ { true };
+        uint64_t origin_ticks_;
+        uint64_t origin_ns_;
+        // re-measured against steady_clock on every flush
+        double ns_per_tick_ { 1.0 };
+
+        std::mutex mutex_;
+        std::condition_variable wake_;
+        bool stopping_ { false };
+        std::thread worker_;
+
+        auto write_event(uint32_t thread_id, const Event& event) -> void;
+        auto flush() -> void;
+        auto run() -> void;
+
+    public:
+        explicit Session(const std::string& path);
+        ~Session();
+
+        Session(const Session&) = delete;
+        auto operator=(const Session&) -> Session& = delete;
+    };
+
+    inline ThreadBuffer::ThreadBuffer(const uint32_t id):
+        thread_id { id } {}
+
+    inline auto ThreadBuffer::push(const Event& event) -> void {
+        const auto head = this->head_.load(std::memory_order_relaxed);
+        if (head - this->tail_.load(std::memory_order_acquire) == capacity) {
+            this->dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        this->events_[head & (capacity - 1)] = event;
+        this->head_.store(head + 1, std::memory_order_release);
+    }
+
+    template <typename Consume>
+    auto ThreadBuffer::drain(Consume&& consume) -> void {
+        const auto tail = this->tail_.load(std::memory_order_relaxed);
+        const auto head = this->head_.load(std::memory_order_acquire);
+        for (auto i = tail; i != head; ++i) {
+            consume(this->events_[i & (capacity - 1)]);
+        }
+        this->tail_.store(head, std::memory_order_release);
+    }
+
+    inline auto ThreadBuffer::dropped() const -> uint64_t {
+        return this->dropped_.load(std::memory_order_relaxed);
+    }
+
+    inline Zone::Zone(const char* name):
+        name_ { name },
+        begin_ { detail::now() } {}
+
+    inline Zone::~Zone() {
+        detail::thread_buffer().push(Event { this->name_, this->begin_, detail::now() });
+    }
+
+    inline Session::Session(const std::string& path):
+        file_ { path, std::ios::trunc },
+        origin_ticks_ { detail::now() },
+        origin_ns_ { detail::now_ns() } {
+        if (this->file_.fail()) {
+            std::cout << "ERROR: could not open profile output \"" << path << "\"" << '\n';
+            return;
+        }
+        this->file_ << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        this->file_ << std::fixed << std::setprecision(3);
+        this->worker_ = std::thread { [this] { this->run(); } };
+    }
+
+    inline Session::~Session() {
+        if (!this->worker_.joinable()) {
+            return;
+        }
+        {
+            const std::lock_guard lock { this->mutex_ };
+            this->stopping_ = true;
+        }
+        this->wake_.notify_one();
+        this->worker_.join();
+        this->flush();
+
+        uint64_t dropped = 0;
+        auto& registry = detail::registry();
+        const std::lock_guard lock { registry.mutex };
+        for (const auto& buffer : registry.buffers) {
+            dropped += buffer->dropped();
+            if (buffer->name.empty()) {
+                continue;
+            }
+            this->file_ << (this->first_event_ ? "" : ",\n")
+                << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << buffer->thread_id
+                << R"(,"args":{"name":")" << buffer->name << "\"}}";
+            this->first_event_ = false;
+        }
+        this->file_ << "]}\n";
+        if (0 != dropped) {
+            std::cout << "profiler: dropped " << dropped << " zones, rings were full" << '\n';
+        }
+    }
+
+    inline auto Session::write_event(const uint32_t thread_id, const Event& event) -> void {
+        // Chrome trace timestamps are microseconds
+        const auto microseconds_per_tick = this->ns_per_tick_ / 1000.0;
+        const auto begin = static_cast<double>(
+            static_cast<int64_t>(event.begin - this->origin_ticks_)
+        );
+        const auto duration = static_cast<double>(event.end - event.begin);
+        this->file_ << (this->first_event_ ? "" : ",\n") << R"({"name":")" << event.name
+            << R"(","ph":"X","pid":1,"tid":)" << thread_id
+            << ",\"ts\":" << begin * microseconds_per_tick
+            << ",\"dur\":" << duration * microseconds_per_tick << "}";
+        this->first_event_ = false;
+    }
+
+    inline auto Session::flush() -> void {
+    #ifdef PROFILE_HAS_TSC
+        const auto ticks = detail::now() - this->origin_ticks_;
+        const auto nanoseconds = detail::now_ns() - this->origin_ns_;
+        if (ticks > 0 && nanoseconds > 0) {
+            this->ns_per_tick_ = static_cast<double>(nanoseconds) / static_cast<double>(ticks);
+        }
+    #endif
+
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+        {
+            auto& registry = detail::registry();
+            const std::lock_guard lock { registry.mutex };
+            buffers = registry.buffers;
+        }
+        for (const auto& buffer : buffers) {
+            buffer->drain([this, &buffer](const Event& event) {
+                this->write_event(buffer->thread_id, event);
+            });
+        }
+    }
+
+    inline auto Session::run() -> void {
+        std::unique_lock lock { this->mutex_ };
+        while (!this->stopping_) {
+            this->wake_.wait_for(lock, std::chrono::milliseconds { 50 });
+            lock.unlock();
+            this->flush();
+            lock.lock();
+        }
+    }
+} // namespace profiler
+
+    #define PROFILE_CONCAT_INNER(a, b) a##b
+    #define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+    #define PROFILE_ZONE(name) \
+        const ::profiler::Zone PROFILE_CONCAT(profile_zone_, __LINE__) { name }
+    #define PROFILE_THREAD(name) ::profiler::set_thread_name(name)
+    #define PROFILE_SESSION(path) \
+        const ::profiler::Session PROFILE_CONCAT(profile_session_, __LINE__) { path }
+#else
+    #define PROFILE_ZONE(name) static_cast<void>(0)
+    #define PROFILE_THREAD(name) static_cast<void>(0)
+    #define PROFILE_SESSION(path) static_cast<void>(0)
+#endif
+
+#endif
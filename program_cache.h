@@ -0,0 +1,273 @@
+#pragma once
+
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <glad/glad.h>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gl_extensions.h"
+
+namespace program_cache {
+    struct CacheStats {
+        uint32_t hits { 0 };
+        uint32_t misses { 0 };
+        // binaries found on disk that the driver refused, e.g. after a driver update
+        uint32_t rejected { 0 };
+        std::chrono::nanoseconds compile_time { 0 };
+        std::chrono::nanoseconds load_time { 0 };
+        std::chrono::nanoseconds compile_time_saved { 0 };
+    };
+
+    // Persists linked program binaries between launches. Entries are keyed by the stage
+    // sources and the GL_RENDERER / GL_VERSION strings, so a driver or GPU change misses instead
+    // of feeding the driver a binary it cannot use.
+    class ProgramCache {
+        std::filesystem::path directory_;
+        std::string device_;
+        CacheStats stats_ {};
+
+        auto entry_path(uint64_t key) const -> std::filesystem::path;
+
+    public:
+        explicit ProgramCache(std::filesystem::path directory);
+
+        auto enabled() const -> bool;
+        auto key(const std::vector<std::pair<uint32_t, std::string>>& stages) const -> uint64_t;
+
+        // Returns true when `program_id` was linked from the cached binary.
+        auto load(uint64_t key, uint32_t program_id) -> bool;
+        // Call before glLinkProgram on a miss, so the driver keeps the binary around.
+        auto prepare(uint32_t program_id) const -> void;
+        auto store(uint64_t key, uint32_t program_id, std::chrono::nanoseconds compile_time)
+            -> void;
+
+        auto stats() const -> const CacheStats&;
+        auto report() const -> void;
+    };
+
+    namespace detail {
+        constexpr std::array<char, 8> magic { 'L', 'O', 'G', 'L', 'P', 'B', '0', '1' };
+        // magic, binary format, compile time in nanoseconds and binary length
+        constexpr uintmax_t header_size = magic.size() + sizeof(uint32_t) + sizeof(uint64_t)
+            + sizeof(uint32_t);
+
+        constexpr auto fnv1a_offset_basis = 14695981039346656037ULL;
+        constexpr auto fnv1a_prime = 1099511628211ULL;
+
+        inline auto fnv1a(uint64_t hash, const void* data, const size_t size) -> uint64_t {
+            const auto* const bytes = static_cast<const uint8_t*>(data);
+            for (size_t i = 0; i < size; ++i) {
+                hash ^= bytes[i];
+                hash *= fnv1a_prime;
+            }
+            return hash;
+        }
+
+        inline auto gl_string(const GLenum name) -> std::string {
+            const auto* const value = reinterpret_cast<const char*>(glGetString(name));
+            return value == nullptr ? std::string {} : std::string { value };
+        }
+    } // namespace detail
+
+    inline ProgramCache::ProgramCache(std::filesystem::path directory):
+        directory_ { std::move(directory) },
+        device_ { detail::gl_string(GL_RENDERER) + '\n' + detail::gl_string(GL_VERSION) } {
+        if (!this->enabled()) {
+            return;
+        }
+        std::error_code error;
+        std::filesystem::create_directories(this->directory_, error);
+        if (error) {
+            std::cout << "ERROR: could not create program cache directory \""
+                << this->directory_.string() << "\": " << error.message() << '\n';
+        }
+    }
+
+    inline auto ProgramCache::enabled() const -> bool {
+        return gl_extensions::get().get_program_binary;
+    }
+
+    inline auto ProgramCache::entry_path(const uint64_t key) const -> std::filesystem::path {
+        std::stringstream name;
+        name << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+        return this->directory_ / name.str();
+    }
+
+    inline auto ProgramCache::key(
+        const std::vector<std::pair<uint32_t, std::string>>& stages
+    ) const -> uint64_t {
+        auto hash = detail::fnv1a(
+            detail::fnv1a_offset_basis,
+            this->device_.data(),
+            this->device_.size()
+        );
+        for (const auto& [shader_type, source] : stages) {
+            hash = detail::fnv1a(hash, &shader_type, sizeof(shader_type));
+            const auto length = static_cast<uint64_t>(source.size());
+            hash = detail::fnv1a(hash, &length, sizeof(length));
+            hash = detail::fnv1a(hash, source.data(), source.size());
+        }
+        return hash;
+    }
+
+    inline auto ProgramCache::load(const uint64_t key, const uint32_t program_id) -> bool {
+        if (!this->enabled()) {
+            return false;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+
+        const auto path = this->entry_path(key);
+        std::ifstream file { path, std::ios::binary };
+        if (file.fail()) {
+            ++this->stats_.misses;
+            return false;
+        }
+        std::error_code error;
+        const auto file_size = std::filesystem::file_size(path, error);
+        if (error || file_size < detail::header_size) {
+            ++this->stats_.misses;
+            return false;
+        }
+
+        std::array<char, detail::magic.size()> magic {};
+        uint32_t binary_format = 0;
+        uint64_t compile_ns = 0;
+        uint32_t length = 0;
+        file.read(magic.data(), static_cast<std::streamsize>(magic.size()));
+        file.read(reinterpret_cast<char*>(&binary_format), sizeof(binary_format));
+        file.read(reinterpret_cast<char*>(&compile_ns), sizeof(compile_ns));
+        file.read(reinterpret_cast<char*>(&length), sizeof(length));
+        // a corrupt or truncated entry must not size the allocation
+        if (file.fail() || length > file_size - detail::header_size) {
+            ++this->stats_.misses;
+            return false;
+        }
+        std::vector<char> binary(length);
+        file.read(binary.data(), static_cast<std::streamsize>(length));
+
+        if (file.fail() || magic != detail::magic) {
+            ++this->stats_.misses;
+            return false;
+        }
+
+        gl_extensions::get().glProgramBinary(
+            program_id,
+            binary_format,
+            binary.data(),
+            static_cast<GLsizei>(length)
+        );
+        auto success = 0;
+        glGetProgramiv(program_id, GL_LINK_STATUS, &success);
+        if (0 == success) {
+            ++this->stats_.rejected;
+            ++this->stats_.misses;
+            return false;
+        }
+
+        const auto load_time = std::chrono::steady_clock::now() - start;
+        const auto compile_time = std::chrono::nanoseconds { compile_ns };
+        ++this->stats_.hits;
+        this->stats_.load_time += load_time;
+        if (compile_time > load_time) {
+            this->stats_.compile_time_saved += compile_time - load_time;
+        }
+        return true;
+    }
+
+    inline auto ProgramCache::prepare(const uint32_t program_id) const -> void {
+        if (!this->enabled()) {
+            return;
+        }
+        gl_extensions::get().glProgramParameteri(
+            program_id,
+            GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+            GL_TRUE
+        );
+    }
+
+    inline auto ProgramCache::store(
+        const uint64_t key,
+        const uint32_t program_id,
+        const std::chrono::nanoseconds compile_time
+    ) -> void {
+        this->stats_.compile_time += compile_time;
+        if (!this->enabled()) {
+            return;
+        }
+
+        auto length = 0;
+        glGetProgramiv(program_id, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0) {
+            return;
+        }
+        std::vector<char> binary(static_cast<size_t>(length));
+        GLenum binary_format = 0;
+        const auto capacity = length;
+        gl_extensions::get().glGetProgramBinary(
+            program_id,
+            capacity,
+            &length,
+            &binary_format,
+            binary.data()
+        );
+        // the driver reports what it wrote; never write out more than the buffer holds
+        if (length <= 0 || length > capacity) {
+            return;
+        }
+
+        // write to a temporary first so a crash never leaves a truncated entry behind
+        const auto path = this->entry_path(key);
+        auto temporary_path = path;
+        temporary_path += ".tmp";
+        {
+            std::ofstream file { temporary_path, std::ios::binary | std::ios::trunc };
+            const auto format = static_cast<uint32_t>(binary_format);
+            const auto compile_ns = static_cast<uint64_t>(compile_time.count());
+            const auto size = static_cast<uint32_t>(length);
+            file.write(detail::magic.data(), static_cast<std::streamsize>(detail::magic.size()));
+            file.write(reinterpret_cast<const char*>(&format), sizeof(format));
+            file.write(reinterpret_cast<const char*>(&compile_ns), sizeof(compile_ns));
+            file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+            file.write(binary.data(), static_cast<std::streamsize>(size));
+            if (file.fail()) {
+                std::cout << "ERROR: could not write program cache entry \""
+                    << temporary_path.string() << "\"\n";
+                return;
+            }
+        }
+        std::error_code error;
+        std::filesystem::rename(temporary_path, path, error);
+        if (error) {
+            std::cout << "ERROR: could not write program cache entry \"" << path.string()
+                << "\": " << error.message() << '\n';
+        }
+    }
+
+    inline auto ProgramCache::stats() const -> const CacheStats& {
+        return this->stats_;
+    }
+
+    inline auto ProgramCache::report() const -> void {
+        using milliseconds = std::chrono::duration<double, std::milli>;
+        std::cout << "program cache: " << this->stats_.hits << " hits, " << this->stats_.misses
+            << " misses (" << this->stats_.rejected << " rejected by the driver), "
+            << milliseconds { this->stats_.compile_time }.count() << " ms compiling, "
+            << milliseconds { this->stats_.load_time }.count() << " ms loading binaries, "
+            << milliseconds { this->stats_.compile_time_saved }.count()
+            << " ms of compilation saved" << '\n';
+    }
+} // namespace program_cache
+
+#endif
@@ -0,0 +1,331 @@
+﻿#pragma once
+
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <glad/glad.h>
+#include <iostream>
+#include <memory>
+#include <optional>
+
+#include "frame_timing.h"
+#include "gl_calls.h"
+#include "gl_state.h"
+#include "profiler.h"
+#include "program_cache.h"
+#include "shader_compiler.h"
+#include "shader_preprocessor.h"
+#include "shader_program.h"
+#include "shader_reload.h"
+#include "texture_atlas.h"
+#include "texture_loader.h"
+
+// The render loop, independent of whoever owns the window or context. main.cpp drives it with
+// GLFW, headless_main.cpp with an offscreen EGL context.
+namespace scene {
+    namespace detail {
+        constexpr auto fallback_vertex_shader = R"(#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aColor;
+
+out vec3 ourColor;
+
+void main() {
+    gl_Position = vec4(aPos, 1.0);
+    ourColor = aColor;
+}
+)";
+
+        constexpr auto fallback_fragment_shader = R"(#version 330 core
+out vec4 FragColor;
+
+in vec3 ourColor;
+
+void main() {
+    FragColor = vec4(ourColor, 1.0);
+}
+)";
+
+        constexpr auto stride = 8;
+        constexpr auto vertices_len = static_cast<size_t>(stride) * static_cast<size_t>(3);
+        constexpr std::array<float, vertices_len> vertices = {
+            // bottom right
+            // v
+            0.5F,
+            -0.5F,
+            0.0F,
+            // c
+            1.0F,
+            0.0F,
+            0.0F,
+            // t
+            1.0F,
+            0.0F,
+            // bottom left
+            // v
+            -0.5F,
+            -0.5F,
+            0.0F,
+            // c
+            0.0F,
+            1.0F,
+            0.0F,
+            // t
+            0.0F,
+            0.0F,
+            // top
+            // v
+            0.0F,
+            0.5F,
+            0.0F,
+            // c
+            0.0F,
+            0.0F,
+            1.0F,
+            // t
+            0.5F,
+            1.0F
+        };
+    } // namespace detail
+
+    // Owns everything the loop draws. Construct it with the render context current; the
+    // compiler hooks are handed to shader_compiler::ShaderCompiler as they are.
+    class Scene {
+        uint32_t vao_ { 0 };
+        uint32_t vbo_ { 0 };
+        texture_loader::TextureLoader textures_ {};
+        texture_loader::TextureHandle container_jpg_texture_ { 0 };
+        texture_loader::TextureHandle awesomeface_png_texture_ { 0 };
+        // both textures as layers of one array where they share a format, size and sampler
+        // state, which the draw binds in place of each of them
+        std::optional<texture_atlas::LayerPacking> texture_layers_ {};
+
+        program_cache::ProgramCache program_cache_ { "shader_cache" };
+        std::unique_ptr<shader_compiler::ShaderCompiler> compiler_;
+        shader_reload::ReloadableProgram program_ {{
+            { GL_VERTEX_SHADER, "shaders/shader.vs.glsl" },
+            { GL_FRAGMENT_SHADER, "shaders/shader.fs.glsl" },
+        }};
+        shader_reload::ShaderWatcher shader_watcher_ { "shaders" };
+        // tiny enough to compile synchronously, and drawn until the real program is ready
+        shader_program::ShaderProgram fallback_program_;
+        gl_state::StateCache gl_state_ {};
+        frame_timing::FrameTimer timer_ { 600 };
+
+        // Packs the textures as they are now, placeholders included, and points the program's
+        // samplers at their layers.
+        auto pack_textures() -> void;
+        auto set_texture_uniforms() -> void;
+
+    public:
+        Scene(std::function<bool()> make_current, std::function<void()> release);
+        // Stops the compiler thread, so destroy the scene before its contexts.
+        ~Scene();
+
+        Scene(const Scene&) = delete;
+        auto operator=(const Scene&) -> Scene& = delete;
+
+        // True when an asset failed to load. Textures load in the background, so this only
+        // settles once ready() does.
+        auto failed() const -> bool;
+        // True once the real program replaced the fallback and no texture is still loading.
+        auto ready() const -> bool;
+        auto state() -> gl_state::StateCache&;
+
+        // Renders one frame into the bound framebuffer.
+        auto frame() -> void;
+        // Prints the frame timings since the last periodic report and the totals.
+        auto report() -> void;
+    };
+
+    inline Scene::Scene(std::function<bool()> make_current, std::function<void()> release):
+        compiler_ {
+            std::make_unique<shader_compiler::ShaderCompiler>(
+                std::move(make_current),
+                std::move(release),
+                &this->program_cache_
+            )
+        },
+        fallback_program_ {
+            shader_program::builder::ProgramBuilder {}
+            .add_shader_source(
+                GL_VERTEX_SHADER,
+                detail::fallback_vertex_shader
+            )->add_shader_source(
+                GL_FRAGMENT_SHADER,
+                detail::fallback_fragment_shader
+            )->build()
+        } {
+        glGenVertexArrays(1, &this->vao_);
+        glBindVertexArray(this->vao_);
+
+        glGenBuffers(1, &this->vbo_);
+        glBindBuffer(GL_ARRAY_BUFFER, this->vbo_);
+        glBufferData(
+            GL_ARRAY_BUFFER,
+            sizeof(detail::vertices),
+            static_cast<const void*>(detail::vertices.data()),
+            GL_STATIC_DRAW
+        );
+        glVertexAttribPointer(
+            0,
+            3,
+            GL_FLOAT,
+            GL_FALSE,
+            detail::stride * sizeof(float),
+            static_cast<void*>(nullptr)
+        );
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(
+            1,
+            3,
+            GL_FLOAT,
+            GL_FALSE,
+            detail::stride * sizeof(float),
+            reinterpret_cast<void*>(3 * sizeof(float))
+        );
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(
+            2,
+            2,
+            GL_FLOAT,
+            GL_FALSE,
+            detail::stride * sizeof(float),
+            reinterpret_cast<void*>(6 * sizeof(float))
+        );
+        glEnableVertexAttribArray(2);
+
+        this->container_jpg_texture_ = this->textures_.request({ "container.jpg", GL_RGB });
+        texture_loader::TextureRequest awesomeface { "awesomeface.png", GL_RGB };
+        awesomeface.wrap = GL_MIRRORED_REPEAT;
+        this->awesomeface_png_texture_ = this->textures_.request(std::move(awesomeface));
+        this->pack_textures();
+
+        this->program_.rebuild(*this->compiler_);
+        this->gl_state_.polygon_mode(GL_FILL);
+    }
+
+    inline Scene::~Scene() {
+        this->compiler_.reset();
+    }
+
+    inline auto Scene::pack_textures() -> void {
+        PROFILE_ZONE("pack textures");
+        this->texture_layers_.reset();
+        this->texture_layers_.emplace(std::vector {
+            this->textures_.texture(this->container_jpg_texture_),
+            this->textures_.texture(this->awesomeface_png_texture_),
+        });
+        this->set_texture_uniforms();
+    }
+
+    inline auto Scene::set_texture_uniforms() -> void {
+        if (!this->program_.get().has_value() || !this->texture_layers_.has_value()) {
+            return;
+        }
+        // array i is bound to unit i
+        const auto& program = *this->program_.get();
+        const auto& container = this->texture_layers_->slot(0);
+        const auto& awesomeface = this->texture_layers_->slot(1);
+        using shader_program::uniform_name;
+        program.set_int(uniform_name("texture1"), static_cast<int32_t>(container.array));
+        program.set_int(uniform_name("layer1"), static_cast<int32_t>(container.layer));
+        program.set_int(uniform_name("texture2"), static_cast<int32_t>(awesomeface.array));
+        program.set_int(uniform_name("layer2"), static_cast<int32_t>(awesomeface.layer));
+    }
+
+    inline auto Scene::failed() const -> bool {
+        using texture_loader::TextureState;
+        return this->textures_.state(this->container_jpg_texture_) == TextureState::failed
+            || this->textures_.state(this->awesomeface_png_texture_) == TextureState::failed;
+    }
+
+    inline auto Scene::ready() const -> bool {
+        return this->program_.get().has_value() && this->textures_.idle();
+    }
+
+    inline auto Scene::state() -> gl_state::StateCache& {
+        return this->gl_state_;
+    }
+
+    inline auto Scene::frame() -> void {
+        PROFILE_ZONE("Scene::frame");
+        this->gl_state_.begin_frame();
+        this->timer_.begin_frame();
+        gl_calls::begin_frame();
+
+        {
+            PROFILE_ZONE("reload");
+            this->timer_.begin_pass("reload");
+            // Any upload leaves the cached bindings stale. Packing copies every texture, so it
+            // waits for the last one instead of repacking as each arrives.
+            if (0 != this->textures_.poll()) {
+                if (this->textures_.idle()) {
+                    this->pack_textures();
+                }
+                this->gl_state_.invalidate();
+            }
+            for (const auto& path : this->shader_watcher_.poll()) {
+                const auto affected = this->program_.depends_on(path);
+                shader_preprocessor::shared().invalidate(path);
+                if (affected) {
+                    this->program_.rebuild(*this->compiler_);
+                }
+            }
+            if (this->program_.update(*this->compiler_)) {
+                this->program_cache_.report();
+                // a rebuilt program starts out with none of the samplers pointed anywhere
+                this->set_texture_uniforms();
+            }
+            this->timer_.end_pass();
+        }
+
+        {
+            PROFILE_ZONE("clear");
+            this->timer_.begin_pass("clear");
+            glClear(GL_COLOR_BUFFER_BIT);
+            this->timer_.end_pass();
+        }
+
+        {
+            PROFILE_ZONE("draw");
+            this->timer_.begin_pass("draw");
+            if (this->program_.get().has_value()) {
+                this->gl_state_.use_program(this->program_.get()->id());
+                this->program_.get()->flush();
+            } else {
+                this->gl_state_.use_program(this->fallback_program_.id());
+            }
+
+            this->gl_state_.bind_vertex_array(this->vao_);
+            const auto& arrays = this->texture_layers_->arrays();
+            for (size_t unit = 0; unit < arrays.size(); ++unit) {
+                this->gl_state_.bind_texture(
+                    static_cast<uint32_t>(unit),
+                    GL_TEXTURE_2D_ARRAY,
+                    arrays[unit].id
+                );
+            }
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            this->timer_.end_pass();
+        }
+    }
+
+    inline auto Scene::report() -> void {
+        this->timer_.report();
+        this->textures_.report();
+        if (this->program_.get().has_value()) {
+            const auto& uniform_stats = this->program_.get()->stats();
+            std::cout << "uniform writes: " << uniform_stats.issued << " issued, "
+                << uniform_stats.elided << " elided" << '\n';
+        }
+        std::cout << "state changes: " << this->gl_state_.total().issued << " issued, "
+            << this->gl_state_.total().filtered << " filtered" << '\n';
+    }
+} // namespace scene
+
+#endif
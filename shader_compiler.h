@@ -0,0 +1,227 @@
+#pragma once
+
+#ifndef SHADER_COMPILER_H
+#define SHADER_COMPILER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <glad/glad.h>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "profiler.h"
+#include "program_cache.h"
+#include "shader_program.h"
+
+namespace shader_compiler {
+    namespace detail {
+        struct Job {
+            // (shader type, path) pairs, handed to ProgramBuilder::add_shader in order
+            std::vector<std::pair<uint32_t, std::string>> shaders;
+
+            std::mutex mutex;
+            std::condition_variable finished;
+            std::atomic<bool> done { false };
+            std::optional<shader_program::ShaderProgram> program;
+            GLsync fence { nullptr };
+        };
+    } // namespace detail
+
+    // Handle to a program that is being built on the compiler thread. Only the render thread
+    // may query it, since readiness is checked with a fence on the render context.
+    class PendingProgram {
+        std::shared_ptr<detail::Job> job_;
+
+    public:
+        PendingProgram() = default;
+        explicit PendingProgram(std::shared_ptr<detail::Job> job);
+
+        auto valid() const -> bool;
+        // Never blocks. True once the program finished building, successfully or not, and the
+        // GPU finished the compiler thread's commands.
+        auto is_ready() -> bool;
+        auto wait() -> void;
+        // Empty when the build failed. Moves the program out, so call it once after is_ready().
+        auto take() -> std::optional<shader_program::ShaderProgram>;
+    };
+
+    // Builds programs on a background thread that owns a context sharing objects with the
+    // render context, so startup and reloads never block a frame on the driver's compiler.
+    class ShaderCompiler {
+        std::function<bool()> make_current_;
+        std::function<void()> release_;
+        program_cache::ProgramCache* cache_;
+
+        std::mutex mutex_;
+        std::condition_variable wake_;
+        std::deque<std::shared_ptr<detail::Job>> jobs_;
+        bool stopping_ { false };
+        std::thread worker_;
+
+        auto run() -> void;
+
+    public:
+        // `make_current` and `release` run on the compiler thread: the first binds a context
+        // from the render context's share group, the second unbinds it before the thread exits.
+        // `cache` is used from the compiler thread only.
+        ShaderCompiler(
+            std::function<bool()> make_current,
+            std::function<void()> release,
+            program_cache::ProgramCache* cache = nullptr
+        );
+        ~ShaderCompiler();
+
+        ShaderCompiler(const ShaderCompiler&) = delete;
+        auto operator=(const ShaderCompiler&) -> ShaderCompiler& = delete;
+
+        auto submit(std::vector<std::pair<uint32_t, std::string>> shaders) -> PendingProgram;
+    };
+
+    inline PendingProgram::PendingProgram(std::shared_ptr<detail::Job> job):
+        job_ { std::move(job) } {}
+
+    inline auto PendingProgram::valid() const -> bool {
+        return this->job_ != nullptr;
+    }
+
+    inline auto PendingProgram::is_ready() -> bool {
+        if (!this->valid() || !this->job_->done.load(std::memory_order_acquire)) {
+            return false;
+        }
+        if (this->job_->fence == nullptr) {
+            return true;
+        }
+        const auto status = glClientWaitSync(this->job_->fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            return false;
+        }
+        glDeleteSync(this->job_->fence);
+        this->job_->fence = nullptr;
+        return true;
+    }
+
+    inline auto PendingProgram::wait() -> void {
+        if (!this->valid()) {
+            return;
+        }
+        {
+            std::unique_lock lock { this->job_->mutex };
+            this->job_->finished.wait(lock, [this] {
+                return this->job_->done.load(std::memory_order_acquire);
+            });
+        }
+        if (this->job_->fence != nullptr) {
+            glClientWaitSync(this->job_->fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+            glDeleteSync(this->job_->fence);
+            this->job_->fence = nullptr;
+        }
+    }
+
+    inline auto PendingProgram::take() -> std::optional<shader_program::ShaderProgram> {
+        if (!this->valid()) {
+            return std::nullopt;
+        }
+        auto program = std::move(this->job_->program);
+        this->job_.reset();
+        return program;
+    }
+
+    inline ShaderCompiler::ShaderCompiler(
+        std::function<bool()> make_current,
+        std::function<void()> release,
+        program_cache::ProgramCache* cache
+    ):
+        make_current_ { std::move(make_current) },
+        release_ { std::move(release) },
+        cache_ { cache },
+        worker_ { [this] { this->run(); } } {}
+
+    inline ShaderCompiler::~ShaderCompiler() {
+        {
+            std::lock_guard lock { this->mutex_ };
+            this->stopping_ = true;
+        }
+        this->wake_.notify_one();
+        this->worker_.join();
+    }
+
+    inline auto ShaderCompiler::submit(
+        std::vector<std::pair<uint32_t, std::string>> shaders
+    ) -> PendingProgram {
+        auto job = std::make_shared<detail::Job>();
+        job->shaders = std::move(shaders);
+        {
+            std::lock_guard lock { this->mutex_ };
+            this->jobs_.push_back(job);
+        }
+        this->wake_.notify_one();
+        return PendingProgram { std::move(job) };
+    }
+
+    inline auto ShaderCompiler::run() -> void {
+        PROFILE_THREAD("shader compiler");
+        const auto has_context = this->make_current_();
+        if (!has_context) {
+            std::cout << "ERROR: shader compiler could not make its context current" << '\n';
+        }
+
+        while (true) {
+            std::shared_ptr<detail::Job> job;
+            {
+                std::unique_lock lock { this->mutex_ };
+                this->wake_.wait(lock, [this] { return this->stopping_ || !this->jobs_.empty(); });
+                if (this->stopping_) {
+                    break;
+                }
+                job = std::move(this->jobs_.front());
+                this->jobs_.pop_front();
+            }
+
+            if (has_context) {
+                shader_program::builder::ProgramBuilder builder { this->cache_ };
+                for (const auto& [shader_type, shader_path] : job->shaders) {
+                    builder.add_shader(shader_type, shader_path);
+                }
+                job->program = builder.try_build();
+                job->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+                // the render thread waits on the fence, so it has to reach the GPU
+                glFlush();
+            }
+
+            {
+                std::lock_guard lock { job->mutex };
+                job->done.store(true, std::memory_order_release);
+            }
+            job->finished.notify_all();
+        }
+
+        // fail whatever is still queued, so nobody waits forever on a stopped compiler
+        std::deque<std::shared_ptr<detail::Job>> abandoned;
+        {
+            std::lock_guard lock { this->mutex_ };
+            abandoned.swap(this->jobs_);
+        }
+        for (const auto& job : abandoned) {
+            {
+                std::lock_guard lock { job->mutex };
+                job->done.store(true, std::memory_order_release);
+            }
+            job->finished.notify_all();
+        }
+
+        if (has_context) {
+            this->release_();
+        }
+    }
+} // namespace shader_compiler
+
+#endif
@@ -0,0 +1,274 @@
+#pragma once
+
+#ifndef SHADER_PREPROCESSOR_H
+#define SHADER_PREPROCESSOR_H
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace shader_preprocessor {
+    // Resolves #include "file" (relative to the including file, each file at most once) and
+    // injects #defines right after #version. Includes inside /* */ comments are left alone, but
+    // ones under #if or #ifdef are always expanded, because the GLSL compiler only evaluates
+    // conditionals after this runs. Expanded sources are cached per path and define set until
+    // one of the files they were built from changes. Safe to share between threads.
+    class Preprocessor {
+        struct Expansion {
+            std::string source;
+            std::vector<std::filesystem::path> dependencies;
+        };
+
+        std::mutex mutex_;
+        std::unordered_map<std::string, Expansion> cache_;
+        // bumped by every invalidate(), so an expansion read before one is never cached after it
+        uint64_t generation_ { 0 };
+
+        static auto cache_key(
+            const std::filesystem::path& path,
+            const std::vector<std::string>& defines
+        ) -> std::string;
+        static auto read_file(const std::filesystem::path& path) -> std::optional<std::string>;
+        // Whether a /* */ comment is still open at the end of `line`, given whether one was at
+        // its start.
+        static auto ends_in_comment(const std::string& line, bool in_comment) -> bool;
+        static auto expand_file(
+            const std::filesystem::path& path,
+            Expansion& expansion,
+            std::vector<std::filesystem::path>& include_stack
+        ) -> bool;
+
+    public:
+        auto expand(const std::string& path, const std::vector<std::string>& defines)
+            -> std::optional<std::string>;
+        // True when `changed` is `path` itself or any file it includes, as of its last expansion.
+        auto depends_on(const std::string& path, const std::filesystem::path& changed)
+            -> bool;
+        // Drops every cached expansion built from `changed`.
+        auto invalidate(const std::filesystem::path& changed) -> void;
+    };
+
+    // The instance ProgramBuilder expands its stages with.
+    inline auto shared() -> Preprocessor& {
+        static Preprocessor preprocessor {};
+        return preprocessor;
+    }
+
+    inline auto Preprocessor::cache_key(
+        const std::filesystem::path& path,
+        const std::vector<std::string>& defines
+    ) -> std::string {
+        auto key = path.lexically_normal().generic_string();
+        for (const auto& define : defines) {
+            key += '\n';
+            key += define;
+        }
+        return key;
+    }
+
+    inline auto Preprocessor::read_file(const std::filesystem::path& path)
+        -> std::optional<std::string> {
+        std::ifstream file { path, std::ios::binary };
+        if (file.fail()) {
+            return std::nullopt;
+        }
+        std::stringstream contents;
+        contents << file.rdbuf();
+        auto source = contents.str();
+
+        // editors on Windows like to prepend a UTF-8 BOM, which GLSL compilers reject
+        constexpr std::string_view bom = "\xEF\xBB\xBF";
+        if (source.compare(0, bom.size(), bom) == 0) {
+            source.erase(0, bom.size());
+        }
+        return source;
+    }
+
+    inline auto Preprocessor::ends_in_comment(const std::string& line, bool in_comment) -> bool {
+        for (size_t i = 0; i + 1 < line.size(); ++i) {
+            if (in_comment) {
+                if (line[i] == '*' && line[i + 1] == '/') {
+                    in_comment = false;
+                    ++i;
+                }
+            } else if (line[i] == '/' && line[i + 1] == '/') {
+                break;
+            } else if (line[i] == '/' && line[i + 1] == '*') {
+                in_comment = true;
+                ++i;
+            }
+        }
+        return in_comment;
+    }
+
+    inline auto Preprocessor::expand_file(
+        const std::filesystem::path& path,
+        Expansion& expansion,
+        std::vector<std::filesystem::path>& include_stack
+    ) -> bool {
+        const auto normal_path = path.lexically_normal();
+        if (std::find(include_stack.begin(), include_stack.end(), normal_path)
+            != include_stack.end()) {
+            std::cout << "ERROR: \"" << normal_path.string() << "\" includes itself" << '\n';
+            return false;
+        }
+        if (std::find(expansion.dependencies.begin(), expansion.dependencies.end(), normal_path)
+            != expansion.dependencies.end()) {
+            return true;
+        }
+
+        const auto source = read_file(normal_path);
+        if (!source.has_value()) {
+            std::cout << "ERROR: could not read file \"" << normal_path.string() << "\"\n";
+            return false;
+        }
+        const auto file_index = expansion.dependencies.size();
+        expansion.dependencies.push_back(normal_path);
+        include_stack.push_back(normal_path);
+        if (file_index > 0) {
+            expansion.source += "#line 1 " + std::to_string(file_index) + '\n';
+        }
+
+        std::istringstream lines { *source };
+        std::string line;
+        auto line_number = 0;
+        auto in_comment = false;
+        while (std::getline(lines, line)) {
+            ++line_number;
+            const auto commented = in_comment;
+            in_comment = ends_in_comment(line, in_comment);
+
+            const auto directive = line.find_first_not_of(" \t");
+            if (commented || directive == std::string::npos
+                || line.compare(directive, 8, "#include") != 0) {
+                expansion.source += line;
+                expansion.source += '\n';
+                continue;
+            }
+
+            const auto open = line.find('"', directive);
+            const auto close = open == std::string::npos ? open : line.find('"', open + 1);
+            if (close == std::string::npos) {
+                std::cout << "ERROR: " << normal_path.string() << ':' << line_number
+                    << ": malformed #include" << '\n';
+                return false;
+            }
+            const auto include_path =
+                normal_path.parent_path() / line.substr(open + 1, close - open - 1);
+            if (!expand_file(include_path, expansion, include_stack)) {
+                return false;
+            }
+            // keep compiler messages pointing at the right file and line
+            if (in_comment) {
+                // the comment the #include line opened, standing in for that line
+                expansion.source += "#line " + std::to_string(line_number) + ' '
+                    + std::to_string(file_index) + "\n/*\n";
+            } else {
+                expansion.source += "#line " + std::to_string(line_number + 1) + ' '
+                    + std::to_string(file_index) + '\n';
+            }
+        }
+
+        include_stack.pop_back();
+        return true;
+    }
+
+    inline auto Preprocessor::expand(
+        const std::string& path,
+        const std::vector<std::string>& defines
+    ) -> std::optional<std::string> {
+        const auto key = cache_key(path, defines);
+        uint64_t generation = 0;
+        {
+            std::lock_guard lock { this->mutex_ };
+            const auto cached = this->cache_.find(key);
+            if (cached != this->cache_.end()) {
+                return cached->second.source;
+            }
+            generation = this->generation_;
+        }
+
+        Expansion expansion {};
+        std::vector<std::filesystem::path> include_stack;
+        if (!expand_file(path, expansion, include_stack)) {
+            return std::nullopt;
+        }
+
+        if (!defines.empty()) {
+            // #version has to stay the first statement, so the defines go right after it
+            const auto version = expansion.source.find("#version");
+            const auto insert_at = version == std::string::npos
+                ? 0
+                : expansion.source.find('\n', version) + 1;
+            const auto version_line = version == std::string::npos
+                ? 0
+                : std::count(expansion.source.begin(), expansion.source.begin() + insert_at, '\n');
+
+            std::string injected;
+            for (const auto& define : defines) {
+                const auto equals = define.find('=');
+                injected += "#define " + define.substr(0, equals);
+                if (equals != std::string::npos) {
+                    injected += ' ' + define.substr(equals + 1);
+                }
+                injected += '\n';
+            }
+            injected += "#line " + std::to_string(version_line + 1) + " 0\n";
+            expansion.source.insert(insert_at, injected);
+        }
+
+        std::lock_guard lock { this->mutex_ };
+        if (generation != this->generation_) {
+            // a file may have changed after we read it; let the next expansion cache the result
+            return std::move(expansion.source);
+        }
+        return this->cache_.insert_or_assign(key, std::move(expansion)).first->second.source;
+    }
+
+    inline auto Preprocessor::depends_on(
+        const std::string& path,
+        const std::filesystem::path& changed
+    ) -> bool {
+        const auto root = std::filesystem::path { path }.lexically_normal();
+        const auto normal_changed = changed.lexically_normal();
+        if (root == normal_changed) {
+            return true;
+        }
+
+        std::lock_guard lock { this->mutex_ };
+        return std::any_of(this->cache_.begin(), this->cache_.end(), [&](const auto& entry) {
+            const auto& dependencies = entry.second.dependencies;
+            return !dependencies.empty() && dependencies.front() == root
+                && std::find(dependencies.begin(), dependencies.end(), normal_changed)
+                != dependencies.end();
+        });
+    }
+
+    inline auto Preprocessor::invalidate(const std::filesystem::path& changed) -> void {
+        const auto normal_changed = changed.lexically_normal();
+
+        std::lock_guard lock { this->mutex_ };
+        ++this->generation_;
+        for (auto entry = this->cache_.begin(); entry != this->cache_.end();) {
+            const auto& dependencies = entry->second.dependencies;
+            if (std::find(dependencies.begin(), dependencies.end(), normal_changed)
+                != dependencies.end()) {
+                entry = this->cache_.erase(entry);
+            } else {
+                ++entry;
+            }
+        }
+    }
+} // namespace shader_preprocessor
+
+#endif
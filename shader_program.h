@@ -3,131 +3,456 @@
 #ifndef SHADER_H
 #define SHADER_H
 
+#include <algorithm>
 #include <array>
-#include <cassert>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
-#include <fstream>
+#include <cstring>
 #include <glad/glad.h>
 #include <iostream>
-#include <memory>
-#include <sstream>
+#include <optional>
 #include <string>
+#include <utility>
+#include <vector>
+
+#include "gl_extensions.h"
+#include "program_cache.h"
+#include "profiler.h"
+#include "shader_preprocessor.h"
 
 namespace shader_program {
+    // FNV-1a, usable in constant expressions so uniform names can be hashed at compile time.
+    constexpr auto hash_uniform_name(const char* name) -> uint32_t {
+        auto hash = 2166136261U;
+        for (; *name != '\0'; ++name) {
+            hash ^= static_cast<uint8_t>(*name);
+            hash *= 16777619U;
+        }
+        return hash;
+    }
+
+    struct UniformName {
+        uint32_t hash;
+        // checked against the program's names, since different names can share a hash
+        const char* name;
+    };
+
+    struct UniformHandle {
+        GLint location { -1 };
+        // index into the program's uniform table
+        int32_t slot { -1 };
+    };
+
+    constexpr auto uniform_name(const char* name) -> UniformName {
+        return UniformName { hash_uniform_name(name), name };
+    }
+
+    namespace literals {
+        constexpr auto operator""_uniform(const char* name, size_t /*length*/) -> UniformName {
+            return uniform_name(name);
+        }
+    } // namespace literals
+
+    enum class UniformKind : uint8_t {
+        integer,
+        floating,
+    };
+
+    // CPU copy of what the driver holds for one uniform, so unchanged writes never reach it.
+    struct UniformSlot {
+        uint32_t hash;
+        std::string name;
+        GLint location;
+        GLenum type;
+        uint32_t value { 0 };
+        UniformKind kind { UniformKind::integer };
+        // false until the first write, since shader initialisers may have set anything
+        bool known { false };
+        bool dirty { false };
+    };
+
+    struct UniformStats {
+        uint64_t issued { 0 };
+        uint64_t elided { 0 };
+    };
+
     class ShaderProgram {
         uint32_t shader_id_;
+        // The first reflected_ slots are sorted by hash, filled once from glGetActiveUniform
+        // after linking. Names it does not report, like "lights[2]", are looked up on first use
+        // and appended after them, so handles already given out keep their index.
+        mutable std::vector<UniformSlot> uniforms_;
+        size_t reflected_ { 0 };
+        mutable std::vector<int32_t> dirty_;
+        mutable UniformStats stats_ {};
+
+        auto reflect_uniforms() -> void;
+        auto stage(UniformHandle handle, UniformKind kind, uint32_t value) const -> void;
 
     public:
         explicit ShaderProgram(uint32_t shader_id);
 
+        // Move-only: a copy would keep its own shadow state for the same GL program, elide
+        // writes the other copy already changed, and leave the driver's values stale.
+        ShaderProgram(const ShaderProgram&) = delete;
+        auto operator=(const ShaderProgram&) -> ShaderProgram& = delete;
+        ShaderProgram(ShaderProgram&&) = default;
+        auto operator=(ShaderProgram&&) -> ShaderProgram& = default;
+
+        auto id() const -> uint32_t;
         auto use() const -> void;
+
+        auto uniform(UniformName name) const -> UniformHandle;
+        auto uniform(const std::string& name) const -> UniformHandle;
+        // Points the uniform block `name` at a uniform buffer binding point. Returns false when
+        // the program has no such block.
+        auto bind_uniform_block(const std::string& name, uint32_t binding) const -> bool;
+
+        // Setters only update the program's shadow copy; flush() sends what changed.
+        auto set_bool(UniformHandle handle, bool value) const -> void;
+        auto set_int(UniformHandle handle, int value) const -> void;
+        auto set_float(UniformHandle handle, float value) const -> void;
+
+        auto set_bool(UniformName name, bool value) const -> void;
+        auto set_int(UniformName name, int value) const -> void;
+        auto set_float(UniformName name, float value) const -> void;
+
         auto set_bool(const std::string& name, bool value) const -> void;
         auto set_int(const std::string& name, int value) const -> void;
         auto set_float(const std::string& name, float value) const -> void;
+
+        // Issues the uniforms written since the last flush. Call with the program in use, right
+        // before drawing with it.
+        auto flush() const -> void;
+        auto stats() const -> const UniformStats&;
     };
 
     inline ShaderProgram::ShaderProgram(const uint32_t shader_id):
-        shader_id_ { shader_id } {}
+        shader_id_ { shader_id } {
+        this->reflect_uniforms();
+    }
+
+    inline auto ShaderProgram::reflect_uniforms() -> void {
+        if (this->shader_id_ == 0) {
+            return;
+        }
+        auto uniform_count = 0;
+        auto max_name_length = 0;
+        glGetProgramiv(this->shader_id_, GL_ACTIVE_UNIFORMS, &uniform_count);
+        glGetProgramiv(this->shader_id_, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_length);
+
+        std::vector<char> name(static_cast<size_t>(max_name_length) + 1);
+        this->uniforms_.reserve(static_cast<size_t>(uniform_count));
+
+        for (auto i = 0; i < uniform_count; ++i) {
+            GLsizei name_length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(
+                this->shader_id_,
+                static_cast<GLuint>(i),
+                static_cast<GLsizei>(name.size()),
+                &name_length,
+                &size,
+                &type,
+                name.data()
+            );
+
+            const auto location = glGetUniformLocation(this->shader_id_, name.data());
+            if (location < 0) {
+                // uniform block members have no location
+                continue;
+            }
+
+            // arrays are reported as "name[0]", but callers address them by "name"
+            constexpr auto array_suffix_length = 3;
+            if (name_length > array_suffix_length
+                && 0 == std::strcmp(name.data() + name_length - array_suffix_length, "[0]")) {
+                name[static_cast<size_t>(name_length - array_suffix_length)] = '\0';
+            }
+
+            this->uniforms_.push_back(
+                UniformSlot { hash_uniform_name(name.data()), name.data(), location, type }
+            );
+        }
+
+        std::sort(
+            this->uniforms_.begin(),
+            this->uniforms_.end(),
+            [](const UniformSlot& lhs, const UniformSlot& rhs) { return lhs.hash < rhs.hash; }
+        );
+        this->reflected_ = this->uniforms_.size();
+    }
+
+    inline auto ShaderProgram::id() const -> uint32_t {
+        return this->shader_id_;
+    }
 
     inline auto ShaderProgram::use() const -> void {
         glUseProgram(this->shader_id_);
     }
 
+    inline auto ShaderProgram::uniform(const UniformName name) const -> UniformHandle {
+        const auto handle = [this](const size_t index) {
+            const auto location = this->uniforms_[index].location;
+            return location < 0
+                ? UniformHandle {}
+                : UniformHandle { location, static_cast<int32_t>(index) };
+        };
+
+        const auto reflected_end = this->uniforms_.begin()
+            + static_cast<std::ptrdiff_t>(this->reflected_);
+        const auto slot = std::lower_bound(
+            this->uniforms_.begin(),
+            reflected_end,
+            name.hash,
+            [](const UniformSlot& lhs, const uint32_t hash) { return lhs.hash < hash; }
+        );
+        for (auto it = slot; it != reflected_end && it->hash == name.hash; ++it) {
+            if (it->name == name.name) {
+                return handle(static_cast<size_t>(it - this->uniforms_.begin()));
+            }
+        }
+        for (auto i = this->reflected_; i < this->uniforms_.size(); ++i) {
+            if (this->uniforms_[i].hash == name.hash && this->uniforms_[i].name == name.name) {
+                return handle(i);
+            }
+        }
+
+        if (this->shader_id_ == 0) {
+            return UniformHandle {};
+        }
+        // An element or member of an array, or a name the program lacks. Either way ask the
+        // driver once and remember the answer, -1 included.
+        const auto location = glGetUniformLocation(this->shader_id_, name.name);
+        if (location >= 0) {
+            // "arr[0]" is the slot reflected as "arr"; two slots for one location would each
+            // elide against their own copy of the value
+            for (size_t i = 0; i < this->uniforms_.size(); ++i) {
+                if (this->uniforms_[i].location == location) {
+                    return handle(i);
+                }
+            }
+        }
+        this->uniforms_.push_back(UniformSlot { name.hash, name.name, location, 0 });
+        return handle(this->uniforms_.size() - 1);
+    }
+
+    inline auto ShaderProgram::uniform(const std::string& name) const -> UniformHandle {
+        return this->uniform(uniform_name(name.c_str()));
+    }
+
+    inline auto ShaderProgram::bind_uniform_block(
+        const std::string& name,
+        const uint32_t binding
+    ) const -> bool {
+        const auto block_index = glGetUniformBlockIndex(this->shader_id_, name.c_str());
+        if (block_index == GL_INVALID_INDEX) {
+            return false;
+        }
+        glUniformBlockBinding(this->shader_id_, block_index, binding);
+        return true;
+    }
+
+    inline auto ShaderProgram::stage(
+        const UniformHandle handle,
+        const UniformKind kind,
+        const uint32_t value
+    ) const -> void {
+        // a handle from another program, e.g. the one a reload replaced, points at nothing here
+        if (handle.slot < 0
+            || static_cast<size_t>(handle.slot) >= this->uniforms_.size()
+            || this->uniforms_[static_cast<size_t>(handle.slot)].location != handle.location) {
+            return;
+        }
+        auto& slot = this->uniforms_[static_cast<size_t>(handle.slot)];
+        if (slot.known && slot.kind == kind && slot.value == value) {
+            ++this->stats_.elided;
+            return;
+        }
+        slot.value = value;
+        slot.kind = kind;
+        slot.known = true;
+        if (slot.dirty) {
+            // the pending write is superseded before it ever reached the driver
+            ++this->stats_.elided;
+            return;
+        }
+        slot.dirty = true;
+        this->dirty_.push_back(handle.slot);
+    }
+
+    inline auto ShaderProgram::set_bool(
+        const UniformHandle handle,
+        const bool value
+    ) const -> void {
+        this->stage(handle, UniformKind::integer, static_cast<uint32_t>(value));
+    }
+
+    inline auto ShaderProgram::set_int(
+        const UniformHandle handle,
+        const int value
+    ) const -> void {
+        this->stage(handle, UniformKind::integer, static_cast<uint32_t>(value));
+    }
+
+    inline auto ShaderProgram::set_float(
+        const UniformHandle handle,
+        const float value
+    ) const -> void {
+        uint32_t bits = 0;
+        std::memcpy(&bits, &value, sizeof(bits));
+        this->stage(handle, UniformKind::floating, bits);
+    }
+
+    inline auto ShaderProgram::set_bool(
+        const UniformName name,
+        const bool value
+    ) const -> void {
+        this->set_bool(this->uniform(name), value);
+    }
+
+    inline auto ShaderProgram::set_int(
+        const UniformName name,
+        const int value
+    ) const -> void {
+        this->set_int(this->uniform(name), value);
+    }
+
+    inline auto ShaderProgram::set_float(
+        const UniformName name,
+        const float value
+    ) const -> void {
+        this->set_float(this->uniform(name), value);
+    }
+
     inline auto ShaderProgram::set_bool(
         const std::string& name,
         const bool value
     ) const -> void {
-        glUniform1i(
-            glGetUniformLocation(this->shader_id_, name.c_str()),
-            static_cast<GLint>(value)
-        );
+        this->set_bool(this->uniform(name), value);
     }
 
     inline auto ShaderProgram::set_int(
         const std::string& name,
         const int value
     ) const -> void {
-        glUniform1i(glGetUniformLocation(this->shader_id_, name.c_str()), value);
+        this->set_int(this->uniform(name), value);
     }
 
     inline auto ShaderProgram::set_float(
         const std::string& name,
         const float value
     ) const -> void {
-        glUniform1f(glGetUniformLocation(this->shader_id_, name.c_str()), value);
+        this->set_float(this->uniform(name), value);
+    }
+
+    inline auto ShaderProgram::flush() const -> void {
+        for (const auto index : this->dirty_) {
+            auto& slot = this->uniforms_[static_cast<size_t>(index)];
+            if (slot.kind == UniformKind::floating) {
+                float value = 0.0F;
+                std::memcpy(&value, &slot.value, sizeof(value));
+                glUniform1f(slot.location, value);
+            } else {
+                glUniform1i(slot.location, static_cast<GLint>(slot.value));
+            }
+            slot.dirty = false;
+        }
+        this->stats_.issued += this->dirty_.size();
+        this->dirty_.clear();
+    }
+
+    inline auto ShaderProgram::stats() const -> const UniformStats& {
+        return this->stats_;
     }
 
     namespace builder {
         class ProgramBuilder {
         private:
             bool err_ { false };
+            bool submitted_ { false };
+            bool from_cache_ { false };
             uint32_t program_id_;
+            program_cache::ProgramCache* cache_;
+            uint64_t cache_key_ { 0 };
+            std::vector<std::string> defines_;
+            std::vector<std::pair<uint32_t, std::string>> stages_;
+            std::vector<uint32_t> shader_ids_;
+            std::chrono::steady_clock::time_point compile_start_ {};
+
+            auto report_errors() const -> void;
 
         public:
-            explicit ProgramBuilder():
-                program_id_ { glCreateProgram() } {}
+            explicit ProgramBuilder(program_cache::ProgramCache* cache = nullptr):
+                program_id_ { glCreateProgram() },
+                cache_ { cache } {}
 
+            // "NAME" or "NAME=VALUE", applied to every shader added afterwards
+            auto define(std::string define) -> ProgramBuilder*;
             auto add_shader(
                 uint32_t shader_type,
                 const std::string& shader_path
             ) -> ProgramBuilder*;
+            auto add_shader_source(uint32_t shader_type, std::string source) -> ProgramBuilder*;
             auto set_bool(const std::string& name, bool value) const -> void;
             auto set_int(const std::string& name, int value) const -> void;
             auto set_float(const std::string& name, float value) const -> void;
 
-            auto build() const -> ShaderProgram;
+            // Issues the compiles and the single link without waiting for either.
+            auto submit() -> ProgramBuilder*;
+            // Never blocks when the driver supports parallel shader compilation.
+            auto is_ready() const -> bool;
+            // A failed compile or link is printed, and gives a program with id 0, which draws
+            // nothing and has no uniforms.
+            auto build() -> ShaderProgram;
+            // Like build(), but reports a failed compile or link as an empty optional.
+            auto try_build() -> std::optional<ShaderProgram>;
+
+            // Submits every builder before waiting on any of them, so the driver can compile
+            // all programs concurrently.
+            static auto build_all(std::vector<ProgramBuilder>& builders)
+                -> std::vector<ShaderProgram>;
         };
     } // namespace builder
 } // namespace shader_program
 
 
+inline auto shader_program::builder::ProgramBuilder::define(std::string define)
+    -> ProgramBuilder* {
+    this->defines_.push_back(std::move(define));
+
+    return this;
+}
+
 inline auto shader_program::builder::ProgramBuilder::add_shader(
     const uint32_t shader_type,
     const std::string& shader_path
 ) -> ProgramBuilder* {
+    PROFILE_ZONE("ProgramBuilder::add_shader");
     if (err_) {
         return this;
     }
-    const auto file_stream = std::make_unique<std::ifstream>(shader_path);
-    if (file_stream->fail()) {
-        std::cout << "ERROR: could not read file \"" << shader_path;
-
+    auto source = shader_preprocessor::shared().expand(shader_path, this->defines_);
+    if (!source.has_value()) {
         this->err_ = true;
         return this;
     }
-    std::stringstream contents_string_stream;
-    contents_string_stream << file_stream->rdbuf();
-
-    const auto contents_string = contents_string_stream.str();
-    const auto contents = std::make_unique<const char*>(contents_string.c_str());
-
-    auto success = 0;
-    constexpr auto info_log_buffer_size = 512;
-    std::array<char, info_log_buffer_size> info_log {};
 
-    const auto shader_id = glCreateShader(shader_type);
-    glShaderSource(shader_id, 1, &*contents, nullptr);
-    glCompileShader(shader_id);
-    glGetShaderiv(shader_id, GL_COMPILE_STATUS, &success);
+    this->stages_.emplace_back(shader_type, std::move(*source));
 
-    if (0 == success) {
-        glGetShaderInfoLog(shader_id, info_log_buffer_size, nullptr, info_log.data());
-        std::cout << "ERROR: shader failed to compile\n" << info_log.data() << '\n';
-        this->err_ = true;
-        return this;
-    }
+    return this;
+}
 
-    glAttachShader(this->program_id_, shader_id);
-    glLinkProgram(this->program_id_);
-    glGetProgramiv(this->program_id_, GL_LINK_STATUS, &success);
-    if (0 == success) {
-        glGetProgramInfoLog(this->program_id_, info_log_buffer_size, nullptr, info_log.data());
-        std::cout << "ERROR: linking shader failed\n" << info_log.data() << '\n';
-        this->err_ = true;
+inline auto shader_program::builder::ProgramBuilder::add_shader_source(
+    const uint32_t shader_type,
+    std::string source
+) -> ProgramBuilder* {
+    if (err_) {
         return this;
     }
-
-    glDeleteShader(shader_id);
+    this->stages_.emplace_back(shader_type, std::move(source));
 
     return this;
 }
@@ -156,10 +481,121 @@ inline auto shader_program::builder::ProgramBuilder::set_float(
     glUniform1f(glGetUniformLocation(this->program_id_, name.c_str()), value);
 }
 
-inline auto shader_program::builder::ProgramBuilder::build() const -> ShaderProgram {
-    assert(!this->err_);
+inline auto shader_program::builder::ProgramBuilder::submit() -> ProgramBuilder* {
+    if (this->submitted_) {
+        return this;
+    }
+    this->submitted_ = true;
+    if (this->err_) {
+        return this;
+    }
+
+    if (this->cache_ != nullptr) {
+        this->cache_key_ = this->cache_->key(this->stages_);
+        if (this->cache_->load(this->cache_key_, this->program_id_)) {
+            this->from_cache_ = true;
+            return this;
+        }
+        this->cache_->prepare(this->program_id_);
+    }
+
+    this->compile_start_ = std::chrono::steady_clock::now();
+    for (const auto& [shader_type, source] : this->stages_) {
+        const auto* const contents = source.c_str();
+        const auto shader_id = glCreateShader(shader_type);
+        glShaderSource(shader_id, 1, &contents, nullptr);
+        glCompileShader(shader_id);
+        glAttachShader(this->program_id_, shader_id);
+        this->shader_ids_.push_back(shader_id);
+    }
+    // compile errors surface as a failed link, so nothing is queried until the program is used
+    glLinkProgram(this->program_id_);
+
+    return this;
+}
+
+inline auto shader_program::builder::ProgramBuilder::is_ready() const -> bool {
+    if (!this->submitted_ || this->err_ || this->from_cache_) {
+        return this->submitted_;
+    }
+    if (!gl_extensions::get().parallel_shader_compile) {
+        return true;
+    }
+    auto completed = 0;
+    glGetProgramiv(this->program_id_, GL_COMPLETION_STATUS_KHR, &completed);
+    return 0 != completed;
+}
 
+inline auto shader_program::builder::ProgramBuilder::report_errors() const -> void {
+    constexpr auto info_log_buffer_size = 512;
+    std::array<char, info_log_buffer_size> info_log {};
+
+    for (const auto shader_id : this->shader_ids_) {
+        auto success = 0;
+        glGetShaderiv(shader_id, GL_COMPILE_STATUS, &success);
+        if (0 == success) {
+            glGetShaderInfoLog(shader_id, info_log_buffer_size, nullptr, info_log.data());
+            std::cout << "ERROR: shader failed to compile\n" << info_log.data() << '\n';
+            return;
+        }
+    }
+
+    glGetProgramInfoLog(this->program_id_, info_log_buffer_size, nullptr, info_log.data());
+    std::cout << "ERROR: linking shader failed\n" << info_log.data() << '\n';
+}
+
+inline auto shader_program::builder::ProgramBuilder::build() -> ShaderProgram {
+    auto program = this->try_build();
+    if (!program.has_value()) {
+        std::cout << "ERROR: program failed to build, using program 0 in its place" << '\n';
+        return ShaderProgram { 0 };
+    }
+    return std::move(*program);
+}
+
+inline auto shader_program::builder::ProgramBuilder::try_build() -> std::optional<ShaderProgram> {
+    this->submit();
+
+    if (!this->err_ && !this->from_cache_) {
+        auto success = 0;
+        glGetProgramiv(this->program_id_, GL_LINK_STATUS, &success);
+        const auto compile_time = std::chrono::steady_clock::now() - this->compile_start_;
+        if (0 == success) {
+            this->report_errors();
+            this->err_ = true;
+        }
+
+        for (const auto shader_id : this->shader_ids_) {
+            glDetachShader(this->program_id_, shader_id);
+            glDeleteShader(shader_id);
+        }
+        this->shader_ids_.clear();
+
+        if (!this->err_ && this->cache_ != nullptr) {
+            this->cache_->store(this->cache_key_, this->program_id_, compile_time);
+        }
+    }
+
+    if (this->err_) {
+        glDeleteProgram(this->program_id_);
+        return std::nullopt;
+    }
     return ShaderProgram { this->program_id_ };
 }
 
+inline auto shader_program::builder::ProgramBuilder::build_all(
+    std::vector<ProgramBuilder>& builders
+) -> std::vector<ShaderProgram> {
+    for (auto& builder : builders) {
+        builder.submit();
+    }
+
+    std::vector<ShaderProgram> programs;
+    programs.reserve(builders.size());
+    for (auto& builder : builders) {
+        programs.push_back(builder.build());
+    }
+    return programs;
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,219 @@
+#pragma once
+
+#ifndef SHADER_RELOAD_H
+#define SHADER_RELOAD_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <glad/glad.h>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+    #include <fcntl.h>
+    #include <poll.h>
+    #include <sys/inotify.h>
+    #include <unistd.h>
+#endif
+
+#include "shader_compiler.h"
+#include "shader_preprocessor.h"
+#include "shader_program.h"
+
+namespace shader_reload {
+    // Watches a directory for shader edits on a background thread. The render loop only ever
+    // swaps out the set of changed paths, so it never waits on the file system.
+    class ShaderWatcher {
+        std::filesystem::path directory_;
+        std::mutex mutex_;
+        std::vector<std::filesystem::path> changed_;
+#ifdef __linux__
+        int inotify_fd_ { -1 };
+        std::array<int, 2> stop_pipe_ { -1, -1 };
+        std::thread worker_;
+
+        auto run() -> void;
+#endif
+
+    public:
+        explicit ShaderWatcher(std::filesystem::path directory);
+        ~ShaderWatcher();
+
+        ShaderWatcher(const ShaderWatcher&) = delete;
+        auto operator=(const ShaderWatcher&) -> ShaderWatcher& = delete;
+
+        // Paths that were written since the last call, each listed once.
+        auto poll() -> std::vector<std::filesystem::path>;
+    };
+
+    // A program that can be rebuilt from its sources while the previous build keeps drawing.
+    class ReloadableProgram {
+        std::vector<std::pair<uint32_t, std::string>> shaders_;
+        std::optional<shader_program::ShaderProgram> current_;
+        shader_compiler::PendingProgram pending_;
+        // sources changed again while a build was in flight
+        bool stale_ { false };
+
+    public:
+        explicit ReloadableProgram(std::vector<std::pair<uint32_t, std::string>> shaders);
+
+        // Includes count, so check before the preprocessor cache is invalidated for `path`.
+        auto depends_on(const std::filesystem::path& path) const -> bool;
+        auto rebuild(shader_compiler::ShaderCompiler& compiler) -> void;
+        // Call between frames. Returns true when a freshly built program replaced the current
+        // one; a failed build leaves the current program in place.
+        auto update(shader_compiler::ShaderCompiler& compiler) -> bool;
+        auto get() const -> const std::optional<shader_program::ShaderProgram>&;
+    };
+
+    inline ShaderWatcher::ShaderWatcher(std::filesystem::path directory):
+        directory_ { std::move(directory) } {
+#ifdef __linux__
+        this->inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (this->inotify_fd_ < 0) {
+            std::cout << "ERROR: inotify_init1 failed, shader hot reload is disabled" << '\n';
+            return;
+        }
+        // editors either rewrite files in place or rename a temporary over them
+        const auto watch = inotify_add_watch(
+            this->inotify_fd_,
+            this->directory_.c_str(),
+            IN_CLOSE_WRITE | IN_MOVED_TO
+        );
+        if (watch < 0 || pipe2(this->stop_pipe_.data(), O_CLOEXEC) != 0) {
+            std::cout << "ERROR: could not watch \"" << this->directory_.string()
+                << "\", shader hot reload is disabled" << '\n';
+            close(this->inotify_fd_);
+            this->inotify_fd_ = -1;
+            return;
+        }
+        this->worker_ = std::thread { [this] { this->run(); } };
+#else
+        std::cout << "shader hot reload is only implemented on Linux" << '\n';
+#endif
+    }
+
+    inline ShaderWatcher::~ShaderWatcher() {
+#ifdef __linux__
+        if (this->worker_.joinable()) {
+            constexpr char stop = 0;
+            [[maybe_unused]] const auto written = write(this->stop_pipe_[1], &stop, sizeof(stop));
+            this->worker_.join();
+        }
+        for (const auto fd : { this->inotify_fd_, this->stop_pipe_[0], this->stop_pipe_[1] }) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+#endif
+    }
+
+#ifdef __linux__
+    inline auto ShaderWatcher::run() -> void {
+        alignas(inotify_event) std::array<char, 4096> buffer {};
+        std::array<pollfd, 2> fds {
+            pollfd { this->inotify_fd_, POLLIN, 0 },
+            pollfd { this->stop_pipe_[0], POLLIN, 0 },
+        };
+
+        while (true) {
+            if (::poll(fds.data(), fds.size(), -1) < 0) {
+                continue;
+            }
+            if ((fds[1].revents & POLLIN) != 0) {
+                return;
+            }
+
+            ssize_t length = 0;
+            while ((length = read(this->inotify_fd_, buffer.data(), buffer.size())) > 0) {
+                std::vector<std::filesystem::path> changed;
+                for (ssize_t offset = 0; offset < length;) {
+                    const auto* const event =
+                        reinterpret_cast<const inotify_event*>(buffer.data() + offset);
+                    if (event->len > 0) {
+                        changed.push_back((this->directory_ / event->name).lexically_normal());
+                    }
+                    offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+                }
+
+                std::lock_guard lock { this->mutex_ };
+                for (auto& path : changed) {
+                    if (std::find(this->changed_.begin(), this->changed_.end(), path)
+                        == this->changed_.end()) {
+                        this->changed_.push_back(std::move(path));
+                    }
+                }
+            }
+        }
+    }
+#endif
+
+    inline auto ShaderWatcher::poll() -> std::vector<std::filesystem::path> {
+        std::vector<std::filesystem::path> changed;
+        // never wait on the watcher thread; anything missed now is picked up next frame
+        std::unique_lock lock { this->mutex_, std::try_to_lock };
+        if (lock.owns_lock()) {
+            changed.swap(this->changed_);
+        }
+        return changed;
+    }
+
+    inline ReloadableProgram::ReloadableProgram(
+        std::vector<std::pair<uint32_t, std::string>> shaders
+    ):
+        shaders_ { std::move(shaders) } {}
+
+    inline auto ReloadableProgram::depends_on(const std::filesystem::path& path) const -> bool {
+        return std::any_of(
+            this->shaders_.begin(),
+            this->shaders_.end(),
+            [&path](const std::pair<uint32_t, std::string>& shader) {
+                return shader_preprocessor::shared().depends_on(shader.second, path);
+            }
+        );
+    }
+
+    inline auto ReloadableProgram::rebuild(shader_compiler::ShaderCompiler& compiler) -> void {
+        if (this->pending_.valid()) {
+            this->stale_ = true;
+            return;
+        }
+        this->pending_ = compiler.submit(this->shaders_);
+    }
+
+    inline auto ReloadableProgram::update(shader_compiler::ShaderCompiler& compiler) -> bool {
+        if (!this->pending_.is_ready()) {
+            return false;
+        }
+
+        auto program = this->pending_.take();
+        if (this->stale_) {
+            this->stale_ = false;
+            this->pending_ = compiler.submit(this->shaders_);
+        }
+        if (!program.has_value()) {
+            std::cout << "ERROR: shader rebuild failed, keeping the previous program" << '\n';
+            return false;
+        }
+
+        if (this->current_.has_value()) {
+            glDeleteProgram(this->current_->id());
+        }
+        this->current_ = std::move(program);
+        return true;
+    }
+
+    inline auto ReloadableProgram::get() const
+        -> const std::optional<shader_program::ShaderProgram>& {
+        return this->current_;
+    }
+} // namespace shader_reload
+
+#endif
@@ -0,0 +1,126 @@
+#pragma once
+
+#ifndef SHADER_VARIANTS_H
+#define SHADER_VARIANTS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <glad/glad.h>
+#include <iostream>
+#include <list>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "program_cache.h"
+#include "shader_program.h"
+
+namespace shader_variants {
+    // Specialised builds of one program, keyed by a feature bitmask where bit i defines
+    // features[i]. Variants compile on first use and the least recently used one is deleted
+    // once more than `capacity` are resident.
+    class VariantTable {
+        struct Variant {
+            std::optional<shader_program::ShaderProgram> program;
+            std::list<uint64_t>::iterator recency;
+        };
+
+        std::vector<std::pair<uint32_t, std::string>> shaders_;
+        std::vector<std::string> features_;
+        size_t capacity_;
+        program_cache::ProgramCache* cache_;
+
+        // most recently used first
+        std::list<uint64_t> recency_;
+        std::unordered_map<uint64_t, Variant> variants_;
+
+        auto evict() -> void;
+
+    public:
+        VariantTable(
+            std::vector<std::pair<uint32_t, std::string>> shaders,
+            std::vector<std::string> features,
+            size_t capacity,
+            program_cache::ProgramCache* cache = nullptr
+        );
+        ~VariantTable();
+
+        VariantTable(const VariantTable&) = delete;
+        auto operator=(const VariantTable&) -> VariantTable& = delete;
+
+        // nullptr when the variant failed to build; the failure is remembered until eviction
+        auto get(uint64_t features) -> const shader_program::ShaderProgram*;
+        auto size() const -> size_t;
+    };
+
+    inline VariantTable::VariantTable(
+        std::vector<std::pair<uint32_t, std::string>> shaders,
+        std::vector<std::string> features,
+        const size_t capacity,
+        program_cache::ProgramCache* cache
+    ):
+        shaders_ { std::move(shaders) },
+        features_ { std::move(features) },
+        capacity_ { std::max<size_t>(capacity, 1) },
+        cache_ { cache } {
+        this->variants_.reserve(this->capacity_ + 1);
+    }
+
+    inline VariantTable::~VariantTable() {
+        for (const auto& [features, variant] : this->variants_) {
+            if (variant.program.has_value()) {
+                glDeleteProgram(variant.program->id());
+            }
+        }
+    }
+
+    inline auto VariantTable::get(const uint64_t features)
+        -> const shader_program::ShaderProgram* {
+        const auto found = this->variants_.find(features);
+        if (found != this->variants_.end()) {
+            this->recency_.splice(this->recency_.begin(), this->recency_, found->second.recency);
+            return found->second.program.has_value() ? &*found->second.program : nullptr;
+        }
+
+        shader_program::builder::ProgramBuilder builder { this->cache_ };
+        for (size_t bit = 0; bit < this->features_.size(); ++bit) {
+            if ((features & (uint64_t { 1 } << bit)) != 0) {
+                builder.define(this->features_[bit]);
+            }
+        }
+        for (const auto& [shader_type, shader_path] : this->shaders_) {
+            builder.add_shader(shader_type, shader_path);
+        }
+        auto program = builder.try_build();
+        if (!program.has_value()) {
+            std::cout << "ERROR: shader variant " << features << " failed to build" << '\n';
+        }
+
+        this->recency_.push_front(features);
+        auto& variant = this->variants_[features];
+        variant.program = std::move(program);
+        variant.recency = this->recency_.begin();
+        this->evict();
+
+        return variant.program.has_value() ? &*variant.program : nullptr;
+    }
+
+    inline auto VariantTable::evict() -> void {
+        while (this->variants_.size() > this->capacity_ && !this->recency_.empty()) {
+            const auto oldest = this->variants_.find(this->recency_.back());
+            if (oldest->second.program.has_value()) {
+                glDeleteProgram(oldest->second.program->id());
+            }
+            this->variants_.erase(oldest);
+            this->recency_.pop_back();
+        }
+    }
+
+    inline auto VariantTable::size() const -> size_t {
+        return this->variants_.size();
+    }
+} // namespace shader_variants
+
+#endif
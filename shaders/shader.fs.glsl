@@ -4,13 +4,16 @@ out vec4 FragColor;
 in vec3 ourColor;
 in vec2 TexCoord;
 
-uniform sampler2D texture1;
-uniform sampler2D texture2;
+// both may be the same array, with the textures in layers of it
+uniform sampler2DArray texture1;
+uniform sampler2DArray texture2;
+uniform int layer1;
+uniform int layer2;
 
 void main() {
     FragColor = mix(
-        texture(texture1, TexCoord),
-        texture(texture2, TexCoord),
+        texture(texture1, vec3(TexCoord, layer1)),
+        texture(texture2, vec3(TexCoord, layer2)),
         0.2f
     );
 }
\ No newline at end of file
@@ -0,0 +1,298 @@
+#pragma once
+
+#ifndef STAGING_RING_H
+#define STAGING_RING_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <glad/glad.h>
+#include <iostream>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "gl_extensions.h"
+
+namespace staging_ring {
+    struct StagingStats {
+        uint64_t bytes { 0 };
+        uint64_t allocations { 0 };
+        // blocked in glClientWaitSync because the GPU still read the space we wanted
+        std::chrono::nanoseconds fence_wait { 0 };
+    };
+
+    // Space in the ring. `data` is write only; pass `offset` as the pixel pointer of a texture
+    // upload while the ring is bound to GL_PIXEL_UNPACK_BUFFER.
+    struct Allocation {
+        void* data;
+        size_t offset;
+        size_t size;
+    };
+
+    // A GL_PIXEL_UNPACK_BUFFER that uploads are staged through, so the driver copies out of it
+    // on the GPU timeline instead of out of client memory before the call returns.
+    //
+    // With ARB_buffer_storage the buffer is mapped once, persistently, and fences keep us from
+    // overwriting what the GPU has not read yet. Allocations stay reserved from allocate() until
+    // the fence() after their commit(), so any number of them can be written at once, from any
+    // thread. Without it every allocation maps its range unsynchronized and the buffer is
+    // orphaned whenever the ring wraps, which leaves tracking the old storage to the driver; an
+    // allocation then has to be committed before the next one.
+    //
+    //     auto allocation = ring.allocate(size);   // write size bytes to allocation->data
+    //     ring.commit(*allocation);               // ring is bound, upload from the offset
+    //     ring.fence();                           // once the uploads are issued
+    class StagingRing {
+        struct Range {
+            size_t begin;
+            size_t end;
+            bool committed;
+        };
+
+        struct Fence {
+            GLsync sync;
+            std::vector<std::pair<size_t, size_t>> ranges;
+        };
+
+        static constexpr size_t alignment = 64;
+
+        uint32_t buffer_ { 0 };
+        size_t capacity_;
+        bool persistent_ { false };
+        // the persistent mapping, nullptr when orphaning
+        uint8_t* mapping_ { nullptr };
+        size_t head_ { 0 };
+        // allocated, but not fenced yet
+        std::vector<Range> pending_;
+        std::deque<Fence> fences_;
+
+        StagingStats frame_ {};
+        StagingStats last_frame_ {};
+        StagingStats total_ {};
+
+        auto wait_for(size_t begin, size_t end) -> void;
+
+    public:
+        // Needs a current context with gl_extensions::load() done.
+        explicit StagingRing(size_t capacity);
+        ~StagingRing();
+
+        StagingRing(const StagingRing&) = delete;
+        auto operator=(const StagingRing&) -> StagingRing& = delete;
+
+        // nullopt when `size` does not fit the ring at all, upload from client memory then, or
+        // when the space is still reserved by uncommitted allocations, try again after
+        // committing them. Waits when the GPU still reads the space. Leaves
+        // GL_PIXEL_UNPACK_BUFFER unbound, so uploads from client memory keep reading client
+        // memory until commit() binds the ring.
+        auto allocate(size_t size) -> std::optional<Allocation>;
+        // Call once the allocation is written, before the upload reading it.
+        auto commit(const Allocation& allocation) -> void;
+        // Covers every allocation committed since the previous fence, call after the uploads
+        // using them.
+        auto fence() -> void;
+
+        // Moves the counts since the previous call into last_frame().
+        auto begin_frame() -> void;
+        auto persistent() const -> bool;
+        auto capacity() const -> size_t;
+        auto last_frame() const -> const StagingStats&;
+        auto total() const -> const StagingStats&;
+    };
+
+    inline StagingRing::StagingRing(const size_t capacity):
+        capacity_ { capacity } {
+        const auto& extensions = gl_extensions::get();
+        glGenBuffers(1, &this->buffer_);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, this->buffer_);
+        if (extensions.buffer_storage) {
+            constexpr GLbitfield flags = GL_MAP_WRITE_BIT
+                | GL_MAP_PERSISTENT_BIT
+                | GL_MAP_COHERENT_BIT;
+            extensions.glBufferStorage(
+                GL_PIXEL_UNPACK_BUFFER,
+                static_cast<GLsizeiptr>(capacity),
+                nullptr,
+                flags | GL_CLIENT_STORAGE_BIT
+            );
+            this->mapping_ = static_cast<uint8_t*>(glMapBufferRange(
+                GL_PIXEL_UNPACK_BUFFER,
+                0,
+                static_cast<GLsizeiptr>(capacity),
+                flags
+            ));
+            this->persistent_ = this->mapping_ != nullptr;
+            if (!this->persistent_) {
+                std::cout << "ERROR: could not map the staging ring persistently, orphaning"
+                    << '\n';
+                // storage is immutable, so orphaning needs a buffer of its own
+                glDeleteBuffers(1, &this->buffer_);
+                glGenBuffers(1, &this->buffer_);
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, this->buffer_);
+            }
+        }
+        if (!this->persistent_) {
+            glBufferData(
+                GL_PIXEL_UNPACK_BUFFER,
+                static_cast<GLsizeiptr>(capacity),
+                nullptr,
+                GL_STREAM_DRAW
+            );
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    inline StagingRing::~StagingRing() {
+        for (const auto& fence : this->fences_) {
+            glDeleteSync(fence.sync);
+        }
+        // deleting the buffer unmaps it
+        glDeleteBuffers(1, &this->buffer_);
+    }
+
+    inline auto StagingRing::wait_for(const size_t begin, const size_t end) -> void {
+        // fences signal in order, so waiting for the newest one in the way covers the rest
+        auto last = this->fences_.end();
+        for (auto fence = this->fences_.begin(); fence != this->fences_.end(); ++fence) {
+            for (const auto& [fenced_begin, fenced_end] : fence->ranges) {
+                if (fenced_begin < end && begin < fenced_end) {
+                    last = fence;
+                }
+            }
+        }
+        if (last == this->fences_.end()) {
+            return;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        constexpr GLuint64 timeout_ns = 1000000000;
+        while (true) {
+            const auto status =
+                glClientWaitSync(last->sync, GL_SYNC_FLUSH_COMMANDS_BIT, timeout_ns);
+            if (status != GL_TIMEOUT_EXPIRED) {
+                break;
+            }
+        }
+        this->frame_.fence_wait += std::chrono::steady_clock::now() - start;
+
+        ++last;
+        for (auto fence = this->fences_.begin(); fence != last; ++fence) {
+            glDeleteSync(fence->sync);
+        }
+        this->fences_.erase(this->fences_.begin(), last);
+    }
+
+    inline auto StagingRing::allocate(const size_t size) -> std::optional<Allocation> {
+        if (size == 0 || size > this->capacity_) {
+            return std::nullopt;
+        }
+
+        auto begin = (this->head_ + alignment - 1) / alignment * alignment;
+        const auto wraps = begin + size > this->capacity_;
+        if (wraps) {
+            begin = 0;
+        }
+        const auto end = begin + size;
+
+        if (this->persistent_) {
+            for (const auto& range : this->pending_) {
+                if (range.begin < end && begin < range.end) {
+                    return std::nullopt;
+                }
+            }
+            this->wait_for(begin, end);
+            this->pending_.push_back(Range { begin, end, false });
+        } else if (wraps) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, this->buffer_);
+            glBufferData(
+                GL_PIXEL_UNPACK_BUFFER,
+                static_cast<GLsizeiptr>(this->capacity_),
+                nullptr,
+                GL_STREAM_DRAW
+            );
+        }
+        this->head_ = end;
+
+        void* data = nullptr;
+        if (this->persistent_) {
+            data = this->mapping_ + begin;
+        } else {
+            // the range was never handed out since the last orphaning, nothing reads it
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, this->buffer_);
+            data = glMapBufferRange(
+                GL_PIXEL_UNPACK_BUFFER,
+                static_cast<GLintptr>(begin),
+                static_cast<GLsizeiptr>(size),
+                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT
+            );
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            if (data == nullptr) {
+                return std::nullopt;
+            }
+        }
+
+        ++this->frame_.allocations;
+        this->frame_.bytes += size;
+        return Allocation { data, begin, size };
+    }
+
+    inline auto StagingRing::commit(const Allocation& allocation) -> void {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, this->buffer_);
+        if (!this->persistent_) {
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            return;
+        }
+        for (auto& range : this->pending_) {
+            if (range.begin == allocation.offset) {
+                range.committed = true;
+            }
+        }
+    }
+
+    inline auto StagingRing::fence() -> void {
+        // orphaned storage is the driver's to track, nothing is pending then
+        Fence fence { nullptr, {} };
+        auto range = this->pending_.begin();
+        while (range != this->pending_.end()) {
+            if (range->committed) {
+                fence.ranges.emplace_back(range->begin, range->end);
+                range = this->pending_.erase(range);
+            } else {
+                ++range;
+            }
+        }
+        if (fence.ranges.empty()) {
+            return;
+        }
+        fence.sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        this->fences_.push_back(std::move(fence));
+    }
+
+    inline auto StagingRing::begin_frame() -> void {
+        this->total_.bytes += this->frame_.bytes;
+        this->total_.allocations += this->frame_.allocations;
+        this->total_.fence_wait += this->frame_.fence_wait;
+        this->last_frame_ = this->frame_;
+        this->frame_ = StagingStats {};
+    }
+
+    inline auto StagingRing::persistent() const -> bool {
+        return this->persistent_;
+    }
+
+    inline auto StagingRing::capacity() const -> size_t {
+        return this->capacity_;
+    }
+
+    inline auto StagingRing::last_frame() const -> const StagingStats& {
+        return this->last_frame_;
+    }
+
+    inline auto StagingRing::total() const -> const StagingStats& {
+        return this->total_;
+    }
+} // namespace staging_ring
+
+#endif
@@ -1,2 +1,8 @@
-﻿#define STB_IMAGE_IMPLEMENTATION
+﻿#include "decode_arena.h"
+
+#define STBI_MALLOC(size) decode_arena::allocate(size)
+#define STBI_REALLOC_SIZED(memory, old_size, new_size) \
+    decode_arena::reallocate(memory, old_size, new_size)
+#define STBI_FREE(memory) decode_arena::release(memory)
+#define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
\ No newline at end of file
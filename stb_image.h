@@ -439,6 +439,21 @@ extern "C" {
         int desired_channels
     ) -> stbi_uc*;
 
+    // Decodes into `output` instead of a buffer of its own, and returns 1 on success, 0 on
+    // failure. Size `output` from stbi_info_from_memory as x * y * channels, plus 1 byte:
+    // JPEG and 8-bit PNG then decode straight into it, every other format is decoded as usual
+    // and copied in. Fails when `output_size` cannot hold the image.
+    STBIDEF auto stbi_load_from_memory_into(
+        const stbi_uc* buffer,
+        int len,
+        int* x,
+        int* y,
+        int* channels_in_file,
+        int desired_channels,
+        stbi_uc* output,
+        size_t output_size
+    ) -> int;
+
     #ifndef STBI_NO_STDIO
     STBIDEF auto stbi_load(
         const char* filename,
@@ -626,6 +641,54 @@ STBIDEF int stbi_convert_wchar_to_utf8(char *buffer, size_t bufferlen, const wch
     STBIDEF auto stbi_convert_iphone_png_to_rgb_thread(int flag_true_if_should_convert) -> void;
     STBIDEF auto stbi_set_flip_vertically_on_load_thread(int flag_true_if_should_flip) -> void;
 
+    // the instruction sets the JPEG kernels come in, narrowest first
+    enum {
+        STBI_simd_none = 0,
+        // SSE2 or NEON
+        STBI_simd_128 = 1,
+        // AVX2
+        STBI_simd_256 = 2
+    };
+
+    // JPEG decoding uses the widest kernels the CPU runs, checked at runtime. Capping them at
+    // `limit` is for comparing them; the output is the same whichever runs. Like the _thread
+    // setters above, this and stbi_set_jpeg_parallel_for only apply to the calling thread, so
+    // other threads can keep decoding meanwhile (process-wide with STBI_NO_THREAD_LOCALS).
+    STBIDEF auto stbi_set_jpeg_simd_limit(int limit) -> void;
+    // the kernels the calling thread's next JPEG decode will use
+    STBIDEF auto stbi_jpeg_simd_level() -> int;
+
+    // Runs task(context, i) for every i in [0, count), on whatever threads it likes, and
+    // returns once all of them have.
+    using stbi_parallel_for = void (*)(
+        void* user,
+        int count,
+        void (*task)(void* context, int index),
+        void* context
+    );
+
+    // Decodes the restart intervals of baseline JPEGs in memory through `parallel_for`, handing
+    // it `user`, when the calling thread decodes one with restart markers. Without the hook, the
+    // default, and for every other JPEG, decoding stays on the calling thread. The output is the
+    // same either way.
+    STBIDEF auto stbi_set_jpeg_parallel_for(stbi_parallel_for parallel_for, void* user) -> void;
+
+    // Converts planar YCbCr to RGB, `step` 3, or RGBA, `step` 4, with the kernels a JPEG decode
+    // would use, for benchmarking them. Cb and Cr are subsampled by `hs` x `vs`, 1 or 2 each,
+    // and upsampled the way the decoder does: they are (width + hs - 1) / hs samples wide and
+    // (height + vs - 1) / vs high. `out` needs 1 byte past width * height * step.
+    STBIDEF auto stbi_jpeg_YCbCr_to_RGB(
+        stbi_uc* out,
+        const stbi_uc* y,
+        const stbi_uc* cb,
+        const stbi_uc* cr,
+        int width,
+        int height,
+        int hs,
+        int vs,
+        int step
+    ) -> void;
+
     // ZLIB client - used by PNG, available for other purposes
 
     STBIDEF auto stbi_zlib_decode_malloc_guesssize(
@@ -901,6 +964,47 @@ static int stbi__sse2_available(void)
 #endif
 #endif
 
+// AVX2 kernels, on top of SSE2. They are compiled for AVX2 one function at a time, so the rest
+// of the library still runs on any x86 CPU, and only picked when cpuid says the CPU has AVX2.
+#if defined(STBI_SSE2) && !defined(STBI_NO_AVX2) && !defined(STBI_NO_JPEG) \
+   && ((defined(_MSC_VER) && _MSC_VER >= 1700) || defined(__GNUC__) || defined(__clang__))
+#define STBI_AVX2
+#include <immintrin.h>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define STBI__AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define STBI__AVX2_TARGET
+#endif
+
+#ifdef _MSC_VER
+static int stbi__avx2_check(void)
+{
+   int info[4];
+   __cpuid(info,1);
+   // the OS has to save the ymm registers too, which XGETBV reports
+   if (((info[2] >> 27) & 1) == 0 || ((info[2] >> 28) & 1) == 0) return 0;
+   if ((_xgetbv(0) & 6) != 6) return 0;
+   __cpuidex(info,7,0);
+   return ((info[1] >> 5) & 1) != 0;
+}
+
+static int stbi__avx2_available(void)
+{
+   // every decode asks, and cpuid is slow; racing threads store the same answer
+   static int available = -1;
+   if (available < 0) available = stbi__avx2_check();
+   return available;
+}
+#else
+static int stbi__avx2_available(void)
+{
+   // checks the OS support as well as the cpuid bit
+   return __builtin_cpu_supports("avx2");
+}
+#endif
+#endif
+
 // ARM NEON
 #if defined(STBI_NO_SIMD) && defined(STBI_NEON)
 #undef STBI_NEON
@@ -944,6 +1048,12 @@ typedef struct
 
    stbi_uc *img_buffer, *img_buffer_end;
    stbi_uc *img_buffer_original, *img_buffer_original_end;
+
+   // caller-provided output, see stbi_load_from_memory_into
+   stbi_uc *out_target;
+   size_t out_target_size;
+   int out_target_req_comp;
+   int out_target_used;
 } stbi__context;
 
 
@@ -957,6 +1067,10 @@ static void stbi__start_mem(stbi__context *s, stbi_uc const *buffer, int len)
    s->callback_already_read = 0;
    s->img_buffer = s->img_buffer_original = (stbi_uc *) buffer;
    s->img_buffer_end = s->img_buffer_original_end = (stbi_uc *) buffer+len;
+   s->out_target = NULL;
+   s->out_target_size = 0;
+   s->out_target_req_comp = 0;
+   s->out_target_used = 0;
 }
 
 // initialize a callback-based context
@@ -968,6 +1082,10 @@ static void stbi__start_callbacks(stbi__context *s, stbi_io_callbacks *c, void *
    s->read_from_callbacks = 1;
    s->callback_already_read = 0;
    s->img_buffer = s->img_buffer_original = s->buffer_start;
+   s->out_target = NULL;
+   s->out_target_size = 0;
+   s->out_target_req_comp = 0;
+   s->out_target_used = 0;
    stbi__refill_buffer(s);
    s->img_buffer_original_end = s->img_buffer_end;
 }
@@ -1185,6 +1303,25 @@ static void *stbi__malloc_mad3(int a, int b, int c, int add)
    return stbi__malloc(a*b*c + add);
 }
 
+#if !defined(STBI_NO_JPEG) || !defined(STBI_NO_PNG)
+// Like stbi__malloc_mad3, but hands out the caller's buffer when there is one and it is big
+// enough. Only for the buffer that is returned as the image, with no conversion after it.
+static void *stbi__malloc_output_mad3(stbi__context *s, int a, int b, int c, int add)
+{
+   if (!stbi__mad3sizes_valid(a, b, c, add)) return NULL;
+   if (s->out_target && !s->out_target_used && (size_t) (a*b*c + add) <= s->out_target_size) {
+      s->out_target_used = 1;
+      return s->out_target;
+   }
+   return stbi__malloc(a*b*c + add);
+}
+
+static void stbi__free_output(stbi__context *s, void *p)
+{
+   if (p != s->out_target) STBI_FREE(p);
+}
+#endif
+
 #if !defined(STBI_NO_LINEAR) || !defined(STBI_NO_HDR) || !defined(STBI_NO_PNM)
 static void *stbi__malloc_mad4(int a, int b, int c, int d, int add)
 {
@@ -1567,6 +1704,32 @@ STBIDEF stbi_uc *stbi_load_from_callbacks(stbi_io_callbacks const *clbk, void *u
    return stbi__load_and_postprocess_8bit(&s,x,y,comp,req_comp);
 }
 
+STBIDEF int stbi_load_from_memory_into(stbi_uc const *buffer, int len, int *x, int *y, int *comp, int req_comp, stbi_uc *output, size_t output_size)
+{
+   stbi__context s;
+   stbi_uc *result;
+   int file_comp;
+   size_t size;
+   stbi__start_mem(&s,buffer,len);
+   s.out_target = output;
+   s.out_target_size = output_size;
+   s.out_target_req_comp = req_comp;
+   result = stbi__load_and_postprocess_8bit(&s,x,y,&file_comp,req_comp);
+   if (result == NULL) return 0;
+   if (comp) *comp = file_comp;
+   if (result == output) return 1;
+
+   // a format that decodes into a buffer of its own
+   size = (size_t) *x * (size_t) *y * (size_t) (req_comp ? req_comp : file_comp);
+   if (size > output_size) {
+      STBI_FREE(result);
+      return stbi__err("too small", "Output buffer too small");
+   }
+   memcpy(output, result, size);
+   STBI_FREE(result);
+   return 1;
+}
+
 #ifndef STBI_NO_GIF
 STBIDEF stbi_uc *stbi_load_gif_from_memory(stbi_uc const *buffer, int len, int **delays, int *x, int *y, int *z, int *comp, int req_comp)
 {
@@ -2062,6 +2225,9 @@ static stbi_uc *stbi__hdr_to_ldr(float   *data, int x, int y, int comp)
 // huffman decoding acceleration
 #define FAST_BITS   9  // larger handles more cases; smaller stomps less cache
 
+// blocks per call of the batch idct kernel, 128-bit lanes in a 256-bit register
+#define STBI__IDCT_BATCH   2
+
 typedef struct
 {
    stbi_uc  fast[1 << FAST_BITS];
@@ -2121,10 +2287,21 @@ typedef struct
    int scan_n, order[4];
    int restart_interval, todo;
 
+   // blocks waiting for the batch idct kernel, see stbi__idct_submit
+   STBI_SIMD_ALIGN(short, idct_buffer[STBI__IDCT_BATCH][64]);
+   stbi_uc *idct_out[STBI__IDCT_BATCH];
+   int idct_stride[STBI__IDCT_BATCH];
+   short *idct_data[STBI__IDCT_BATCH];
+   int idct_count;
+
 // kernels
    void (*idct_block_kernel)(stbi_uc *out, int out_stride, short data[64]);
+   // takes STBI__IDCT_BATCH blocks at a time, when there is a kernel that does
+   void (*idct_batch_kernel)(stbi_uc **out, int *out_stride, short **data);
    void (*YCbCr_to_RGB_kernel)(stbi_uc *out, const stbi_uc *y, const stbi_uc *pcb, const stbi_uc *pcr, int count, int step);
    stbi_uc *(*resample_row_hv_2_kernel)(stbi_uc *out, stbi_uc *in_near, stbi_uc *in_far, int w, int hs);
+   // upsamples cb and cr and converts them with y in one pass, when there is a kernel that does
+   void (*resample_YCbCr_to_RGB_kernel)(stbi_uc *out, stbi_uc const *y, stbi_uc const *cb_near, stbi_uc const *cb_far, stbi_uc const *cr_near, stbi_uc const *cr_far, int w, int hs, int vs, int count, int step);
 } stbi__jpeg;
 
 static int stbi__build_huffman(stbi__huffman *h, int *count)
@@ -2831,6 +3008,201 @@ static void stbi__idct_simd(stbi_uc *out, int out_stride, short data[64])
 
 #endif // STBI_SSE2
 
+#ifdef STBI_AVX2
+// avx2 integer IDCT of two blocks at once, one in each 128-bit lane. every instruction it
+// uses works lane by lane, so each lane runs exactly the sse2 IDCT above and the output is
+// bit-identical to it, and so to the generic C version.
+static STBI__AVX2_TARGET void stbi__idct_avx2(stbi_uc **out, int *out_stride, short **data)
+{
+   __m256i row0, row1, row2, row3, row4, row5, row6, row7;
+   __m256i tmp;
+
+   // dot product constant: even elems=x, odd elems=y
+   #define dct_const(x,y)  _mm256_broadcastsi128_si256(_mm_setr_epi16((x),(y),(x),(y),(x),(y),(x),(y)))
+
+   // out(0) = c0[even]*x + c0[odd]*y   (c0, x, y 16-bit, out 32-bit)
+   // out(1) = c1[even]*x + c1[odd]*y
+   #define dct_rot(out0,out1, x,y,c0,c1) \
+      __m256i c0##lo = _mm256_unpacklo_epi16((x),(y)); \
+      __m256i c0##hi = _mm256_unpackhi_epi16((x),(y)); \
+      __m256i out0##_l = _mm256_madd_epi16(c0##lo, c0); \
+      __m256i out0##_h = _mm256_madd_epi16(c0##hi, c0); \
+      __m256i out1##_l = _mm256_madd_epi16(c0##lo, c1); \
+      __m256i out1##_h = _mm256_madd_epi16(c0##hi, c1)
+
+   // out = in << 12  (in 16-bit, out 32-bit)
+   #define dct_widen(out, in) \
+      __m256i out##_l = _mm256_srai_epi32(_mm256_unpacklo_epi16(_mm256_setzero_si256(), (in)), 4); \
+      __m256i out##_h = _mm256_srai_epi32(_mm256_unpackhi_epi16(_mm256_setzero_si256(), (in)), 4)
+
+   // wide add
+   #define dct_wadd(out, a, b) \
+      __m256i out##_l = _mm256_add_epi32(a##_l, b##_l); \
+      __m256i out##_h = _mm256_add_epi32(a##_h, b##_h)
+
+   // wide sub
+   #define dct_wsub(out, a, b) \
+      __m256i out##_l = _mm256_sub_epi32(a##_l, b##_l); \
+      __m256i out##_h = _mm256_sub_epi32(a##_h, b##_h)
+
+   // butterfly a/b, add bias, then shift by "s" and pack
+   #define dct_bfly32o(out0, out1, a,b,bias,s) \
+      { \
+         __m256i abiased_l = _mm256_add_epi32(a##_l, bias); \
+         __m256i abiased_h = _mm256_add_epi32(a##_h, bias); \
+         dct_wadd(sum, abiased, b); \
+         dct_wsub(dif, abiased, b); \
+         out0 = _mm256_packs_epi32(_mm256_srai_epi32(sum_l, s), _mm256_srai_epi32(sum_h, s)); \
+         out1 = _mm256_packs_epi32(_mm256_srai_epi32(dif_l, s), _mm256_srai_epi32(dif_h, s)); \
+      }
+
+   // 8-bit interleave step (for transposes)
+   #define dct_interleave8(a, b) \
+      tmp = a; \
+      a = _mm256_unpacklo_epi8(a, b); \
+      b = _mm256_unpackhi_epi8(tmp, b)
+
+   // 16-bit interleave step (for transposes)
+   #define dct_interleave16(a, b) \
+      tmp = a; \
+      a = _mm256_unpacklo_epi16(a, b); \
+      b = _mm256_unpackhi_epi16(tmp, b)
+
+   #define dct_pass(bias,shift) \
+      { \
+         /* even part */ \
+         dct_rot(t2e,t3e, row2,row6, rot0_0,rot0_1); \
+         __m256i sum04 = _mm256_add_epi16(row0, row4); \
+         __m256i dif04 = _mm256_sub_epi16(row0, row4); \
+         dct_widen(t0e, sum04); \
+         dct_widen(t1e, dif04); \
+         dct_wadd(x0, t0e, t3e); \
+         dct_wsub(x3, t0e, t3e); \
+         dct_wadd(x1, t1e, t2e); \
+         dct_wsub(x2, t1e, t2e); \
+         /* odd part */ \
+         dct_rot(y0o,y2o, row7,row3, rot2_0,rot2_1); \
+         dct_rot(y1o,y3o, row5,row1, rot3_0,rot3_1); \
+         __m256i sum17 = _mm256_add_epi16(row1, row7); \
+         __m256i sum35 = _mm256_add_epi16(row3, row5); \
+         dct_rot(y4o,y5o, sum17,sum35, rot1_0,rot1_1); \
+         dct_wadd(x4, y0o, y4o); \
+         dct_wadd(x5, y1o, y5o); \
+         dct_wadd(x6, y2o, y5o); \
+         dct_wadd(x7, y3o, y4o); \
+         dct_bfly32o(row0,row7, x0,x7,bias,shift); \
+         dct_bfly32o(row1,row6, x1,x6,bias,shift); \
+         dct_bfly32o(row2,row5, x2,x5,bias,shift); \
+         dct_bfly32o(row3,row4, x3,x4,bias,shift); \
+      }
+
+   // row r of the first block in the low lane, of the second in the high one
+   #define dct_load(r) \
+      _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_load_si128((const __m128i *) (data[0] + (r)*8))), \
+                              _mm_load_si128((const __m128i *) (data[1] + (r)*8)), 1)
+
+   __m256i rot0_0 = dct_const(stbi__f2f(0.5411961f), stbi__f2f(0.5411961f) + stbi__f2f(-1.847759065f));
+   __m256i rot0_1 = dct_const(stbi__f2f(0.5411961f) + stbi__f2f( 0.765366865f), stbi__f2f(0.5411961f));
+   __m256i rot1_0 = dct_const(stbi__f2f(1.175875602f) + stbi__f2f(-0.899976223f), stbi__f2f(1.175875602f));
+   __m256i rot1_1 = dct_const(stbi__f2f(1.175875602f), stbi__f2f(1.175875602f) + stbi__f2f(-2.562915447f));
+   __m256i rot2_0 = dct_const(stbi__f2f(-1.961570560f) + stbi__f2f( 0.298631336f), stbi__f2f(-1.961570560f));
+   __m256i rot2_1 = dct_const(stbi__f2f(-1.961570560f), stbi__f2f(-1.961570560f) + stbi__f2f( 3.072711026f));
+   __m256i rot3_0 = dct_const(stbi__f2f(-0.390180644f) + stbi__f2f( 2.053119869f), stbi__f2f(-0.390180644f));
+   __m256i rot3_1 = dct_const(stbi__f2f(-0.390180644f), stbi__f2f(-0.390180644f) + stbi__f2f( 1.501321110f));
+
+   // rounding biases in column/row passes, see stbi__idct_block for explanation.
+   __m256i bias_0 = _mm256_set1_epi32(512);
+   __m256i bias_1 = _mm256_set1_epi32(65536 + (128<<17));
+   int i;
+
+   // load
+   row0 = dct_load(0);
+   row1 = dct_load(1);
+   row2 = dct_load(2);
+   row3 = dct_load(3);
+   row4 = dct_load(4);
+   row5 = dct_load(5);
+   row6 = dct_load(6);
+   row7 = dct_load(7);
+
+   // column pass
+   dct_pass(bias_0, 10);
+
+   {
+      // 16bit 8x8 transpose pass 1
+      dct_interleave16(row0, row4);
+      dct_interleave16(row1, row5);
+      dct_interleave16(row2, row6);
+      dct_interleave16(row3, row7);
+
+      // transpose pass 2
+      dct_interleave16(row0, row2);
+      dct_interleave16(row1, row3);
+      dct_interleave16(row4, row6);
+      dct_interleave16(row5, row7);
+
+      // transpose pass 3
+      dct_interleave16(row0, row1);
+      dct_interleave16(row2, row3);
+      dct_interleave16(row4, row5);
+      dct_interleave16(row6, row7);
+   }
+
+   // row pass
+   dct_pass(bias_1, 17);
+
+   {
+      // pack
+      __m256i p0 = _mm256_packus_epi16(row0, row1); // a0a1a2a3...a7b0b1b2b3...b7
+      __m256i p1 = _mm256_packus_epi16(row2, row3);
+      __m256i p2 = _mm256_packus_epi16(row4, row5);
+      __m256i p3 = _mm256_packus_epi16(row6, row7);
+
+      // 8bit 8x8 transpose pass 1
+      dct_interleave8(p0, p2); // a0e0a1e1...
+      dct_interleave8(p1, p3); // c0g0c1g1...
+
+      // transpose pass 2
+      dct_interleave8(p0, p1); // a0c0e0g0...
+      dct_interleave8(p2, p3); // b0d0f0h0...
+
+      // transpose pass 3
+      dct_interleave8(p0, p2); // a0b0c0d0...
+      dct_interleave8(p1, p3); // a4b4c4d4...
+
+      // store each lane into its own block
+      for (i=0; i < STBI__IDCT_BATCH; ++i) {
+         stbi_uc *o = out[i];
+         int stride = out_stride[i];
+         __m128i q0 = i ? _mm256_extracti128_si256(p0, 1) : _mm256_castsi256_si128(p0);
+         __m128i q1 = i ? _mm256_extracti128_si256(p1, 1) : _mm256_castsi256_si128(p1);
+         __m128i q2 = i ? _mm256_extracti128_si256(p2, 1) : _mm256_castsi256_si128(p2);
+         __m128i q3 = i ? _mm256_extracti128_si256(p3, 1) : _mm256_castsi256_si128(p3);
+         _mm_storel_epi64((__m128i *) o, q0); o += stride;
+         _mm_storel_epi64((__m128i *) o, _mm_shuffle_epi32(q0, 0x4e)); o += stride;
+         _mm_storel_epi64((__m128i *) o, q2); o += stride;
+         _mm_storel_epi64((__m128i *) o, _mm_shuffle_epi32(q2, 0x4e)); o += stride;
+         _mm_storel_epi64((__m128i *) o, q1); o += stride;
+         _mm_storel_epi64((__m128i *) o, _mm_shuffle_epi32(q1, 0x4e)); o += stride;
+         _mm_storel_epi64((__m128i *) o, q3); o += stride;
+         _mm_storel_epi64((__m128i *) o, _mm_shuffle_epi32(q3, 0x4e));
+      }
+   }
+
+#undef dct_const
+#undef dct_rot
+#undef dct_widen
+#undef dct_wadd
+#undef dct_wsub
+#undef dct_bfly32o
+#undef dct_interleave8
+#undef dct_interleave16
+#undef dct_pass
+#undef dct_load
+}
+
+#endif // STBI_AVX2
+
 #ifdef STBI_NEON
 
 // NEON integer IDCT. should produce bit-identical
@@ -3073,67 +3445,209 @@ static void stbi__jpeg_reset(stbi__jpeg *j)
    // since we don't even allow 1<<30 pixels
 }
 
-static int stbi__parse_entropy_coded_data(stbi__jpeg *z)
+// where the next block for stbi__idct_submit decodes into
+static short *stbi__idct_slot(stbi__jpeg *z)
 {
-   stbi__jpeg_reset(z);
-   if (!z->progressive) {
-      if (z->scan_n == 1) {
-         int i,j;
-         STBI_SIMD_ALIGN(short, data[64]);
-         int n = z->order[0];
-         // non-interleaved data, we just need to process one block at a time,
-         // in trivial scanline order
-         // number of blocks to do just depends on how many actual "pixels" this
-         // component has, independent of interleaved MCU blocking and such
-         int w = (z->img_comp[n].x+7) >> 3;
-         int h = (z->img_comp[n].y+7) >> 3;
-         for (j=0; j < h; ++j) {
-            for (i=0; i < w; ++i) {
+   return z->idct_buffer[z->idct_count];
+}
+
+// transforms the block at 'data' into 'out', now or once the batch kernel has a full batch;
+// stbi__idct_flush does the blocks left over at the end
+static void stbi__idct_submit(stbi__jpeg *z, stbi_uc *out, int out_stride, short *data)
+{
+   if (!z->idct_batch_kernel) {
+      z->idct_block_kernel(out, out_stride, data);
+      return;
+   }
+   z->idct_out[z->idct_count] = out;
+   z->idct_stride[z->idct_count] = out_stride;
+   z->idct_data[z->idct_count] = data;
+   if (++z->idct_count == STBI__IDCT_BATCH) {
+      z->idct_batch_kernel(z->idct_out, z->idct_stride, z->idct_data);
+      z->idct_count = 0;
+   }
+}
+
+static void stbi__idct_flush(stbi__jpeg *z)
+{
+   int i;
+   for (i=0; i < z->idct_count; ++i)
+      z->idct_block_kernel(z->idct_out[i], z->idct_stride[i], z->idct_data[i]);
+   z->idct_count = 0;
+}
+
+// the number of MCUs in a scan; a non-interleaved scan codes one block per MCU
+static int stbi__scan_mcus(stbi__jpeg *z)
+{
+   if (z->scan_n == 1) {
+      int n = z->order[0];
+      return ((z->img_comp[n].x+7) >> 3) * ((z->img_comp[n].y+7) >> 3);
+   }
+   return z->img_mcu_x * z->img_mcu_y;
+}
+
+// decodes MCU 'm' of a baseline scan, counting in scanline order
+static int stbi__decode_baseline_mcu(stbi__jpeg *z, int m)
+{
+   if (z->scan_n == 1) {
+      // non-interleaved data, we just need to process one block at a time,
+      // in trivial scanline order
+      // number of blocks to do just depends on how many actual "pixels" this
+      // component has, independent of interleaved MCU blocking and such
+      int n = z->order[0];
+      int w = (z->img_comp[n].x+7) >> 3;
+      int i = m % w, j = m / w;
+      int ha = z->img_comp[n].ha;
+      short *data = stbi__idct_slot(z);
+      if (!stbi__jpeg_decode_block(z, data, z->huff_dc+z->img_comp[n].hd, z->huff_ac+ha, z->fast_ac[ha], n, z->dequant[z->img_comp[n].tq])) return 0;
+      stbi__idct_submit(z, z->img_comp[n].data+z->img_comp[n].w2*j*8+i*8, z->img_comp[n].w2, data);
+   } else { // interleaved
+      int i = m % z->img_mcu_x, j = m / z->img_mcu_x;
+      int k,x,y;
+      // scan an interleaved mcu... process scan_n components in order
+      for (k=0; k < z->scan_n; ++k) {
+         int n = z->order[k];
+         // scan out an mcu's worth of this component; that's just determined
+         // by the basic H and V specified for the component
+         for (y=0; y < z->img_comp[n].v; ++y) {
+            for (x=0; x < z->img_comp[n].h; ++x) {
+               int x2 = (i*z->img_comp[n].h + x)*8;
+               int y2 = (j*z->img_comp[n].v + y)*8;
                int ha = z->img_comp[n].ha;
+               short *data = stbi__idct_slot(z);
                if (!stbi__jpeg_decode_block(z, data, z->huff_dc+z->img_comp[n].hd, z->huff_ac+ha, z->fast_ac[ha], n, z->dequant[z->img_comp[n].tq])) return 0;
-               z->idct_block_kernel(z->img_comp[n].data+z->img_comp[n].w2*j*8+i*8, z->img_comp[n].w2, data);
-               // every data block is an MCU, so countdown the restart interval
-               if (--z->todo <= 0) {
-                  if (z->code_bits < 24) stbi__grow_buffer_unsafe(z);
-                  // if it's NOT a restart, then just bail, so we get corrupt data
-                  // rather than no data
-                  if (!STBI__RESTART(z->marker)) return 1;
-                  stbi__jpeg_reset(z);
-               }
+               stbi__idct_submit(z, z->img_comp[n].data+z->img_comp[n].w2*y2+x2, z->img_comp[n].w2, data);
             }
          }
-         return 1;
-      } else { // interleaved
-         int i,j,k,x,y;
-         STBI_SIMD_ALIGN(short, data[64]);
-         for (j=0; j < z->img_mcu_y; ++j) {
-            for (i=0; i < z->img_mcu_x; ++i) {
-               // scan an interleaved mcu... process scan_n components in order
-               for (k=0; k < z->scan_n; ++k) {
-                  int n = z->order[k];
-                  // scan out an mcu's worth of this component; that's just determined
-                  // by the basic H and V specified for the component
-                  for (y=0; y < z->img_comp[n].v; ++y) {
-                     for (x=0; x < z->img_comp[n].h; ++x) {
-                        int x2 = (i*z->img_comp[n].h + x)*8;
-                        int y2 = (j*z->img_comp[n].v + y)*8;
-                        int ha = z->img_comp[n].ha;
-                        if (!stbi__jpeg_decode_block(z, data, z->huff_dc+z->img_comp[n].hd, z->huff_ac+ha, z->fast_ac[ha], n, z->dequant[z->img_comp[n].tq])) return 0;
-                        z->idct_block_kernel(z->img_comp[n].data+z->img_comp[n].w2*y2+x2, z->img_comp[n].w2, data);
-                     }
-                  }
-               }
-               // after all interleaved components, that's an interleaved MCU,
-               // so now count down the restart interval
-               if (--z->todo <= 0) {
-                  if (z->code_bits < 24) stbi__grow_buffer_unsafe(z);
-                  if (!STBI__RESTART(z->marker)) return 1;
-                  stbi__jpeg_reset(z);
-               }
-            }
+      }
+   }
+   return 1;
+}
+
+static
+#ifdef STBI_THREAD_LOCAL
+STBI_THREAD_LOCAL
+#endif
+stbi_parallel_for stbi__jpeg_parallel_for = NULL;
+
+static
+#ifdef STBI_THREAD_LOCAL
+STBI_THREAD_LOCAL
+#endif
+void *stbi__jpeg_parallel_for_user = NULL;
+
+STBIDEF void stbi_set_jpeg_parallel_for(stbi_parallel_for parallel_for, void *user)
+{
+   stbi__jpeg_parallel_for = parallel_for;
+   stbi__jpeg_parallel_for_user = user;
+}
+
+typedef struct
+{
+   stbi__jpeg *z;
+   int mcus;
+   // restart interval i is coded from starts[i] up to starts[i+1], the marker after it included
+   stbi_uc **starts;
+   int *decoded;
+} stbi__restart_intervals;
+
+// decodes one restart interval on a copy of the decoder, reading only its own bytes. every
+// MCU writes its own blocks of the component buffers, so intervals can run side by side.
+// an interval is only marked decoded when decoding sequentially would have gone on past it.
+static void stbi__decode_restart_interval(void *context, int index)
+{
+   stbi__restart_intervals *intervals = (stbi__restart_intervals *) context;
+   stbi__jpeg z = *intervals->z;
+   stbi__context s = *intervals->z->s;
+   int m = index * z.restart_interval;
+   int last = m + z.restart_interval < intervals->mcus ? m + z.restart_interval : intervals->mcus;
+   s.img_buffer = intervals->starts[index];
+   s.img_buffer_end = intervals->starts[index+1];
+   z.s = &s;
+   z.idct_count = 0;
+   stbi__jpeg_reset(&z);
+   intervals->decoded[index] = 0;
+   for (; m < last; ++m)
+      if (!stbi__decode_baseline_mcu(&z, m)) return;
+   stbi__idct_flush(&z);
+   if (last < intervals->mcus) {
+      // the same check as the sequential loop, which stops at a missing restart marker
+      if (z.code_bits < 24) stbi__grow_buffer_unsafe(&z);
+      if (!STBI__RESTART(z.marker)) return;
+   }
+   intervals->decoded[index] = 1;
+}
+
+// decodes the restart intervals of a baseline scan in memory through the parallel_for hook.
+// returns -1, having read nothing, when the markers don't split the scan into the intervals
+// it should have or an interval fails, which the caller decodes sequentially then. that
+// reports errors and keeps partial images exactly as it always has.
+static int stbi__parse_restart_intervals(stbi__jpeg *z, int mcus)
+{
+   stbi__restart_intervals intervals;
+   int count = (mcus + z->restart_interval-1) / z->restart_interval;
+   int found = 0, i, result = -1;
+   stbi_uc *p = z->s->img_buffer, *end = z->s->img_buffer_end;
+
+   if (count < 2) return -1;
+   intervals.z = z;
+   intervals.mcus = mcus;
+   intervals.starts = (stbi_uc **) stbi__malloc_mad2(count+1, sizeof(stbi_uc *), 0);
+   intervals.decoded = (int *) stbi__malloc_mad2(count, sizeof(int), 0);
+   if (intervals.starts && intervals.decoded) {
+      // find the RST marker after each interval and the marker that ends the scan
+      intervals.starts[found++] = p;
+      while (p+1 < end) {
+         p = (stbi_uc *) memchr(p, 0xff, end-p);
+         if (p == NULL || p+1 >= end) break;
+         if (p[1] == 0x00 || p[1] == 0xff) { // stuffed zero, or fill before a marker
+            ++p;
+         } else if (STBI__RESTART(p[1]) && found < count) {
+            p += 2;
+            intervals.starts[found++] = p;
+         } else {
+            break;
          }
-         return 1;
       }
+      if (found == count && p != NULL && p+1 < end && !STBI__RESTART(p[1])) {
+         intervals.starts[count] = p+2;
+         stbi__jpeg_parallel_for(stbi__jpeg_parallel_for_user, count, stbi__decode_restart_interval, &intervals);
+         result = 1;
+         for (i=0; i < count; ++i)
+            if (!intervals.decoded[i]) result = -1;
+         if (result > 0) {
+            // leave the marker after the scan read, as decoding sequentially does
+            z->marker = p[1];
+            z->s->img_buffer = p+2;
+         }
+      }
+   }
+   STBI_FREE(intervals.decoded);
+   STBI_FREE(intervals.starts);
+   return result;
+}
+
+static int stbi__parse_entropy_coded_data(stbi__jpeg *z)
+{
+   stbi__jpeg_reset(z);
+   if (!z->progressive) {
+      int m, mcus = stbi__scan_mcus(z);
+      if (stbi__jpeg_parallel_for && z->restart_interval && !z->s->read_from_callbacks) {
+         int result = stbi__parse_restart_intervals(z, mcus);
+         if (result >= 0) return result;
+      }
+      for (m=0; m < mcus; ++m) {
+         if (!stbi__decode_baseline_mcu(z, m)) return 0;
+         // count down the restart interval after each MCU
+         if (--z->todo <= 0) {
+            if (z->code_bits < 24) stbi__grow_buffer_unsafe(z);
+            // if it's NOT a restart, then just bail, so we get corrupt data
+            // rather than no data
+            if (!STBI__RESTART(z->marker)) return 1;
+            stbi__jpeg_reset(z);
+         }
+      }
+      return 1;
    } else {
       if (z->scan_n == 1) {
          int i,j;
@@ -3216,10 +3730,11 @@ static void stbi__jpeg_finish(stbi__jpeg *z)
             for (i=0; i < w; ++i) {
                short *data = z->img_comp[n].coeff + 64 * (i + j * z->img_comp[n].coeff_w);
                stbi__jpeg_dequantize(data, z->dequant[z->img_comp[n].tq]);
-               z->idct_block_kernel(z->img_comp[n].data+z->img_comp[n].w2*j*8+i*8, z->img_comp[n].w2, data);
+               stbi__idct_submit(z, z->img_comp[n].data+z->img_comp[n].w2*j*8+i*8, z->img_comp[n].w2, data);
             }
          }
       }
+      stbi__idct_flush(z);
    }
 }
 
@@ -3550,6 +4065,7 @@ static int stbi__decode_jpeg_image(stbi__jpeg *j)
       if (stbi__SOS(m)) {
          if (!stbi__process_scan_header(j)) return 0;
          if (!stbi__parse_entropy_coded_data(j)) return 0;
+         stbi__idct_flush(j);
          if (j->marker == STBI__MARKER_none ) {
          j->marker = stbi__skip_jpeg_junk_at_end(j);
             // if we reach eof without hitting a marker, stbi__get_marker() below will fail and we'll eventually return 0
@@ -3944,25 +4460,248 @@ static void stbi__YCbCr_to_RGB_simd(stbi_uc *out, stbi_uc const *y, stbi_uc cons
 }
 #endif
 
+#ifdef STBI_AVX2
+// converts 16 pixels whose y, cb and cr are 16-bit lanes in 0..255, pixels 0-7 in the low
+// 128-bit lane and 8-15 in the high one. the same fixed point math as stbi__YCbCr_to_RGB_simd,
+// so it's bit-identical to it and to the generic C version. step 3 stores 4 bytes past the
+// last pixel, which the caller has to leave room for.
+static stbi_inline STBI__AVX2_TARGET void stbi__YCbCr_to_RGB_avx2_16(stbi_uc *out, __m256i yw16, __m256i cbw16, __m256i crw16, int step)
+{
+   __m256i cr_const0 = _mm256_set1_epi16(   (short) ( 1.40200f*4096.0f+0.5f));
+   __m256i cr_const1 = _mm256_set1_epi16( - (short) ( 0.71414f*4096.0f+0.5f));
+   __m256i cb_const0 = _mm256_set1_epi16( - (short) ( 0.34414f*4096.0f+0.5f));
+   __m256i cb_const1 = _mm256_set1_epi16(   (short) ( 1.77200f*4096.0f+0.5f));
+   __m256i bias = _mm256_set1_epi16(128);
+   __m256i xw = _mm256_set1_epi16(255); // alpha channel
+
+   // the layout stbi__YCbCr_to_RGB_simd unpacks to: y in the high byte over a rounding
+   // bias, cr and cb less 128 in the high byte
+   __m256i yw  = _mm256_or_si256(_mm256_slli_epi16(yw16, 8), bias);
+   __m256i crw = _mm256_slli_epi16(_mm256_sub_epi16(crw16, bias), 8);
+   __m256i cbw = _mm256_slli_epi16(_mm256_sub_epi16(cbw16, bias), 8);
+
+   // color transform
+   __m256i yws = _mm256_srli_epi16(yw, 4);
+   __m256i cr0 = _mm256_mulhi_epi16(cr_const0, crw);
+   __m256i cb0 = _mm256_mulhi_epi16(cb_const0, cbw);
+   __m256i cb1 = _mm256_mulhi_epi16(cbw, cb_const1);
+   __m256i cr1 = _mm256_mulhi_epi16(crw, cr_const1);
+   __m256i rws = _mm256_add_epi16(cr0, yws);
+   __m256i gwt = _mm256_add_epi16(cb0, yws);
+   __m256i bws = _mm256_add_epi16(yws, cb1);
+   __m256i gws = _mm256_add_epi16(gwt, cr1);
+
+   // descale
+   __m256i rw = _mm256_srai_epi16(rws, 4);
+   __m256i bw = _mm256_srai_epi16(bws, 4);
+   __m256i gw = _mm256_srai_epi16(gws, 4);
+
+   // back to byte, set up for transpose
+   __m256i brb = _mm256_packus_epi16(rw, bw);
+   __m256i gxb = _mm256_packus_epi16(gw, xw);
+
+   // transpose to interleave channels: o0 holds pixels 0-3 and 8-11, o1 4-7 and 12-15
+   __m256i t0 = _mm256_unpacklo_epi8(brb, gxb);
+   __m256i t1 = _mm256_unpackhi_epi8(brb, gxb);
+   __m256i o0 = _mm256_unpacklo_epi16(t0, t1);
+   __m256i o1 = _mm256_unpackhi_epi16(t0, t1);
+
+   if (step == 4) {
+      _mm256_storeu_si256((__m256i *) (out + 0), _mm256_permute2x128_si256(o0, o1, 0x20));
+      _mm256_storeu_si256((__m256i *) (out + 32), _mm256_permute2x128_si256(o0, o1, 0x31));
+   } else {
+      // drop the alphas, leaving 4 pixels in the low 12 bytes of each 128-bit lane, and let
+      // each store overwrite the garbage the one before left after them
+      __m256i rgb = _mm256_setr_epi8(0,1,2,4,5,6,8,9,10,12,13,14,-1,-1,-1,-1,
+                                     0,1,2,4,5,6,8,9,10,12,13,14,-1,-1,-1,-1);
+      __m256i p0 = _mm256_shuffle_epi8(o0, rgb);
+      __m256i p1 = _mm256_shuffle_epi8(o1, rgb);
+      _mm_storeu_si128((__m128i *) (out + 0), _mm256_castsi256_si128(p0));
+      _mm_storeu_si128((__m128i *) (out + 12), _mm256_castsi256_si128(p1));
+      _mm_storeu_si128((__m128i *) (out + 24), _mm256_extracti128_si256(p0, 1));
+      _mm_storeu_si128((__m128i *) (out + 36), _mm256_extracti128_si256(p1, 1));
+   }
+}
+
+// pixels the 16 pixel loops below stop short of, so the step 3 stores stay in the row
+#define stbi__avx2_slack(step)  ((step) == 3 ? 2 : 0)
+
+static STBI__AVX2_TARGET void stbi__YCbCr_to_RGB_avx2(stbi_uc *out, stbi_uc const *y, stbi_uc const *pcb, stbi_uc const *pcr, int count, int step)
+{
+   int i = 0;
+   if (step == 3 || step == 4) {
+      for (; i+16+stbi__avx2_slack(step) <= count; i += 16) {
+         __m256i yw  = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (y+i)));
+         __m256i cbw = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (pcb+i)));
+         __m256i crw = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (pcr+i)));
+         stbi__YCbCr_to_RGB_avx2_16(out, yw, cbw, crw, step);
+         out += 16*step;
+      }
+   }
+   stbi__YCbCr_to_RGB_row(out, y+i, pcb+i, pcr+i, count-i, step);
+}
+
+// one chroma sample of the row stbi__resample_row_h_2, _v_2 or _hv_2 would make, at x.
+// clamping the neighbour to the row gives the same values they use at the edges, except for
+// the one before last of stbi__resample_row_h_2, which weights the samples the other way.
+static stbi_uc stbi__resample_at(stbi_uc const *in_near, stbi_uc const *in_far, int w, int hs, int vs, int x)
+{
+   int i = x / hs;
+   int j = (x & 1) ? (i+1 < w ? i+1 : i) : (i > 0 ? i-1 : 0);
+   if (hs == 1) return stbi__div4(3*in_near[i] + in_far[i] + 2);
+   if (vs == 1 && w > 1 && x == 2*(w-1)) return stbi__div4(3*in_near[w-2] + in_near[w-1] + 2);
+   if (vs == 1) return stbi__div4(3*in_near[i] + in_near[j] + 2);
+   return stbi__div16(3*(3*in_near[i] + in_far[i]) + 3*in_near[j] + in_far[j] + 8);
+}
+
+// stbi__resample_YCbCr_to_RGB_avx2 for pixels 'from' to 'to' of the row, upsampling one
+// pixel at a time into a buffer
+static STBI__AVX2_TARGET void stbi__resample_YCbCr_to_RGB_span(stbi_uc *out, stbi_uc const *y, stbi_uc const *cb_near, stbi_uc const *cb_far, stbi_uc const *cr_near, stbi_uc const *cr_far, int w, int hs, int vs, int from, int to, int step)
+{
+   while (from < to) {
+      stbi_uc cb[64], cr[64];
+      int k, n = to-from < 64 ? to-from : 64;
+      for (k=0; k < n; ++k) {
+         cb[k] = stbi__resample_at(cb_near, cb_far, w, hs, vs, from+k);
+         cr[k] = stbi__resample_at(cr_near, cr_far, w, hs, vs, from+k);
+      }
+      stbi__YCbCr_to_RGB_avx2(out + from*step, y+from, cb, cr, n, step);
+      from += n;
+   }
+}
+
+// upsamples a row of cb and cr by hs x vs (h1v2, h2v1 or h2v2), w samples to count pixels,
+// and converts it with the row of y, keeping the upsampled chroma in registers rather than
+// writing it out for the color conversion to read back. bit-identical to upsampling with
+// the row kernels and then converting.
+static STBI__AVX2_TARGET void stbi__resample_YCbCr_to_RGB_avx2(stbi_uc *out, stbi_uc const *y, stbi_uc const *cb_near, stbi_uc const *cb_far, stbi_uc const *cr_near, stbi_uc const *cr_far, int w, int hs, int vs, int count, int step)
+{
+   int i = 0, k;
+   stbi_uc const *in_near[2] = { cb_near, cr_near };
+   stbi_uc const *in_far[2] = { cb_far, cr_far };
+   __m256i chroma[2];
+
+   if (step != 3 && step != 4) {
+      stbi__resample_YCbCr_to_RGB_span(out, y, cb_near, cb_far, cr_near, cr_far, w, hs, vs, 0, count, step);
+      return;
+   }
+
+   if (hs == 1) {
+      // vertical only: 3*near + far, 16 samples to 16 pixels
+      __m256i bias = _mm256_set1_epi16(2);
+      for (; i+16+stbi__avx2_slack(step) <= count; i += 16) {
+         __m256i yw = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (y+i)));
+         for (k=0; k < 2; ++k) {
+            __m256i nearw = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (in_near[k]+i)));
+            __m256i farw  = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (in_far[k]+i)));
+            __m256i sum   = _mm256_add_epi16(_mm256_add_epi16(nearw, nearw), _mm256_add_epi16(nearw, farw));
+            chroma[k] = _mm256_srli_epi16(_mm256_add_epi16(sum, bias), 2);
+         }
+         stbi__YCbCr_to_RGB_avx2_16(out + i*step, yw, chroma[0], chroma[1], step);
+      }
+   } else {
+      // horizontal, after the vertical pass when vs == 2: 16 samples to 32 pixels with the
+      // polyphase filter of stbi__resample_row_hv_2_simd, the neighbours either side loaded
+      // one sample off. the first 16 pixels, whose left neighbour is clamped, and the last
+      // sample, which stbi__resample_row_h_2 weights its own way, go through the span.
+      __m256i bias = _mm256_set1_epi16(vs == 2 ? 8 : 2);
+      __m128i shift = _mm_cvtsi32_si128(vs == 2 ? 4 : 2);
+      i = count < 16 ? count : 16;
+      stbi__resample_YCbCr_to_RGB_span(out, y, cb_near, cb_far, cr_near, cr_far, w, hs, vs, 0, i, step);
+      for (; i+32+stbi__avx2_slack(step) <= count && i/2+17 <= w; i += 32) {
+         int c = i/2;
+         __m256i yw0 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (y+i)));
+         __m256i yw1 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (y+i+16)));
+         __m256i lo[2], hi[2];
+         for (k=0; k < 2; ++k) {
+            #define stbi__avx2_samples(o) _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (in_near[k]+c+(o))))
+            __m256i prev = stbi__avx2_samples(-1);
+            __m256i curr = stbi__avx2_samples(0);
+            __m256i next = stbi__avx2_samples(1);
+            #undef stbi__avx2_samples
+            __m256i curs, even, odd;
+            if (vs == 2) {
+               // 3*near + far
+               #define stbi__avx2_far(o) _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (in_far[k]+c+(o))))
+               prev = _mm256_add_epi16(_mm256_add_epi16(prev, prev), _mm256_add_epi16(prev, stbi__avx2_far(-1)));
+               curr = _mm256_add_epi16(_mm256_add_epi16(curr, curr), _mm256_add_epi16(curr, stbi__avx2_far(0)));
+               next = _mm256_add_epi16(_mm256_add_epi16(next, next), _mm256_add_epi16(next, stbi__avx2_far(1)));
+               #undef stbi__avx2_far
+            }
+
+            // even pixels = 3*cur + prev, odd pixels = 3*cur + next, interleaved; each lane
+            // holds 8 samples, so 16 pixels
+            curs = _mm256_add_epi16(_mm256_add_epi16(curr, curr), _mm256_add_epi16(curr, bias));
+            even = _mm256_srl_epi16(_mm256_add_epi16(curs, prev), shift);
+            odd  = _mm256_srl_epi16(_mm256_add_epi16(curs, next), shift);
+            lo[k] = _mm256_unpacklo_epi16(even, odd);
+            hi[k] = _mm256_unpackhi_epi16(even, odd);
+         }
+         // pixels 0-7 | 16-23 in lo, 8-15 | 24-31 in hi
+         stbi__YCbCr_to_RGB_avx2_16(out + i*step, yw0,
+                                    _mm256_permute2x128_si256(lo[0], hi[0], 0x20),
+                                    _mm256_permute2x128_si256(lo[1], hi[1], 0x20), step);
+         stbi__YCbCr_to_RGB_avx2_16(out + (i+16)*step, yw1,
+                                    _mm256_permute2x128_si256(lo[0], hi[0], 0x31),
+                                    _mm256_permute2x128_si256(lo[1], hi[1], 0x31), step);
+      }
+   }
+
+   stbi__resample_YCbCr_to_RGB_span(out, y, cb_near, cb_far, cr_near, cr_far, w, hs, vs, i, count, step);
+}
+#endif // STBI_AVX2
+
+static
+#ifdef STBI_THREAD_LOCAL
+STBI_THREAD_LOCAL
+#endif
+int stbi__jpeg_simd_limit = STBI_simd_256;
+
+STBIDEF void stbi_set_jpeg_simd_limit(int limit)
+{
+   stbi__jpeg_simd_limit = limit;
+}
+
+STBIDEF int stbi_jpeg_simd_level(void)
+{
+   int level = STBI_simd_none;
+#ifdef STBI_SSE2
+   if (stbi__sse2_available()) level = STBI_simd_128;
+#endif
+#ifdef STBI_NEON
+   level = STBI_simd_128;
+#endif
+#ifdef STBI_AVX2
+   if (level == STBI_simd_128 && stbi__avx2_available()) level = STBI_simd_256;
+#endif
+   return level < stbi__jpeg_simd_limit ? level : stbi__jpeg_simd_limit;
+}
+
 // set up the kernels
 static void stbi__setup_jpeg(stbi__jpeg *j)
 {
+   int level = stbi_jpeg_simd_level();
+   STBI_NOTUSED(level);
    j->idct_block_kernel = stbi__idct_block;
+   j->idct_batch_kernel = NULL;
    j->YCbCr_to_RGB_kernel = stbi__YCbCr_to_RGB_row;
    j->resample_row_hv_2_kernel = stbi__resample_row_hv_2;
+   j->resample_YCbCr_to_RGB_kernel = NULL;
 
-#ifdef STBI_SSE2
-   if (stbi__sse2_available()) {
+#if defined(STBI_SSE2) || defined(STBI_NEON)
+   if (level >= STBI_simd_128) {
       j->idct_block_kernel = stbi__idct_simd;
       j->YCbCr_to_RGB_kernel = stbi__YCbCr_to_RGB_simd;
       j->resample_row_hv_2_kernel = stbi__resample_row_hv_2_simd;
    }
 #endif
 
-#ifdef STBI_NEON
-   j->idct_block_kernel = stbi__idct_simd;
-   j->YCbCr_to_RGB_kernel = stbi__YCbCr_to_RGB_simd;
-   j->resample_row_hv_2_kernel = stbi__resample_row_hv_2_simd;
+#ifdef STBI_AVX2
+   if (level >= STBI_simd_256) {
+      j->idct_batch_kernel = stbi__idct_avx2;
+      j->YCbCr_to_RGB_kernel = stbi__YCbCr_to_RGB_avx2;
+      j->resample_YCbCr_to_RGB_kernel = stbi__resample_YCbCr_to_RGB_avx2;
+   }
 #endif
 }
 
@@ -3972,6 +4711,16 @@ static void stbi__cleanup_jpeg(stbi__jpeg *j)
    stbi__free_jpeg_components(j, j->s->img_n, 0);
 }
 
+// the row kernel that upsamples a component by hs x vs
+static resample_row_func stbi__resample_row_kernel(stbi__jpeg *z, int hs, int vs)
+{
+   if      (hs == 1 && vs == 1) return resample_row_1;
+   else if (hs == 1 && vs == 2) return stbi__resample_row_v_2;
+   else if (hs == 2 && vs == 1) return stbi__resample_row_h_2;
+   else if (hs == 2 && vs == 2) return z->resample_row_hv_2_kernel;
+   else                         return stbi__resample_row_generic;
+}
+
 typedef struct
 {
    resample_row_func resample;
@@ -3982,6 +4731,50 @@ typedef struct
    int ypos;    // which pre-expansion row we're on
 } stbi__resample;
 
+STBIDEF void stbi_jpeg_YCbCr_to_RGB(stbi_uc *out, stbi_uc const *y, stbi_uc const *cb, stbi_uc const *cr, int width, int height, int hs, int vs, int step)
+{
+   // walks the rows the way load_jpeg_image does, with cb and cr sharing one resampler and
+   // the chroma rows as offsets into cb and cr
+   stbi__jpeg *z;
+   resample_row_func resample;
+   stbi_uc *linebuf_cb, *linebuf_cr;
+   int j, ystep = vs >> 1, ypos = 0;
+   int w_lores = (width + hs-1) / hs, h_lores = (height + vs-1) / vs;
+   size_t line0 = 0, line1 = 0;
+
+   if (hs < 1 || hs > 2 || vs < 1 || vs > 2 || (step != 3 && step != 4)) return;
+   z = (stbi__jpeg *) stbi__malloc(sizeof(stbi__jpeg));
+   linebuf_cb = (stbi_uc *) stbi__malloc(width + 3);
+   linebuf_cr = (stbi_uc *) stbi__malloc(width + 3);
+   if (z && linebuf_cb && linebuf_cr) {
+      stbi__setup_jpeg(z);
+      resample = stbi__resample_row_kernel(z, hs, vs);
+      for (j=0; j < height; ++j) {
+         int y_bot = ystep >= (vs >> 1);
+         size_t near_row = y_bot ? line1 : line0;
+         size_t far_row  = y_bot ? line0 : line1;
+         stbi_uc *row = out + (size_t) step * width * j;
+         stbi_uc const *y_row = y + (size_t) width * j;
+         if (z->resample_YCbCr_to_RGB_kernel && hs * vs > 1) {
+            z->resample_YCbCr_to_RGB_kernel(row, y_row, cb + near_row, cb + far_row, cr + near_row, cr + far_row, w_lores, hs, vs, width, step);
+         } else {
+            stbi_uc *cb_row = resample(linebuf_cb, (stbi_uc *) cb + near_row, (stbi_uc *) cb + far_row, w_lores, hs);
+            stbi_uc *cr_row = resample(linebuf_cr, (stbi_uc *) cr + near_row, (stbi_uc *) cr + far_row, w_lores, hs);
+            z->YCbCr_to_RGB_kernel(row, y_row, cb_row, cr_row, width, step);
+         }
+         if (++ystep >= vs) {
+            ystep = 0;
+            line0 = line1;
+            if (++ypos < h_lores)
+               line1 += w_lores;
+         }
+      }
+   }
+   STBI_FREE(linebuf_cr);
+   STBI_FREE(linebuf_cb);
+   STBI_FREE(z);
+}
+
 // fast 0..255 * 0..255 => 0..255 rounded multiplication
 static stbi_uc stbi__blinn_8x8(stbi_uc x, stbi_uc y)
 {
@@ -4016,10 +4809,11 @@ static stbi_uc *load_jpeg_image(stbi__jpeg *z, int *out_x, int *out_y, int *comp
 
    // resample and color-convert
    {
-      int k;
+      int k, fused;
       unsigned int i,j;
       stbi_uc *output;
       stbi_uc *coutput[4] = { NULL, NULL, NULL, NULL };
+      stbi_uc *in_near[4], *in_far[4];
 
       stbi__resample res_comp[4];
 
@@ -4038,15 +4832,17 @@ static stbi_uc *load_jpeg_image(stbi__jpeg *z, int *out_x, int *out_y, int *comp
          r->ypos    = 0;
          r->line0   = r->line1 = z->img_comp[k].data;
 
-         if      (r->hs == 1 && r->vs == 1) r->resample = resample_row_1;
-         else if (r->hs == 1 && r->vs == 2) r->resample = stbi__resample_row_v_2;
-         else if (r->hs == 2 && r->vs == 1) r->resample = stbi__resample_row_h_2;
-         else if (r->hs == 2 && r->vs == 2) r->resample = z->resample_row_hv_2_kernel;
-         else                               r->resample = stbi__resample_row_generic;
+         r->resample = stbi__resample_row_kernel(z, r->hs, r->vs);
       }
 
+      // full resolution y with cb and cr subsampled alike, which the fused kernel takes
+      fused = z->resample_YCbCr_to_RGB_kernel && n >= 3 && z->s->img_n == 3 && !is_rgb
+           && res_comp[0].hs == 1 && res_comp[0].vs == 1
+           && res_comp[1].hs == res_comp[2].hs && res_comp[1].vs == res_comp[2].vs
+           && res_comp[1].hs <= 2 && res_comp[1].vs <= 2 && res_comp[1].hs * res_comp[1].vs > 1;
+
       // can't error after this so, this is safe
-      output = (stbi_uc *) stbi__malloc_mad3(n, z->s->img_x, z->s->img_y, 1);
+      output = (stbi_uc *) stbi__malloc_output_mad3(z->s, n, z->s->img_x, z->s->img_y, 1);
       if (!output) { stbi__cleanup_jpeg(z); return stbi__errpuc("outofmem", "Out of memory"); }
 
       // now go ahead and resample
@@ -4055,10 +4851,10 @@ static stbi_uc *load_jpeg_image(stbi__jpeg *z, int *out_x, int *out_y, int *comp
          for (k=0; k < decode_n; ++k) {
             stbi__resample *r = &res_comp[k];
             int y_bot = r->ystep >= (r->vs >> 1);
-            coutput[k] = r->resample(z->img_comp[k].linebuf,
-                                     y_bot ? r->line1 : r->line0,
-                                     y_bot ? r->line0 : r->line1,
-                                     r->w_lores, r->hs);
+            in_near[k] = y_bot ? r->line1 : r->line0;
+            in_far[k]  = y_bot ? r->line0 : r->line1;
+            if (!fused || k == 0)
+               coutput[k] = r->resample(z->img_comp[k].linebuf, in_near[k], in_far[k], r->w_lores, r->hs);
             if (++r->ystep >= r->vs) {
                r->ystep = 0;
                r->line0 = r->line1;
@@ -4077,6 +4873,9 @@ static stbi_uc *load_jpeg_image(stbi__jpeg *z, int *out_x, int *out_y, int *comp
                      out[3] = 255;
                      out += n;
                   }
+               } else if (fused) {
+                  z->resample_YCbCr_to_RGB_kernel(out, y, in_near[1], in_far[1], in_near[2], in_far[2],
+                                                  res_comp[1].w_lores, res_comp[1].hs, res_comp[1].vs, z->s->img_x, n);
                } else {
                   z->YCbCr_to_RGB_kernel(out, y, coutput[1], coutput[2], z->s->img_x, n);
                }
@@ -4836,7 +5635,11 @@ static int stbi__create_png_image_raw(stbi__png *a, stbi_uc *raw, stbi__uint32 r
    int width = x;
 
    STBI_ASSERT(out_n == s->img_n || out_n == s->img_n+1);
-   a->out = (stbi_uc *) stbi__malloc_mad3(x, y, output_bytes, 0); // extra bytes to write off the end into
+   // palette indices and 16-bit samples are converted later, so they never go to the target
+   if (color != 3 && depth != 16 && (s->out_target_req_comp == 0 || s->out_target_req_comp == out_n))
+      a->out = (stbi_uc *) stbi__malloc_output_mad3(s, x, y, output_bytes, 0);
+   else
+      a->out = (stbi_uc *) stbi__malloc_mad3(x, y, output_bytes, 0); // extra bytes to write off the end into
    if (!a->out) return stbi__err("outofmem", "Out of memory");
 
    // note: error exits here don't need to clean up a->out individually,
@@ -4995,8 +5798,13 @@ static int stbi__create_png_image(stbi__png *a, stbi_uc *image_data, stbi__uint3
       return stbi__create_png_image_raw(a, image_data, image_data_len, out_n, a->s->img_x, a->s->img_y, depth, color);
 
    // de-interlacing
-   final = (stbi_uc *) stbi__malloc_mad3(a->s->img_x, a->s->img_y, out_bytes, 0);
+   if (color != 3 && depth != 16 && (a->s->out_target_req_comp == 0 || a->s->out_target_req_comp == out_n))
+      final = (stbi_uc *) stbi__malloc_output_mad3(a->s, a->s->img_x, a->s->img_y, out_bytes, 0);
+   else
+      final = (stbi_uc *) stbi__malloc_mad3(a->s->img_x, a->s->img_y, out_bytes, 0);
    if (!final) return stbi__err("outofmem", "Out of memory");
+   // the passes are freed after copying them out, keep them off the target
+   a->s->out_target_used = 1;
    for (p=0; p < 7; ++p) {
       int xorig[] = { 0,4,0,2,0,1,0 };
       int yorig[] = { 0,0,4,0,2,0,1 };
@@ -5009,7 +5817,7 @@ static int stbi__create_png_image(stbi__png *a, stbi_uc *image_data, stbi__uint3
       if (x && y) {
          stbi__uint32 img_len = ((((a->s->img_n * x * depth) + 7) >> 3) + 1) * y;
          if (!stbi__create_png_image_raw(a, image_data, image_data_len, out_n, x, y, depth, color)) {
-            STBI_FREE(final);
+            stbi__free_output(a->s, final);
             return 0;
          }
          for (j=0; j < y; ++j) {
@@ -5026,6 +5834,7 @@ static int stbi__create_png_image(stbi__png *a, stbi_uc *image_data, stbi__uint3
       }
    }
    a->out = final;
+   a->s->out_target_used = final == a->s->out_target;
 
    return 1;
 }
@@ -5085,7 +5894,10 @@ static int stbi__expand_png_palette(stbi__png *a, stbi_uc *palette, int len, int
    stbi__uint32 i, pixel_count = a->s->img_x * a->s->img_y;
    stbi_uc *p, *temp_out, *orig = a->out;
 
-   p = (stbi_uc *) stbi__malloc_mad2(pixel_count, pal_img_n, 0);
+   if (a->s->out_target_req_comp == 0 || a->s->out_target_req_comp == pal_img_n)
+      p = (stbi_uc *) stbi__malloc_output_mad3(a->s, a->s->img_x, a->s->img_y, pal_img_n, 0);
+   else
+      p = (stbi_uc *) stbi__malloc_mad2(pixel_count, pal_img_n, 0);
    if (p == NULL) return stbi__err("outofmem", "Out of memory");
 
    // between here and free(out) below, exitting would leak
@@ -5412,7 +6224,7 @@ static void *stbi__do_png(stbi__png *p, int *x, int *y, int *n, int req_comp, st
       *y = p->s->img_y;
       if (n) *n = p->s->img_n;
    }
-   STBI_FREE(p->out);      p->out      = NULL;
+   stbi__free_output(p->s, p->out); p->out = NULL;
    STBI_FREE(p->expanded); p->expanded = NULL;
    STBI_FREE(p->idata);    p->idata    = NULL;
 
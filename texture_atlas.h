@@ -0,0 +1,640 @@
+#pragma once
+
+#ifndef TEXTURE_ATLAS_H
+#define TEXTURE_ATLAS_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <glad/glad.h>
+#include <iostream>
+#include <optional>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "block_compression.h"
+#include "gl_extensions.h"
+#include "mip_chain.h"
+
+// Fewer texture binds per frame, by putting many textures behind one GL_TEXTURE_2D_ARRAY.
+// Textures of the same format and size become layers of one array (LayerPacking); images of any
+// size are packed into the layers of an atlas with a skyline packer, and drawn with their UVs
+// remapped to where they landed (Atlas). Either way, a draw picks its texture with a layer index
+// instead of a bind, so one instanced draw can cover thousands of sprites.
+namespace texture_atlas {
+    struct Rect {
+        uint32_t x;
+        uint32_t y;
+        uint32_t width;
+        uint32_t height;
+    };
+
+    // Bottom-left skyline packing into a fixed size page: the page keeps the height of its top
+    // edge per run of columns, and each rectangle rests on the run that leaves its top lowest.
+    class Skyline {
+        struct Segment {
+            uint32_t x;
+            uint32_t y;
+            uint32_t width;
+        };
+
+        uint32_t width_;
+        uint32_t height_;
+        uint64_t used_ { 0 };
+        // left to right, covering the whole width
+        std::vector<Segment> segments_;
+
+    public:
+        Skyline(uint32_t width, uint32_t height);
+
+        // Where a `width` by `height` rectangle went, nullopt when it does not fit.
+        auto insert(uint32_t width, uint32_t height) -> std::optional<Rect>;
+        // Area taken by what was inserted.
+        auto used() const -> uint64_t;
+    };
+
+    inline Skyline::Skyline(const uint32_t width, const uint32_t height):
+        width_ { width },
+        height_ { height },
+        segments_ { Segment { 0, 0, width } } {}
+
+    inline auto Skyline::insert(const uint32_t width, const uint32_t height)
+        -> std::optional<Rect> {
+        if (width == 0 || height == 0 || width > this->width_ || height > this->height_) {
+            return std::nullopt;
+        }
+        std::optional<size_t> best {};
+        uint32_t best_y = 0;
+        for (size_t i = 0; i < this->segments_.size(); ++i) {
+            const auto x = this->segments_[i].x;
+            if (x + width > this->width_) {
+                break;
+            }
+            // it rests on the highest segment under it
+            auto y = 0U;
+            auto covered = 0U;
+            for (auto j = i; covered < width; ++j) {
+                y = std::max(y, this->segments_[j].y);
+                covered += this->segments_[j].width;
+            }
+            if (y + height > this->height_) {
+                continue;
+            }
+            if (!best.has_value() || y < best_y) {
+                best = i;
+                best_y = y;
+            }
+        }
+        if (!best.has_value()) {
+            return std::nullopt;
+        }
+
+        const Rect rect { this->segments_[*best].x, best_y, width, height };
+        const auto right = rect.x + width;
+        auto& segments = this->segments_;
+        const auto first = segments.begin() + static_cast<std::ptrdiff_t>(*best);
+        // drop the segments the rectangle covers, and trim the one it ends on
+        auto last = first;
+        while (last != segments.end() && last->x + last->width <= right) {
+            ++last;
+        }
+        if (last != segments.end() && last->x < right) {
+            last->width -= right - last->x;
+            last->x = right;
+        }
+        const auto placed = segments.erase(first, last);
+        segments.insert(placed, Segment { rect.x, rect.y + height, width });
+        for (size_t i = 0; i + 1 < segments.size();) {
+            if (segments[i].y == segments[i + 1].y) {
+                segments[i].width += segments[i + 1].width;
+                segments.erase(segments.begin() + static_cast<std::ptrdiff_t>(i + 1));
+            } else {
+                ++i;
+            }
+        }
+        this->used_ += static_cast<uint64_t>(width) * height;
+        return rect;
+    }
+
+    inline auto Skyline::used() const -> uint64_t {
+        return this->used_;
+    }
+
+    // One GL_TEXTURE_2D_ARRAY.
+    struct TextureArray {
+        uint32_t id;
+        GLenum internal_format;
+        uint32_t width;
+        uint32_t height;
+        uint32_t layers;
+        uint32_t levels;
+    };
+
+    // Which array and layer a texture went to.
+    struct Slot {
+        size_t array;
+        uint32_t layer;
+    };
+
+    namespace detail {
+        // glTexStorage3D only takes sized formats.
+        inline auto sized_format(const GLenum internal_format) -> GLenum {
+            switch (internal_format) {
+            case GL_RED:
+                return GL_R8;
+            case GL_RG:
+                return GL_RG8;
+            case GL_RGB:
+                return GL_RGB8;
+            case GL_RGBA:
+                return GL_RGBA8;
+            default:
+                return internal_format;
+            }
+        }
+
+        inline auto level_size(const uint32_t size, const uint32_t level) -> uint32_t {
+            return std::max(size >> level, 1U);
+        }
+
+        // Allocates every level of `array`, bound to GL_TEXTURE_2D_ARRAY. Prints why and
+        // returns false when the format is compressed, one we do not know and there is no
+        // glTexStorage3D to allocate it with.
+        inline auto allocate(const TextureArray& array, const bool compressed) -> bool {
+            const auto& extensions = gl_extensions::get();
+            if (extensions.texture_storage) {
+                extensions.glTexStorage3D(
+                    GL_TEXTURE_2D_ARRAY,
+                    static_cast<GLsizei>(array.levels),
+                    array.internal_format,
+                    static_cast<GLsizei>(array.width),
+                    static_cast<GLsizei>(array.height),
+                    static_cast<GLsizei>(array.layers)
+                );
+                return true;
+            }
+            const auto format = block_compression::from_internal_format(array.internal_format);
+            if (compressed && !format.has_value()) {
+                std::cout << "ERROR: cannot allocate a texture array in compressed format "
+                    << array.internal_format << '\n';
+                return false;
+            }
+            for (uint32_t level = 0; level < array.levels; ++level) {
+                const auto width = level_size(array.width, level);
+                const auto height = level_size(array.height, level);
+                if (compressed) {
+                    const auto size = block_compression::encoded_size(*format, width, height)
+                        * array.layers;
+                    glCompressedTexImage3D(
+                        GL_TEXTURE_2D_ARRAY,
+                        static_cast<GLint>(level),
+                        array.internal_format,
+                        static_cast<GLsizei>(width),
+                        static_cast<GLsizei>(height),
+                        static_cast<GLsizei>(array.layers),
+                        0,
+                        static_cast<GLsizei>(size),
+                        nullptr
+                    );
+                } else {
+                    glTexImage3D(
+                        GL_TEXTURE_2D_ARRAY,
+                        static_cast<GLint>(level),
+                        static_cast<GLint>(array.internal_format),
+                        static_cast<GLsizei>(width),
+                        static_cast<GLsizei>(height),
+                        static_cast<GLsizei>(array.layers),
+                        0,
+                        GL_RGBA,
+                        GL_UNSIGNED_BYTE,
+                        nullptr
+                    );
+                }
+            }
+            glTexParameteri(
+                GL_TEXTURE_2D_ARRAY,
+                GL_TEXTURE_MAX_LEVEL,
+                static_cast<GLint>(array.levels) - 1
+            );
+            return true;
+        }
+
+        // Copies `level` of `texture`, bound to GL_TEXTURE_2D, into `layer` of `array`, bound to
+        // GL_TEXTURE_2D_ARRAY. On the GPU when the driver can, through client memory otherwise:
+        // glCopyImageSubData does not take textures given an unsized format like GL_RGB.
+        inline auto copy_level(
+            const uint32_t texture,
+            const TextureArray& array,
+            const uint32_t layer,
+            const uint32_t level,
+            const bool compressed,
+            const bool sized
+        ) -> void {
+            const auto width = static_cast<GLsizei>(level_size(array.width, level));
+            const auto height = static_cast<GLsizei>(level_size(array.height, level));
+            const auto index = static_cast<GLint>(level);
+            const auto& extensions = gl_extensions::get();
+            if (extensions.copy_image && sized) {
+                extensions.glCopyImageSubData(
+                    texture,
+                    GL_TEXTURE_2D,
+                    index,
+                    0,
+                    0,
+                    0,
+                    array.id,
+                    GL_TEXTURE_2D_ARRAY,
+                    index,
+                    0,
+                    0,
+                    static_cast<GLint>(layer),
+                    width,
+                    height,
+                    1
+                );
+                return;
+            }
+
+            std::vector<uint8_t> texels;
+            if (compressed) {
+                GLint size = 0;
+                glGetTexLevelParameteriv(
+                    GL_TEXTURE_2D,
+                    index,
+                    GL_TEXTURE_COMPRESSED_IMAGE_SIZE,
+                    &size
+                );
+                texels.resize(static_cast<size_t>(size));
+                glGetCompressedTexImage(GL_TEXTURE_2D, index, texels.data());
+                glCompressedTexSubImage3D(
+                    GL_TEXTURE_2D_ARRAY,
+                    index,
+                    0,
+                    0,
+                    static_cast<GLint>(layer),
+                    width,
+                    height,
+                    1,
+                    array.internal_format,
+                    size,
+                    texels.data()
+                );
+                return;
+            }
+            texels.resize(static_cast<size_t>(width) * static_cast<size_t>(height) * 4);
+            glGetTexImage(GL_TEXTURE_2D, index, GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+            glTexSubImage3D(
+                GL_TEXTURE_2D_ARRAY,
+                index,
+                0,
+                0,
+                static_cast<GLint>(layer),
+                width,
+                height,
+                1,
+                GL_RGBA,
+                GL_UNSIGNED_BYTE,
+                texels.data()
+            );
+        }
+    } // namespace detail
+
+    // Copies 2D textures into as few arrays as their formats and sizes allow, every level
+    // they have included. Textures only share an array when they also filter and wrap the same
+    // way, which the array then does too.
+    class LayerPacking {
+        std::vector<TextureArray> arrays_;
+        std::vector<Slot> slots_;
+
+    public:
+        // Needs a current context. Leaves other textures bound to GL_TEXTURE_2D and
+        // GL_TEXTURE_2D_ARRAY on the active unit, so cached binding state is stale afterwards.
+        explicit LayerPacking(const std::vector<uint32_t>& textures);
+        ~LayerPacking();
+
+        LayerPacking(const LayerPacking&) = delete;
+        auto operator=(const LayerPacking&) -> LayerPacking& = delete;
+
+        auto arrays() const -> const std::vector<TextureArray>&;
+        // Where textures[index] went. A texture passed twice goes to one layer.
+        auto slot(size_t index) const -> const Slot&;
+    };
+
+    inline LayerPacking::LayerPacking(const std::vector<uint32_t>& textures) {
+        struct Source {
+            uint32_t texture;
+            bool compressed;
+            bool sized;
+            std::array<GLint, 4> parameters;
+        };
+        constexpr std::array<GLenum, 4> parameter_names {
+            GL_TEXTURE_MIN_FILTER,
+            GL_TEXTURE_MAG_FILTER,
+            GL_TEXTURE_WRAP_S,
+            GL_TEXTURE_WRAP_T,
+        };
+
+        // per array, the textures in layer order
+        std::vector<std::vector<Source>> layers;
+        for (const auto texture : textures) {
+            const auto same_texture = [texture](const std::vector<Source>& sources) {
+                return std::any_of(sources.begin(), sources.end(), [texture](const Source& source) {
+                    return source.texture == texture;
+                });
+            };
+            const auto packed = std::find_if(layers.begin(), layers.end(), same_texture);
+            if (packed != layers.end()) {
+                const auto array = static_cast<size_t>(packed - layers.begin());
+                const auto layer = std::find_if(
+                    packed->begin(),
+                    packed->end(),
+                    [texture](const Source& source) { return source.texture == texture; }
+                ) - packed->begin();
+                this->slots_.push_back(Slot { array, static_cast<uint32_t>(layer) });
+                continue;
+            }
+
+            glBindTexture(GL_TEXTURE_2D, texture);
+            GLint width = 0;
+            GLint height = 0;
+            GLint internal_format = 0;
+            GLint compressed = 0;
+            GLint max_level = 0;
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+            glGetTexLevelParameteriv(
+                GL_TEXTURE_2D,
+                0,
+                GL_TEXTURE_INTERNAL_FORMAT,
+                &internal_format
+            );
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED, &compressed);
+            glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, &max_level);
+            // the levels actually defined, which a texture never given mipmaps has one of
+            uint32_t levels = 1;
+            while (static_cast<GLint>(levels) <= max_level) {
+                GLint level_width = 0;
+                glGetTexLevelParameteriv(
+                    GL_TEXTURE_2D,
+                    static_cast<GLint>(levels),
+                    GL_TEXTURE_WIDTH,
+                    &level_width
+                );
+                if (level_width == 0) {
+                    break;
+                }
+                ++levels;
+            }
+            const auto format = static_cast<GLenum>(internal_format);
+            Source source {
+                texture,
+                compressed != 0,
+                detail::sized_format(format) == format,
+                {},
+            };
+            for (size_t i = 0; i < parameter_names.size(); ++i) {
+                glGetTexParameteriv(GL_TEXTURE_2D, parameter_names[i], &source.parameters[i]);
+            }
+
+            const TextureArray shape {
+                0,
+                detail::sized_format(format),
+                static_cast<uint32_t>(width),
+                static_cast<uint32_t>(height),
+                0,
+                levels,
+            };
+            // an array has one sampler state, so it is part of the key
+            const auto same_array = [&](const size_t index) {
+                const auto& array = this->arrays_[index];
+                return std::tie(array.internal_format, array.width, array.height, array.levels)
+                    == std::tie(shape.internal_format, shape.width, shape.height, shape.levels)
+                    && layers[index].front().parameters == source.parameters;
+            };
+            size_t array = 0;
+            while (array < this->arrays_.size() && !same_array(array)) {
+                ++array;
+            }
+            if (array == this->arrays_.size()) {
+                this->arrays_.push_back(shape);
+                layers.emplace_back();
+            }
+            this->slots_.push_back(Slot { array, this->arrays_[array].layers });
+            ++this->arrays_[array].layers;
+            layers[array].push_back(source);
+        }
+
+        for (size_t i = 0; i < this->arrays_.size(); ++i) {
+            auto& array = this->arrays_[i];
+            const auto& sources = layers[i];
+            glGenTextures(1, &array.id);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, array.id);
+            if (!detail::allocate(array, sources.front().compressed)) {
+                continue;
+            }
+            for (size_t name = 0; name < parameter_names.size(); ++name) {
+                glTexParameteri(
+                    GL_TEXTURE_2D_ARRAY,
+                    parameter_names[name],
+                    sources.front().parameters[name]
+                );
+            }
+            for (uint32_t layer = 0; layer < array.layers; ++layer) {
+                const auto& source = sources[layer];
+                glBindTexture(GL_TEXTURE_2D, source.texture);
+                for (uint32_t level = 0; level < array.levels; ++level) {
+                    detail::copy_level(
+                        source.texture,
+                        array,
+                        layer,
+                        level,
+                        source.compressed,
+                        source.sized
+                    );
+                }
+            }
+        }
+    }
+
+    inline LayerPacking::~LayerPacking() {
+        for (const auto& array : this->arrays_) {
+            glDeleteTextures(1, &array.id);
+        }
+    }
+
+    inline auto LayerPacking::arrays() const -> const std::vector<TextureArray>& {
+        return this->arrays_;
+    }
+
+    inline auto LayerPacking::slot(const size_t index) const -> const Slot& {
+        return this->slots_[index];
+    }
+
+    // Where an image went in an Atlas, with the UVs to sample it through.
+    struct Region {
+        uint32_t layer;
+        // left, bottom, right, top
+        std::array<float, 4> uv;
+    };
+
+    // RGBA8 pages in one GL_TEXTURE_2D_ARRAY, each skyline packed with images of any size.
+    //
+    // Every image brings its own mip levels, and is placed on a grid of 2^(levels - 1) texels
+    // with as wide a gutter of its edge texels around it, so its smallest level still lands on
+    // whole texels and filtering never reaches into a neighbour. Atlas UVs only cover the image
+    // itself, so repeating wrap modes do not apply to them.
+    class Atlas {
+        uint32_t id_ { 0 };
+        uint32_t page_size_;
+        uint32_t max_pages_;
+        uint32_t levels_;
+        std::vector<Skyline> pages_;
+
+    public:
+        // Needs a current context, and leaves the atlas bound to GL_TEXTURE_2D_ARRAY on the
+        // active unit.
+        Atlas(uint32_t page_size, uint32_t max_pages, uint32_t levels);
+        ~Atlas();
+
+        Atlas(const Atlas&) = delete;
+        auto operator=(const Atlas&) -> Atlas& = delete;
+
+        // Packs `image` into the first page with room for it, filtering its mip levels with
+        // `options`. Prints why and returns nullopt when no page has room. Binds the atlas to
+        // GL_TEXTURE_2D_ARRAY on the active unit.
+        auto add(const mip_chain::Image& image, const mip_chain::Options& options = {})
+            -> std::optional<Region>;
+        auto id() const -> uint32_t;
+        auto pages() const -> uint32_t;
+        // The share of the pages in use covered by images and their gutters.
+        auto coverage() const -> double;
+    };
+
+    inline Atlas::Atlas(const uint32_t page_size, const uint32_t max_pages, const uint32_t levels):
+        page_size_ { page_size },
+        max_pages_ { max_pages },
+        levels_ { std::max(levels, 1U) } {
+        glGenTextures(1, &this->id_);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, this->id_);
+        detail::allocate(
+            TextureArray {
+                this->id_,
+                GL_RGBA8,
+                page_size,
+                page_size,
+                max_pages,
+                this->levels_,
+            },
+            false
+        );
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    inline Atlas::~Atlas() {
+        glDeleteTextures(1, &this->id_);
+    }
+
+    inline auto Atlas::add(const mip_chain::Image& image, const mip_chain::Options& options)
+        -> std::optional<Region> {
+        const auto grid = 1U << (this->levels_ - 1);
+        const auto gutter = grid;
+        const auto round_up = [grid](const uint32_t size) {
+            return (size + grid - 1) / grid * grid;
+        };
+        const auto width = round_up(image.width + 2 * gutter);
+        const auto height = round_up(image.height + 2 * gutter);
+
+        std::optional<Rect> rect {};
+        auto layer = 0U;
+        for (; layer < this->max_pages_ && !rect.has_value(); ++layer) {
+            if (layer == this->pages_.size()) {
+                this->pages_.emplace_back(this->page_size_, this->page_size_);
+            }
+            rect = this->pages_[layer].insert(width, height);
+        }
+        if (!rect.has_value()) {
+            std::cout << "ERROR: no room in the atlas for a " << image.width << "x"
+                << image.height << " image" << '\n';
+            return std::nullopt;
+        }
+        --layer;
+
+        // the gutter repeats the edge texels outwards
+        mip_chain::Image padded { width, height, std::vector<uint8_t>(width * height * 4) };
+        for (uint32_t y = 0; y < height; ++y) {
+            const auto source_y = std::clamp(
+                static_cast<int64_t>(y) - gutter,
+                int64_t { 0 },
+                static_cast<int64_t>(image.height) - 1
+            );
+            for (uint32_t x = 0; x < width; ++x) {
+                const auto source_x = std::clamp(
+                    static_cast<int64_t>(x) - gutter,
+                    int64_t { 0 },
+                    static_cast<int64_t>(image.width) - 1
+                );
+                const auto* const texel =
+                    &image.pixels[static_cast<size_t>(source_y * image.width + source_x) * 4];
+                const auto target = (static_cast<size_t>(y) * width + x) * 4;
+                std::copy(texel, texel + 4, &padded.pixels[target]);
+            }
+        }
+        const auto levels = mip_chain::build(std::move(padded), options);
+
+        glBindTexture(GL_TEXTURE_2D_ARRAY, this->id_);
+        for (uint32_t level = 0; level < this->levels_; ++level) {
+            const auto& pixels = levels[level];
+            glTexSubImage3D(
+                GL_TEXTURE_2D_ARRAY,
+                static_cast<GLint>(level),
+                static_cast<GLint>(rect->x >> level),
+                static_cast<GLint>(rect->y >> level),
+                static_cast<GLint>(layer),
+                static_cast<GLsizei>(pixels.width),
+                static_cast<GLsizei>(pixels.height),
+                1,
+                GL_RGBA,
+                GL_UNSIGNED_BYTE,
+                pixels.pixels.data()
+            );
+        }
+
+        const auto page = static_cast<float>(this->page_size_);
+        return Region {
+            layer,
+            {
+                static_cast<float>(rect->x + gutter) / page,
+                static_cast<float>(rect->y + gutter) / page,
+                static_cast<float>(rect->x + gutter + image.width) / page,
+                static_cast<float>(rect->y + gutter + image.height) / page,
+            },
+        };
+    }
+
+    inline auto Atlas::id() const -> uint32_t {
+        return this->id_;
+    }
+
+    inline auto Atlas::pages() const -> uint32_t {
+        return static_cast<uint32_t>(this->pages_.size());
+    }
+
+    inline auto Atlas::coverage() const -> double {
+        if (this->pages_.empty()) {
+            return 0.0;
+        }
+        uint64_t used = 0;
+        for (const auto& page : this->pages_) {
+            used += page.used();
+        }
+        const auto page_area = static_cast<double>(this->page_size_) * this->page_size_;
+        return static_cast<double>(used) / (page_area * static_cast<double>(this->pages_.size()));
+    }
+} // namespace texture_atlas
+
+#endif
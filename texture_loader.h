@@ -0,0 +1,884 @@
+#pragma once
+
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <cstdint>
+#include <deque>
+#include <glad/glad.h>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "block_compression.h"
+#include "decode_arena.h"
+#include "gl_extensions.h"
+#include "ktx_file.h"
+#include "mapped_file.h"
+#include "profiler.h"
+#include "staging_ring.h"
+#include "stb_image.h"
+
+namespace texture_loader {
+    struct TextureRequest {
+        std::string path;
+        // 0 picks the format matching the file's channel count
+        GLint internal_format { 0 };
+        bool flip_vertically { true };
+        GLint wrap { GL_REPEAT };
+        GLint min_filter { GL_NEAREST_MIPMAP_LINEAR };
+        GLint mag_filter { GL_LINEAR };
+        // Uploads the source cooked into a KTX file next to it instead, mip levels and all, when
+        // there is one in a format the driver takes (see cooker_main.cpp). internal_format does
+        // not apply to those. A path ending in .ktx is always read as a cooked file.
+        bool cooked { true };
+    };
+
+    struct TextureStats {
+        int32_t width { 0 };
+        int32_t height { 0 };
+        int32_t channels { 0 };
+        // mapping the file and decoding it, on a worker
+        std::chrono::nanoseconds read_time { 0 };
+        std::chrono::nanoseconds decode_time { 0 };
+        // glTexImage2D and mipmap generation, on the GL thread
+        std::chrono::nanoseconds upload_time { 0 };
+        // decoded into the staging ring, rather than into memory of its own and copied there
+        bool decoded_in_place { false };
+        // the internal format of the cooked file uploaded, 0 when the source was decoded
+        GLenum cooked_format { 0 };
+        int32_t levels { 0 };
+        // what went to the driver, and what the texture takes with all its mip levels
+        uint64_t upload_bytes { 0 };
+        uint64_t texture_bytes { 0 };
+    };
+
+    enum class TextureState : uint8_t {
+        loading,
+        resident,
+        failed,
+    };
+
+    using TextureHandle = uint32_t;
+
+    namespace detail {
+        // What the workers do with a job next. Reading the header comes first so the GL thread
+        // can find the pixels a place in the staging ring before they are decoded.
+        enum class Step : uint8_t {
+            read_header,
+            decode,
+            upload,
+        };
+
+        struct Job {
+            TextureHandle handle;
+            TextureRequest request;
+            Step step { Step::read_header };
+            bool failed { false };
+            std::unique_ptr<mapped_file::MappedFile> file {};
+            // levels in the mapping, when the request is served from a cooked file
+            std::optional<ktx_file::KtxFile> cooked {};
+            // where the pixels are decoded to, nullopt when they go to `buffer`
+            std::optional<staging_ring::Allocation> staging {};
+            std::vector<stbi_uc> buffer {};
+            stbi_uc* pixels { nullptr };
+            TextureStats stats {};
+        };
+
+        struct Texture {
+            TextureRequest request;
+            TextureState state { TextureState::loading };
+            uint32_t texture_id { 0 };
+            TextureStats stats {};
+        };
+
+        inline auto ends_with(const std::string& text, const std::string_view suffix) -> bool {
+            return text.size() >= suffix.size()
+                && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+        }
+
+        // Takes `path` as the job's cooked file when it is RGBA8 or in one of `formats`, and has
+        // the request's orientation. Prints why not, and when the file does not exist only if it is
+        // `required`.
+        inline auto read_cooked(
+            Job& job,
+            const std::string& path,
+            const std::vector<block_compression::Format>& formats,
+            const bool required
+        ) -> bool {
+            auto file = std::make_unique<mapped_file::MappedFile>(path);
+            if (file->failed()) {
+                if (required) {
+                    std::cout << "ERROR: failed to load " << path << ": could not read the file"
+                        << '\n';
+                }
+                return false;
+            }
+            auto cooked = ktx_file::parse(file->data(), file->size(), path);
+            if (!cooked.has_value()) {
+                return false;
+            }
+            // parse() only lets RGBA8 through as GL_RGBA8, which every driver takes
+            const auto supported = cooked->type != 0 || std::any_of(
+                formats.begin(),
+                formats.end(),
+                [&cooked](const block_compression::Format format) {
+                    return block_compression::info(format).internal_format
+                        == cooked->internal_format;
+                }
+            );
+            if (!supported) {
+                std::cout << "ERROR: failed to load " << path << ": compressed format "
+                    << cooked->internal_format << " is not supported" << '\n';
+                return false;
+            }
+            if (cooked->bottom_up != job.request.flip_vertically) {
+                std::cout << "ERROR: " << path << " was cooked "
+                    << (cooked->bottom_up ? "bottom-up" : "top-down")
+                    << ", which does not match the request" << '\n';
+                return false;
+            }
+
+            auto& stats = job.stats;
+            const auto& largest = cooked->levels.front();
+            stats.width = static_cast<int32_t>(largest.width);
+            stats.height = static_cast<int32_t>(largest.height);
+            stats.channels = cooked->base_internal_format == GL_RGBA ? 4 : 3;
+            stats.cooked_format = cooked->internal_format;
+            stats.levels = static_cast<int32_t>(cooked->levels.size());
+            job.file = std::move(file);
+            job.cooked = std::move(cooked);
+            return true;
+        }
+
+        // Maps the file and checks its header describes an image stb_image can decode at all,
+        // unless one of `cooked_formats` was cooked for it. Prints why on failure.
+        inline auto read_header(
+            Job& job,
+            const std::vector<block_compression::Format>& cooked_formats
+        ) -> bool {
+            const auto& path = job.request.path;
+            if (ends_with(path, ".ktx")) {
+                return read_cooked(job, path, cooked_formats, true);
+            }
+            if (job.request.cooked) {
+                for (const auto format : cooked_formats) {
+                    const auto cooked_path =
+                        ktx_file::cooked_path(path, block_compression::info(format).name);
+                    if (read_cooked(job, cooked_path, cooked_formats, false)) {
+                        return true;
+                    }
+                }
+                // every driver takes RGBA8, so it comes last
+                const auto rgba8_path = ktx_file::cooked_path(path, ktx_file::rgba8_name);
+                if (read_cooked(job, rgba8_path, cooked_formats, false)) {
+                    return true;
+                }
+            }
+
+            job.file = std::make_unique<mapped_file::MappedFile>(path);
+            // stb_image takes the length as an int
+            constexpr auto max_size = static_cast<size_t>(std::numeric_limits<int>::max());
+            if (job.file->failed() || job.file->size() > max_size) {
+                std::cout << "ERROR: failed to load " << job.request.path
+                    << ": could not read the file" << '\n';
+                return false;
+            }
+            const decode_arena::Scope scope {};
+            const auto valid = stbi_info_from_memory(
+                job.file->data(),
+                static_cast<int>(job.file->size()),
+                &job.stats.width,
+                &job.stats.height,
+                &job.stats.channels
+            );
+            if (0 == valid) {
+                std::cout << "ERROR: failed to load " << job.request.path << ": "
+                    << stbi_failure_reason() << '\n';
+                return false;
+            }
+            return true;
+        }
+
+        // Bytes to decode into, from the header. stb_image may write one byte past the last
+        // pixel.
+        inline auto decoded_size(const TextureStats& stats) -> size_t {
+            return static_cast<size_t>(stats.width)
+                * static_cast<size_t>(stats.height)
+                * static_cast<size_t>(stats.channels)
+                + 1;
+        }
+
+        // Bytes the job needs in the staging ring: every level of a cooked file, back to back,
+        // or the decoded image.
+        inline auto payload_size(const Job& job) -> size_t {
+            if (!job.cooked.has_value()) {
+                return decoded_size(job.stats);
+            }
+            size_t size = 0;
+            for (const auto& level : job.cooked->levels) {
+                size += level.size;
+            }
+            return size;
+        }
+
+        // A cooked file only has its levels copied into the staging allocation, when it has
+        // one; otherwise they are uploaded straight from the mapping.
+        inline auto copy_cooked(Job& job) -> void {
+            if (!job.staging.has_value()) {
+                return;
+            }
+            PROFILE_ZONE("copy cooked levels");
+            auto* const output = static_cast<uint8_t*>(job.staging->data);
+            size_t offset = 0;
+            for (const auto& level : job.cooked->levels) {
+                std::memcpy(output + offset, level.data, level.size);
+                offset += level.size;
+            }
+            job.stats.decoded_in_place = true;
+        }
+
+        // One stb_image parallel_for call, whose tasks any worker may pick up. Guarded by the
+        // loader's mutex.
+        struct TaskBatch {
+            void (*task)(void* context, int index);
+            void* context;
+            int count;
+            // the next index to hand out, and how many tasks have finished
+            int next { 0 };
+            int done { 0 };
+        };
+
+        // Decodes from the mapping, into the job's staging allocation when it has one and into
+        // a buffer of its own otherwise.
+        inline auto decode(Job& job) -> bool {
+            if (job.cooked.has_value()) {
+                copy_cooked(job);
+                return true;
+            }
+            PROFILE_ZONE("stbi_load_from_memory");
+            stbi_set_flip_vertically_on_load_thread(job.request.flip_vertically ? 1 : 0);
+            const auto* const bytes = job.file->data();
+            const auto size = static_cast<int>(job.file->size());
+            auto& stats = job.stats;
+            if (!job.staging.has_value()) {
+                job.buffer.resize(decoded_size(stats));
+            }
+            auto* const output = job.staging.has_value()
+                ? static_cast<stbi_uc*>(job.staging->data)
+                : job.buffer.data();
+            // everything stb_image allocates on the way comes from this thread's arena
+            const decode_arena::Scope scope {};
+            const auto decoded = stbi_load_from_memory_into(
+                bytes,
+                size,
+                &stats.width,
+                &stats.height,
+                &stats.channels,
+                0,
+                output,
+                job.staging.has_value() ? job.staging->size : job.buffer.size()
+            );
+            if (0 == decoded) {
+                std::cout << "ERROR: failed to load " << job.request.path << ": "
+                    << stbi_failure_reason() << '\n';
+                return false;
+            }
+            job.pixels = output;
+            stats.decoded_in_place = job.staging.has_value();
+            return true;
+        }
+
+        inline auto format_of(const int32_t channels) -> GLenum {
+            constexpr std::array<GLenum, 4> formats { GL_RED, GL_RG, GL_RGB, GL_RGBA };
+            return formats[static_cast<size_t>(std::clamp(channels, 1, 4) - 1)];
+        }
+
+        // Bytes per pixel of an unsized internal format, `channels` for any other.
+        inline auto bytes_per_pixel(const GLint internal_format, const int32_t channels)
+            -> uint64_t {
+            constexpr std::array<GLint, 4> formats { GL_RED, GL_RG, GL_RGB, GL_RGBA };
+            const auto found = std::find(formats.begin(), formats.end(), internal_format);
+            const auto count = found != formats.end() ? found - formats.begin() + 1 : channels;
+            return static_cast<uint64_t>(count);
+        }
+
+        // The cooked formats the driver takes, the one we prefer first: bc7 looks best, and
+        // etc2 is decompressed by the driver on most desktop GPUs.
+        inline auto cooked_formats() -> std::vector<block_compression::Format> {
+            using block_compression::Format;
+            const auto& extensions = gl_extensions::get();
+            std::vector<Format> formats;
+            if (extensions.texture_compression_bptc) {
+                formats.push_back(Format::bc7);
+            }
+            if (extensions.texture_compression_s3tc) {
+                formats.push_back(Format::bc3);
+                formats.push_back(Format::bc1);
+            }
+            if (extensions.texture_compression_etc2) {
+                formats.push_back(Format::etc2_eac);
+                formats.push_back(Format::etc2);
+            }
+            return formats;
+        }
+    } // namespace detail
+
+    // Reads and decodes textures on a pool of worker threads. The GL thread only reserves
+    // staging memory for the workers to decode into and uploads what they finished, from
+    // poll(), and hands out a placeholder until then.
+    class TextureLoader {
+        std::vector<detail::Texture> textures_;
+        uint32_t placeholder_id_ { 0 };
+        staging_ring::StagingRing staging_;
+        // set before the workers start, which only read it
+        std::vector<block_compression::Format> cooked_formats_;
+        std::chrono::steady_clock::time_point first_request_ {};
+        std::chrono::steady_clock::time_point last_upload_ {};
+
+        // headers read while the staging ring was full, retried on the next poll()
+        std::vector<detail::Job> waiting_;
+
+        std::mutex mutex_;
+        std::condition_variable wake_;
+        // guarded by mutex_
+        std::deque<detail::Job> work_;
+        std::vector<detail::Job> finished_;
+        // restart intervals of the JPEGs being decoded, which go before new jobs
+        std::deque<detail::TaskBatch*> batches_;
+        std::condition_variable batch_done_;
+        bool stopping_ { false };
+        std::vector<std::thread> workers_;
+
+        auto run() -> void;
+        // Runs tasks of `batch` until there are none left to hand out. Takes `lock` locked and
+        // returns with it locked.
+        auto run_tasks(detail::TaskBatch& batch, std::unique_lock<std::mutex>& lock) -> void;
+        // False when the ring has no room for the job yet.
+        auto stage(detail::Job& job) -> bool;
+        auto upload(detail::Job& job) -> void;
+        // Upload into the texture bound to GL_TEXTURE_2D, and fill in the job's byte counts.
+        auto upload_decoded(detail::Job& job, const TextureRequest& request) -> void;
+        auto upload_cooked(detail::Job& job) -> void;
+
+    public:
+        // Uses one worker per hardware thread, up to `max_workers`, and stages uploads through
+        // `staging_size` bytes of pixel buffer. Needs a current context.
+        explicit TextureLoader(uint32_t max_workers = 8, size_t staging_size = 16U << 20U);
+        ~TextureLoader();
+
+        TextureLoader(const TextureLoader&) = delete;
+        auto operator=(const TextureLoader&) -> TextureLoader& = delete;
+
+        // stb_image's parallel_for hook, with the TextureLoader as `loader`: runs the restart
+        // intervals of a JPEG on the loader's workers, the calling thread included, instead of
+        // threads of its own. Every worker installs it for the decodes it does.
+        static auto jpeg_parallel_for(
+            void* loader,
+            int count,
+            void (*task)(void* context, int index),
+            void* context
+        ) -> void;
+
+        auto request(TextureRequest request) -> TextureHandle;
+        // Reserves staging memory for the headers the workers read and uploads every texture
+        // they decoded since the last call, and returns how many. Uploads bind textures on the
+        // active unit, so cached binding state is stale when this returns anything but 0.
+        auto poll() -> uint32_t;
+
+        // The real texture once it is resident, the placeholder until then or when it failed.
+        auto texture(TextureHandle handle) const -> uint32_t;
+        auto state(TextureHandle handle) const -> TextureState;
+        auto stats(TextureHandle handle) const -> const TextureStats&;
+        auto staging() const -> const staging_ring::StagingRing&;
+        // True once no texture is still loading.
+        auto idle() const -> bool;
+        auto report() const -> void;
+    };
+
+    inline TextureLoader::TextureLoader(const uint32_t max_workers, const size_t staging_size):
+        staging_ { staging_size },
+        cooked_formats_ { detail::cooked_formats() } {
+        // a magenta and black checkerboard, hard to mistake for a real texture
+        constexpr std::array<uint8_t, 12> checkerboard {
+            255, 0, 255,
+            0, 0, 0,
+            0, 0, 0,
+            255, 0, 255,
+        };
+        glGenTextures(1, &this->placeholder_id_);
+        glBindTexture(GL_TEXTURE_2D, this->placeholder_id_);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(
+            GL_TEXTURE_2D,
+            0,
+            GL_RGB,
+            2,
+            2,
+            0,
+            GL_RGB,
+            GL_UNSIGNED_BYTE,
+            checkerboard.data()
+        );
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        const auto worker_count = std::clamp(std::thread::hardware_concurrency(), 1U, max_workers);
+        for (uint32_t i = 0; i < worker_count; ++i) {
+            this->workers_.emplace_back([this] { this->run(); });
+        }
+    }
+
+    inline TextureLoader::~TextureLoader() {
+        {
+            const std::lock_guard lock { this->mutex_ };
+            this->stopping_ = true;
+        }
+        this->wake_.notify_all();
+        for (auto& worker : this->workers_) {
+            worker.join();
+        }
+    }
+
+    inline auto TextureLoader::request(TextureRequest request) -> TextureHandle {
+        const auto handle = static_cast<TextureHandle>(this->textures_.size());
+        if (this->textures_.empty()) {
+            this->first_request_ = std::chrono::steady_clock::now();
+        }
+        this->textures_.push_back(detail::Texture { request });
+        {
+            const std::lock_guard lock { this->mutex_ };
+            this->work_.push_back(detail::Job { handle, std::move(request) });
+        }
+        this->wake_.notify_one();
+        return handle;
+    }
+
+    inline auto TextureLoader::run() -> void {
+        PROFILE_THREAD("texture decoder");
+        // stb_image's JPEG settings are per thread, so benchmarks elsewhere never change them
+        // under a decode, and the hook goes away with the worker
+        stbi_set_jpeg_parallel_for(jpeg_parallel_for, this);
+        while (true) {
+            detail::Job job;
+            {
+                std::unique_lock lock { this->mutex_ };
+                this->wake_.wait(lock, [this] {
+                    return this->stopping_ || !this->work_.empty() || !this->batches_.empty();
+                });
+                if (this->stopping_) {
+                    stbi_set_jpeg_parallel_for(nullptr, nullptr);
+                    return;
+                }
+                if (!this->batches_.empty()) {
+                    // another worker's decode is waiting on these
+                    this->run_tasks(*this->batches_.front(), lock);
+                    continue;
+                }
+                job = std::move(this->work_.front());
+                this->work_.pop_front();
+            }
+
+            const auto start = std::chrono::steady_clock::now();
+            if (job.step == detail::Step::read_header) {
+                job.failed = !detail::read_header(job, this->cooked_formats_);
+                job.step = job.failed ? detail::Step::upload : detail::Step::decode;
+                job.stats.read_time = std::chrono::steady_clock::now() - start;
+            } else {
+                job.failed = !detail::decode(job);
+                // unstaged cooked levels are uploaded from the mapping
+                if (!job.cooked.has_value() || job.staging.has_value()) {
+                    job.file.reset();
+                }
+                job.step = detail::Step::upload;
+                job.stats.decode_time = std::chrono::steady_clock::now() - start;
+            }
+
+            const std::lock_guard lock { this->mutex_ };
+            this->finished_.push_back(std::move(job));
+        }
+    }
+
+    inline auto TextureLoader::run_tasks(
+        detail::TaskBatch& batch,
+        std::unique_lock<std::mutex>& lock
+    ) -> void {
+        while (batch.next < batch.count) {
+            const auto index = batch.next++;
+            if (batch.next == batch.count) {
+                this->batches_.erase(
+                    std::find(this->batches_.begin(), this->batches_.end(), &batch)
+                );
+            }
+            lock.unlock();
+            batch.task(batch.context, index);
+            lock.lock();
+            if (++batch.done == batch.count) {
+                this->batch_done_.notify_all();
+            }
+        }
+    }
+
+    inline auto TextureLoader::jpeg_parallel_for(
+        void* const loader,
+        const int count,
+        void (*const task)(void* context, int index),
+        void* const context
+    ) -> void {
+        if (count <= 0) {
+            return;
+        }
+        auto& self = *static_cast<TextureLoader*>(loader);
+        detail::TaskBatch batch { task, context, count };
+        std::unique_lock lock { self.mutex_ };
+        self.batches_.push_back(&batch);
+        self.wake_.notify_all();
+        self.run_tasks(batch, lock);
+        // the tasks other workers took may still be running
+        self.batch_done_.wait(lock, [&batch] { return batch.done == batch.count; });
+    }
+
+    inline auto TextureLoader::stage(detail::Job& job) -> bool {
+        // orphaned storage cannot stay mapped while other uploads read from it, those decode
+        // into memory of their own and are copied into the ring when they are uploaded
+        const auto size = detail::payload_size(job);
+        if (!this->staging_.persistent() || size > this->staging_.capacity()) {
+            return true;
+        }
+        job.staging = this->staging_.allocate(size);
+        return job.staging.has_value();
+    }
+
+    inline auto TextureLoader::upload(detail::Job& job) -> void {
+        auto& texture = this->textures_[job.handle];
+        texture.stats = job.stats;
+        if (job.failed) {
+            if (job.staging.has_value()) {
+                // releases the reservation with the next fence
+                this->staging_.commit(*job.staging);
+            }
+            texture.state = TextureState::failed;
+            return;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        const auto& request = texture.request;
+        glGenTextures(1, &texture.texture_id);
+        glBindTexture(GL_TEXTURE_2D, texture.texture_id);
+        if (job.cooked.has_value()) {
+            this->upload_cooked(job);
+        } else {
+            this->upload_decoded(job, request);
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, request.wrap);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, request.wrap);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, request.min_filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, request.mag_filter);
+
+        texture.stats = job.stats;
+        texture.stats.upload_time = std::chrono::steady_clock::now() - start;
+        texture.state = TextureState::resident;
+    }
+
+    inline auto TextureLoader::upload_decoded(detail::Job& job, const TextureRequest& request)
+        -> void {
+        auto& stats = job.stats;
+        const auto format = detail::format_of(stats.channels);
+        const auto internal_format = request.internal_format != 0
+            ? request.internal_format
+            : static_cast<GLint>(format);
+        // rows of one and three channel images are not 4 byte aligned
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        const auto size = static_cast<size_t>(stats.width)
+            * static_cast<size_t>(stats.height)
+            * static_cast<size_t>(stats.channels);
+        const void* pixels = job.pixels;
+        if (job.staging.has_value()) {
+            this->staging_.commit(*job.staging);
+            pixels = reinterpret_cast<const void*>(job.staging->offset);
+        } else if (const auto allocation = this->staging_.allocate(size)) {
+            std::memcpy(allocation->data, job.pixels, size);
+            this->staging_.commit(*allocation);
+            pixels = reinterpret_cast<const void*>(allocation->offset);
+        }
+        // anything else is too big for the ring and uploaded from client memory
+        {
+            PROFILE_ZONE("glTexImage2D");
+            glTexImage2D(
+                GL_TEXTURE_2D,
+                0,
+                internal_format,
+                stats.width,
+                stats.height,
+                0,
+                format,
+                GL_UNSIGNED_BYTE,
+                pixels
+            );
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        job.buffer = {};
+        job.pixels = nullptr;
+        {
+            PROFILE_ZONE("glGenerateMipmap");
+            glGenerateMipmap(GL_TEXTURE_2D);
+        }
+
+        const auto pixel_bytes = detail::bytes_per_pixel(internal_format, stats.channels);
+        auto width = static_cast<uint64_t>(stats.width);
+        auto height = static_cast<uint64_t>(stats.height);
+        stats.levels = 0;
+        stats.upload_bytes = size;
+        stats.texture_bytes = 0;
+        while (true) {
+            ++stats.levels;
+            stats.texture_bytes += width * height * pixel_bytes;
+            if (width == 1 && height == 1) {
+                break;
+            }
+            width = std::max(width / 2, uint64_t { 1 });
+            height = std::max(height / 2, uint64_t { 1 });
+        }
+    }
+
+    inline auto TextureLoader::upload_cooked(detail::Job& job) -> void {
+        const auto& cooked = *job.cooked;
+        const auto size = detail::payload_size(job);
+        // levels sit back to back from `offset` in the ring, or in the mapping when not staged
+        std::optional<size_t> offset {};
+        if (job.staging.has_value()) {
+            this->staging_.commit(*job.staging);
+            offset = job.staging->offset;
+        } else if (const auto allocation = this->staging_.allocate(size)) {
+            auto* const output = static_cast<uint8_t*>(allocation->data);
+            size_t copied = 0;
+            for (const auto& level : cooked.levels) {
+                std::memcpy(output + copied, level.data, level.size);
+                copied += level.size;
+            }
+            this->staging_.commit(*allocation);
+            offset = allocation->offset;
+        }
+
+        // every level is allocated at once and can never be redefined, so the driver does not
+        // have to check the texture is complete each time it is sampled
+        const auto& extensions = gl_extensions::get();
+        const auto immutable = extensions.texture_storage;
+        if (immutable) {
+            const auto& largest = cooked.levels.front();
+            extensions.glTexStorage2D(
+                GL_TEXTURE_2D,
+                static_cast<GLsizei>(cooked.levels.size()),
+                cooked.internal_format,
+                static_cast<GLsizei>(largest.width),
+                static_cast<GLsizei>(largest.height)
+            );
+        }
+        {
+            PROFILE_ZONE("upload cooked levels");
+            size_t level_offset = 0;
+            for (size_t i = 0; i < cooked.levels.size(); ++i) {
+                const auto& level = cooked.levels[i];
+                const void* data = offset.has_value()
+                    ? reinterpret_cast<const void*>(*offset + level_offset)
+                    : level.data;
+                const auto index = static_cast<GLint>(i);
+                const auto width = static_cast<GLsizei>(level.width);
+                const auto height = static_cast<GLsizei>(level.height);
+                const auto compressed = cooked.type == 0;
+                if (immutable && compressed) {
+                    glCompressedTexSubImage2D(
+                        GL_TEXTURE_2D,
+                        index,
+                        0,
+                        0,
+                        width,
+                        height,
+                        cooked.internal_format,
+                        static_cast<GLsizei>(level.size),
+                        data
+                    );
+                } else if (immutable) {
+                    glTexSubImage2D(
+                        GL_TEXTURE_2D,
+                        index,
+                        0,
+                        0,
+                        width,
+                        height,
+                        cooked.format,
+                        cooked.type,
+                        data
+                    );
+                } else if (compressed) {
+                    glCompressedTexImage2D(
+                        GL_TEXTURE_2D,
+                        index,
+                        cooked.internal_format,
+                        width,
+                        height,
+                        0,
+                        static_cast<GLsizei>(level.size),
+                        data
+                    );
+                } else {
+                    glTexImage2D(
+                        GL_TEXTURE_2D,
+                        index,
+                        static_cast<GLint>(cooked.internal_format),
+                        width,
+                        height,
+                        0,
+                        cooked.format,
+                        cooked.type,
+                        data
+                    );
+                }
+                level_offset += level.size;
+            }
+        }
+        // a file cooked without the smallest levels is still complete
+        glTexParameteri(
+            GL_TEXTURE_2D,
+            GL_TEXTURE_MAX_LEVEL,
+            static_cast<GLint>(cooked.levels.size()) - 1
+        );
+        job.stats.upload_bytes = size;
+        job.stats.texture_bytes = size;
+        job.cooked.reset();
+        job.file.reset();
+    }
+
+    inline auto TextureLoader::poll() -> uint32_t {
+        this->staging_.begin_frame();
+        std::vector<detail::Job> finished;
+        {
+            const std::lock_guard lock { this->mutex_ };
+            finished.swap(this->finished_);
+        }
+
+        // uploads first, they commit reservations the waiting headers may need
+        uint32_t uploaded = 0;
+        for (auto& job : finished) {
+            if (job.step == detail::Step::upload) {
+                this->upload(job);
+                ++uploaded;
+            } else {
+                this->waiting_.push_back(std::move(job));
+            }
+        }
+        this->staging_.fence();
+
+        std::vector<detail::Job> staged;
+        auto job = this->waiting_.begin();
+        while (job != this->waiting_.end() && this->stage(*job)) {
+            staged.push_back(std::move(*job));
+            ++job;
+        }
+        this->waiting_.erase(this->waiting_.begin(), job);
+        if (!staged.empty()) {
+            {
+                const std::lock_guard lock { this->mutex_ };
+                // ahead of the headers still to read, so memory is not held reserved for long
+                for (auto& staged_job : staged) {
+                    this->work_.push_front(std::move(staged_job));
+                }
+            }
+            this->wake_.notify_all();
+        }
+
+        if (0 != uploaded) {
+            this->last_upload_ = std::chrono::steady_clock::now();
+        }
+        return uploaded;
+    }
+
+    inline auto TextureLoader::texture(const TextureHandle handle) const -> uint32_t {
+        const auto& texture = this->textures_[handle];
+        return texture.state == TextureState::resident ? texture.texture_id : this->placeholder_id_;
+    }
+
+    inline auto TextureLoader::state(const TextureHandle handle) const -> TextureState {
+        return this->textures_[handle].state;
+    }
+
+    inline auto TextureLoader::stats(const TextureHandle handle) const -> const TextureStats& {
+        return this->textures_[handle].stats;
+    }
+
+    inline auto TextureLoader::staging() const -> const staging_ring::StagingRing& {
+        return this->staging_;
+    }
+
+    inline auto TextureLoader::idle() const -> bool {
+        return std::none_of(
+            this->textures_.begin(),
+            this->textures_.end(),
+            [](const detail::Texture& texture) { return texture.state == TextureState::loading; }
+        );
+    }
+
+    inline auto TextureLoader::report() const -> void {
+        using milliseconds = std::chrono::duration<double, std::milli>;
+        std::chrono::nanoseconds read_time { 0 };
+        std::chrono::nanoseconds decode_time { 0 };
+        std::chrono::nanoseconds upload_time { 0 };
+        uint64_t upload_bytes = 0;
+        uint64_t texture_bytes = 0;
+        for (const auto& texture : this->textures_) {
+            const auto& stats = texture.stats;
+            read_time += stats.read_time;
+            decode_time += stats.decode_time;
+            upload_time += stats.upload_time;
+            upload_bytes += stats.upload_bytes;
+            texture_bytes += stats.texture_bytes;
+            const auto compressed = block_compression::from_internal_format(
+                stats.cooked_format
+            );
+            const auto* const source = compressed.has_value()
+                ? block_compression::info(*compressed).name
+                : stats.cooked_format != 0 ? ktx_file::rgba8_name.data() : "decoded";
+            std::cout << "texture " << texture.request.path << ": " << stats.width << "x"
+                << stats.height << "x" << stats.channels << " " << source << ", "
+                << stats.levels << " levels, " << stats.upload_bytes << " bytes uploaded, "
+                << stats.texture_bytes << " bytes resident, read "
+                << milliseconds { stats.read_time }.count() << " ms, decoded "
+                << milliseconds { stats.decode_time }.count() << " ms, uploaded "
+                << milliseconds { stats.upload_time }.count() << " ms" << '\n';
+        }
+        std::cout << "textures: " << this->textures_.size() << " on " << this->workers_.size()
+            << " workers, " << milliseconds { read_time }.count() << " ms reading, "
+            << milliseconds { decode_time }.count() << " ms decoding, "
+            << milliseconds { upload_time }.count() << " ms uploading, " << upload_bytes
+            << " bytes uploaded, " << texture_bytes << " bytes resident, "
+            << milliseconds { this->last_upload_ - this->first_request_ }.count()
+            << " ms from first request to last upload" << '\n';
+        const auto& staged = this->staging_.total();
+        const auto* const mode = this->staging_.persistent() ? "persistent" : "orphaned";
+        const auto in_place = std::count_if(
+            this->textures_.begin(),
+            this->textures_.end(),
+            [](const detail::Texture& texture) { return texture.stats.decoded_in_place; }
+        );
+        std::cout << "texture staging: " << mode << ", " << staged.bytes << " bytes in "
+            << staged.allocations << " uploads, " << in_place << " decoded in place, "
+            << milliseconds { staged.fence_wait }.count() << " ms waiting on fences" << '\n';
+    }
+} // namespace texture_loader
+
+#endif
@@ -0,0 +1,246 @@
+#pragma once
+
+#ifndef UNIFORM_BLOCK_H
+#define UNIFORM_BLOCK_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <glad/glad.h>
+#include <initializer_list>
+
+// Mirrors of the GLSL types, laid out the way std140 and std430 expect them.
+namespace uniform_block {
+    struct alignas(8) vec2 {
+        float x, y;
+    };
+
+    // std140 lets a scalar share the last four bytes of a vec3, a C++ struct cannot; the layout
+    // checks below reject blocks that rely on it
+    struct alignas(16) vec3 {
+        float x, y, z;
+    };
+
+    struct alignas(16) vec4 {
+        float x, y, z, w;
+    };
+
+    struct alignas(16) ivec4 {
+        int32_t x, y, z, w;
+    };
+
+    // column major, like GLSL
+    struct alignas(16) mat4 {
+        std::array<vec4, 4> columns;
+    };
+
+    // Array element padded to the 16 byte stride std140 gives every array, e.g.
+    // std::array<padded<float>, 8> for `float values[8]`. Only std140 blocks take it for types
+    // smaller than a vec4.
+    template <typename T>
+    struct alignas(16) padded {
+        T value;
+    };
+
+    enum class Rules {
+        std140,
+        std430,
+    };
+
+    namespace detail {
+        constexpr auto align_up(const size_t value, const size_t alignment) -> size_t {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        struct TypeLayout {
+            size_t alignment;
+            size_t size;
+            // false when the C++ type's own size disagrees with what GLSL expects
+            bool representable;
+        };
+
+        template <typename T>
+        struct Describe;
+
+        template <typename T, size_t Alignment, size_t Size>
+        struct Fixed {
+            static constexpr auto layout(Rules /*rules*/) -> TypeLayout {
+                return TypeLayout { Alignment, Size, sizeof(T) >= Size };
+            }
+        };
+
+        template <>
+        struct Describe<float>: Fixed<float, 4, 4> {};
+        template <>
+        struct Describe<int32_t>: Fixed<int32_t, 4, 4> {};
+        template <>
+        struct Describe<uint32_t>: Fixed<uint32_t, 4, 4> {};
+        template <>
+        struct Describe<vec2>: Fixed<vec2, 8, 8> {};
+        template <>
+        struct Describe<vec3>: Fixed<vec3, 16, 12> {};
+        template <>
+        struct Describe<vec4>: Fixed<vec4, 16, 16> {};
+        template <>
+        struct Describe<ivec4>: Fixed<ivec4, 16, 16> {};
+        template <>
+        struct Describe<mat4>: Fixed<mat4, 16, 64> {};
+
+        template <typename T>
+        struct Describe<padded<T>> {
+            static constexpr auto layout(const Rules rules) -> TypeLayout {
+                const auto inner = Describe<T>::layout(rules);
+                if (rules == Rules::std430) {
+                    // std430 does not pad array elements, so the padding only fits types that
+                    // are 16 bytes already
+                    return TypeLayout {
+                        inner.alignment,
+                        inner.size,
+                        inner.representable && sizeof(padded<T>) == inner.size,
+                    };
+                }
+                return TypeLayout {
+                    align_up(inner.alignment, 16),
+                    align_up(inner.size, 16),
+                    inner.representable && sizeof(padded<T>) == align_up(inner.size, 16),
+                };
+            }
+        };
+
+        template <typename T, size_t N>
+        struct Describe<std::array<T, N>> {
+            static constexpr auto layout(const Rules rules) -> TypeLayout {
+                const auto element = Describe<T>::layout(rules);
+                const auto alignment = rules == Rules::std140
+                    ? align_up(element.alignment, 16)
+                    : element.alignment;
+                const auto stride = align_up(element.size, alignment);
+                return TypeLayout {
+                    alignment,
+                    stride * N,
+                    element.representable && sizeof(T) == stride,
+                };
+            }
+        };
+    } // namespace detail
+
+    struct Member {
+        size_t offset;
+        detail::TypeLayout std140;
+        detail::TypeLayout std430;
+    };
+
+    template <typename T>
+    constexpr auto describe(const size_t offset) -> Member {
+        return Member {
+            offset,
+            detail::Describe<T>::layout(Rules::std140),
+            detail::Describe<T>::layout(Rules::std430),
+        };
+    }
+
+    // Size of the block the GLSL compiler derives from `members`, listed in declaration order.
+    constexpr auto layout_size(const Rules rules, const std::initializer_list<Member> members)
+        -> size_t {
+        size_t offset = 0;
+        // std140 rounds structures up to a vec4, std430 only to their largest member
+        size_t block_alignment = rules == Rules::std140 ? 16 : 1;
+        for (const auto& member : members) {
+            const auto& layout = rules == Rules::std140 ? member.std140 : member.std430;
+            offset = detail::align_up(offset, layout.alignment) + layout.size;
+            block_alignment = std::max(block_alignment, layout.alignment);
+        }
+        return detail::align_up(offset, block_alignment);
+    }
+
+    // True when every member sits at the offset the GLSL compiler gives it under `rules`.
+    template <typename Block>
+    constexpr auto matches(const Rules rules, const std::initializer_list<Member> members)
+        -> bool {
+        size_t offset = 0;
+        for (const auto& member : members) {
+            const auto& layout = rules == Rules::std140 ? member.std140 : member.std430;
+            offset = detail::align_up(offset, layout.alignment);
+            if (!layout.representable || member.offset != offset) {
+                return false;
+            }
+            offset += layout.size;
+        }
+        return sizeof(Block) >= layout_size(rules, members);
+    }
+
+    // Uniform buffer holding one `Block`, bound to a fixed binding point.
+    template <typename Block>
+    class UniformBuffer {
+        uint32_t buffer_id_ { 0 };
+        uint32_t binding_;
+
+    public:
+        explicit UniformBuffer(uint32_t binding);
+        ~UniformBuffer();
+
+        UniformBuffer(const UniformBuffer&) = delete;
+        auto operator=(const UniformBuffer&) -> UniformBuffer& = delete;
+
+        auto binding() const -> uint32_t;
+        // One glBufferSubData for the whole block.
+        auto upload(const Block& block) const -> void;
+        // Lets `fill` write the block straight into mapped memory. The previous contents are
+        // invalidated, so the driver can hand out fresh memory instead of waiting on the GPU.
+        template <typename Fill>
+        auto write(Fill&& fill) const -> bool;
+    };
+
+    template <typename Block>
+    UniformBuffer<Block>::UniformBuffer(const uint32_t binding):
+        binding_ { binding } {
+        glGenBuffers(1, &this->buffer_id_);
+        glBindBuffer(GL_UNIFORM_BUFFER, this->buffer_id_);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(Block), nullptr, GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_UNIFORM_BUFFER, this->binding_, this->buffer_id_);
+    }
+
+    template <typename Block>
+    UniformBuffer<Block>::~UniformBuffer() {
+        glDeleteBuffers(1, &this->buffer_id_);
+    }
+
+    template <typename Block>
+    auto UniformBuffer<Block>::binding() const -> uint32_t {
+        return this->binding_;
+    }
+
+    template <typename Block>
+    auto UniformBuffer<Block>::upload(const Block& block) const -> void {
+        glBindBuffer(GL_UNIFORM_BUFFER, this->buffer_id_);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Block), &block);
+    }
+
+    template <typename Block>
+    template <typename Fill>
+    auto UniformBuffer<Block>::write(Fill&& fill) const -> bool {
+        glBindBuffer(GL_UNIFORM_BUFFER, this->buffer_id_);
+        auto* const mapped = glMapBufferRange(
+            GL_UNIFORM_BUFFER,
+            0,
+            sizeof(Block),
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT
+        );
+        if (mapped == nullptr) {
+            return false;
+        }
+        fill(*static_cast<Block*>(mapped));
+        return GL_TRUE == glUnmapBuffer(GL_UNIFORM_BUFFER);
+    }
+} // namespace uniform_block
+
+// Describes `member` of `block` for uniform_block::matches, e.g.
+//     static_assert(uniform_block::matches<Frame>(uniform_block::Rules::std140, {
+//         UNIFORM_BLOCK_MEMBER(Frame, view),
+//         UNIFORM_BLOCK_MEMBER(Frame, time),
+//     }));
+#define UNIFORM_BLOCK_MEMBER(block, member) \
+    ::uniform_block::describe<decltype(block::member)>(offsetof(block, member))
+
+#endif